@@ -1,557 +1,473 @@
-/** SIM900 Basic communication library for SIM900 gsm module. 
- *
- *	This library provide easy way to make GET and POST petitions to a web server. Use to interactue Arduino with restful apis, webs, etc.
- *
- *	Released under MIT license.		
- *
- *	@author	Miquel Vento (http://www.emevento.com)
- *	@version 1.0 24/03/2015
- *
- */
-#include "SIM900.h"
-
-
-Connection::Connection(	const char * pinCode, 
-						const char * apnName,  
-						const char * apnUser, 
-						const char * apnPass, 
-						const uint8_t & enablePin, 
-						HardwareSerial & serialPort,
-						uint32_t baudRate ):
-	_pinCode( pinCode ),
-	_apnName( apnName ),
-	_apnUser( apnUser ),
-	_apnPass( apnPass ),
-	_enablePin( enablePin ),
-	CREG_WAITING_RETRIES( 80 ),
-	SAPBR_WAITING_RETRIES( 5 ),
-	CGATT_WAITING_RETRIES( 30 ),
-	MAX_ATRESPONSE(160)
-{
-	pinMode( enablePin, OUTPUT );
-	
-		
-	sim900Serial = &serialPort;
-	sim900Serial->begin( baudRate );
-}
-
-
-bool Connection::Configuration() 
-{	
-	if ( !sim900Serial )					
-		return false;
-		
-	if ( !IsPowered() )		
-		PowerOn();
-	
-	if ( !AT_CPIN() )
-		return false;
-	
-	if ( !AT_CREG() )
-		return false;	
-			
-	if ( !OpenBearer() )
-		return false;
-	
-	return true;
-}
-
-
-bool Connection::Get(	const char * host, 
-						const char * path, 
-						const char * url, 
-						uint16_t & headerHttpReply, 
-						char *& bodyReply, 
-						const int port )
-{
-	
-	if ( !sim900Serial )
-		return false;
-		
-	if ( !IsBearerOpen() )
-		if ( !Configuration() )
-			return false;
-	
-	
-	if ( SendATcommand( "AT+HTTPINIT", "OK", "ERROR", 3000) != 1 )
-	{
-		SendATcommand( "AT+HTTPTERM", "OK", 1000 );
-		if ( SendATcommand( "AT+HTTPINIT", "OK", "ERROR", 3000) != 1 )
-			return false;
-	}
-
-	if ( SendATcommand("AT+HTTPPARA=\"CID\",1", "OK", 5000) != 1 )
-		return false;
-	
-	if ( AT_HTTPPARA_URL( host, path, url ) )
-	{
-		if ( AT_HTTPACTION_GET( headerHttpReply ) && headerHttpReply > 0 && headerHttpReply < 600 )
-		{
-			delay(1000);
-			if ( SendATcommand( "AT+HTTPREAD=0,100", "+HTTPREAD:", "ERROR", 30000 ) == 1 )
-			{
-				ReceiveData( bodyReply, 15000 );
-				SendATcommand( "AT+HTTPTERM", "OK", 500 );
-				return true;
-			}
-			
-		}
-	}
-	
-	return false;
-}
-
-
-bool Connection::Post(	const char * host, 
-						const char * path, 
-						const char * url, 
-						const char * data, 
-						uint16_t & headerHttpReply, 
-						const int port )
-{
-	if ( !sim900Serial )
-		return false;
-		
-	if ( !OpenBearer() )
-		if ( !Configuration() )
-			return false;
-
-	if ( SendATcommand( "AT+HTTPINIT", "OK", "ERROR", 3000) != 1 )
-	{
-		SendATcommand( "AT+HTTPTERM", "OK", 1000 );
-		if ( SendATcommand( "AT+HTTPINIT", "OK", "ERROR", 3000) != 1 )
-			return false;
-	}
-
-	if ( SendATcommand("AT+HTTPPARA=\"CID\",1", "OK", 5000) != 1 )
-		return false;
-
-	if ( AT_HTTPDATA(strlen(data), 20000 ) )
-	{
-		if ( SendATcommand( data, "OK", 10000 ) )
-		{
-			if ( AT_HTTPPARA_URL( host, path, url ) )
-			{
-				if ( AT_HTTPACTION_POST( headerHttpReply ) )
-				{
-					SendATcommand( "AT+HTTPTERM", "OK", 500 );
-					return true;
-				}
-			}
-		}
-	}
-
-	return false;
-}
-
-
-void Connection::PowerOn()
-{	
-	digitalWrite( _enablePin, HIGH );
-	delay( 1200 );
-	digitalWrite( _enablePin, LOW );
-	// Is necessary to wait because SIM900 sends data garbage through Serial.
-	delay( 2000 );
-}
-
-
-void Connection::PowerOff()
-{
-	SendATcommand("ATE0", "", 1000 );
-}
-
-
-bool Connection::IsPowered()
-{
-	if ( SendATcommand("AT", "OK", 200 ) > 0 )
-		return true;
-	else
-		return false;
-}
-	
-
-void Connection::EchoOn( )
-{
-	SendATcommand("ATE1", "OK", 1000 );
-}
-
-
-void Connection::EchoOff( )
-{
-	 sim900Serial->println( "ATE0" );
-}
-
-
-bool Connection::AT_CPIN()
-{
-	int answer = SendATcommand( "AT+CPIN?", "READY", "SIM PIN", 500 );
-	
-	if ( answer == 1 )
-	{
-		return true;
-	}
-	else if ( answer == 2 )
-	{
-		CleanSerialBuffer();
-		sim900Serial->print("AT+CPIN=\"");
-		sim900Serial->print( _pinCode );
-		sim900Serial->println( "\"" );	
-	}
-	
-	return ReceiveATReply( "OK", 2000 );	
-}
-
-
-bool Connection::AT_CREG()
-{
-	int errorCount;
-	const int totalAnswers  = 5;
-	const char * expectedAnswers[totalAnswers] = { "+CREG: 0,0", "+CREG: 0,2", "+CREG: 0,4", "+CREG: 0,1","+CREG: 0,5" };
-				
-		
-	for ( errorCount = CREG_WAITING_RETRIES; errorCount ; errorCount-- )
-	{
-		int answer = SendATcommand( "AT+CREG?", expectedAnswers, totalAnswers, 2000 );
-		if ( answer >= 4  )
-			return true;
-		else if ( answer == 0 )
-			return false;						
-							
-		delay( 1000 );
-	}
-			
-	return false;
-}
-
-
-bool Connection::IsBearerOpen()
-{
-	if ( SendATcommand( "AT+SAPBR=2,1", "1,1", "1,3", 2000 ) == 1 )
-		return true;
-	
-	return false;
-}
-
-
-bool Connection::OpenBearer()
-{	
-	uint8_t errorCount;
-	
-	if ( IsBearerOpen() )
-		return true;
-	
-	// Waiting for GPRS Attachment
-	for ( unsigned int i = CGATT_WAITING_RETRIES; i > 0; i-- )
-	{
-		if ( SendATcommand("AT+CGATT?", ": 0", ": 1", 1000 ) == 2 )
-			break;
-		delay( 1000 );
-	}
-	
-	// Open Bearer
-	if ( SendATcommand( "AT+SAPBR=1,1", "OK", "ERROR", 3000 )  == 2 )
-		return false;
-	
-	// Wait for open the bearer										
-	for ( errorCount = SAPBR_WAITING_RETRIES; errorCount > 0; errorCount-- )
-	{
-		if ( SendATcommand( "AT+SAPBR=2,1", "1,1", "1,3", 2000 ) == 1 )
-			break;
-		delay( 1000 );
-	}
-	
-	if ( !errorCount )
-		return false;
-	else
-		return true;
-}
-
-
-bool Connection::UpdateBearerInfo()
-{
-	// GPRS connection
-	SendATcommand( "AT+SAPBR=3,1,\"Contype\",\"GPRS\"", "OK", 500 );
-	
-	// Set APN Name
-	CleanSerialBuffer();
-	sim900Serial->print( "AT+SAPBR=3,1,\"APN\",\"" );
-	sim900Serial->print( _apnName );
-	sim900Serial->println( "\"" );
-	if ( !ReceiveATReply( "OK", 500 ) )
-		return false;	
-	
-	// Set APN User
-	CleanSerialBuffer();
-	sim900Serial->print( "AT+SAPBR=3,1,\"USER\",\"" );
-	sim900Serial->print( _apnUser );
-	sim900Serial->println( "\"" );
-	if ( !ReceiveATReply( "OK", 500 ) )
-		return false;	
-	
-	// Set APN Passwd
-	CleanSerialBuffer();
-	sim900Serial->print( "AT+SAPBR=3,1,\"PWD\",\"" );
-	sim900Serial->print( _apnPass );
-	sim900Serial->println( "\"" );
-	if ( !ReceiveATReply( "OK", 500 ) )
-		return false;
-		
-	// Save APN Info in NVRAM
-	return SendATcommand( "AT+SAPBR=5,1", "OK", 500 );
-}
-
-
-bool Connection::AT_HTTPACTION_GET( uint16_t & httpHeader )
-{
-	sim900Serial->println("AT+HTTPACTION=0");
-		
-	return GetHttpHeader( "+HTTPACTION:0,", httpHeader, 10000 );
-}
-
-
-bool Connection::AT_HTTPACTION_POST( uint16_t & httpHeader )
-{
-	sim900Serial->println("AT+HTTPACTION=1");
-	
-	return GetHttpHeader( "+HTTPACTION:1,", httpHeader, 10000 );
-}
-
-
-bool Connection::AT_HTTPDATA( 	const int & size, 
-								const int & timeout )
-{
-	CleanSerialBuffer();
-	sim900Serial->print( "AT+HTTPDATA=");
-	sim900Serial->print( size+2 );
-	sim900Serial->print( "," );
-	sim900Serial->println( timeout );
-	
-	return ReceiveATReply( "DOWNLOAD", 10000 );
-}
-
-
-bool Connection::AT_HTTPPARA_URL( 	const char * host, 
-									const char * path, 
-									const char * url )
-{
-	CleanSerialBuffer();
-	
-	sim900Serial->print( "AT+HTTPPARA=\"URL\",\"" );
-	sim900Serial->print( host );
-	sim900Serial->print( "/" );
-	sim900Serial->print( path );
-	sim900Serial->print( "/" );
-	sim900Serial->print( url );
-	sim900Serial->println( "\"" );
-	
-	return ReceiveATReply( "OK", 10000 );	
-}
-
-
-bool Connection::GetHttpHeader( const char * expected_answer, 
-								uint16_t & httpHeader, 
-								const uint16_t & timeout )
-{
-	uint32_t previousTime;
-	char nextChar;
-	
-	httpHeader = 0;
-
-	// this loop waits for the answer
-	previousTime = millis();
-	
-	if ( !ReceiveATReply( expected_answer, timeout ) )
-		return false;
-	
-	for( int i = 3; i > 0; i-- )
-	{	
-		if ( !WaitingSerialAvailable( previousTime,timeout ) )
-			return false;
-			
-		nextChar = sim900Serial->read();	
-		
-		// Convert char number to integer
-		httpHeader *= 10;
-		httpHeader += ( nextChar-0x30 );  // Converts ASCII character to integer
-	}
-	
-	return true;
-}
-
-
-bool Connection::TimeOut( 	const uint32_t & previousTime, 
-							const uint16_t & timeOut )
-{
-	if ( millis() - previousTime > timeOut )
-		return true;
-	
-	return false;
-}
-
- 
-uint16_t Connection::GetReceiveDataSize( const uint16_t & timeout )
-{
-	uint16_t dataSize = 0;
-	uint32_t previousTime = millis();
-	char nextChar;
-	
-	
-	if ( !WaitingSerialAvailable( previousTime, timeout ) )
-	{
-		return false;
-	}
-	
-	nextChar = sim900Serial->read();
-	
-	// Get Data Size
-	do
-	{
-		// Convert char number to integer
-		dataSize *= 10;
-		dataSize += ( nextChar-0x30 );  // Converts ASCII character to integer
-		
-		if ( !WaitingSerialAvailable( previousTime, timeout ) )
-			return false;
-			
-		nextChar = sim900Serial->read();
-	} while( nextChar != 0x0D );
-	
-
-	// Consume TR character
-	if ( sim900Serial->available() )
-		sim900Serial->read();
-
-	return dataSize;
-}
-
-
-bool Connection::WaitingSerialAvailable( 	const uint32_t & previousTime, 
-											const uint16_t & timeout )
-{
-	while( !sim900Serial->available() )
-	{
-		if ( TimeOut( previousTime, timeout ) )
-			return false;
-	}
-	return true;
-}
-
-
-bool Connection::ReceiveData( 	char *& bodyReply, 
-								const uint16_t & timeout )
-{
-	char nextChar;
-	uint8_t answerCount = 0;
-	uint16_t dataSize = 0;
-	uint32_t previousTime;
-	
-	previousTime = millis();
-	
-	dataSize = GetReceiveDataSize( 500 );
-	bodyReply = new char[dataSize+1];
-			
-	if ( dataSize > 0)
-	{
-		for ( int i = dataSize; i > 0; i-- )
-		{
-			if ( WaitingSerialAvailable( previousTime, timeout ) )
-				bodyReply[answerCount++] = sim900Serial->read();
-			else
-				return false;
-		}
-		
-		bodyReply[answerCount] = '\0';
-		return true;
-	}
-	else
-	{
-		return false;
-	}
-}
-
-
-void Connection::CleanSerialBuffer()
-{
-	while( sim900Serial->available() > 0)
-	{
-		sim900Serial->read();
-	}		
-}
-
-
-int8_t Connection::SendATcommand( 	const char* ATcommand, 
-									const char* expectedAnswer, 
-									const unsigned int & timeout )
-{	
-	const char * arrayAnswers[] = { expectedAnswer };
-		
-	return SendATcommand( ATcommand, arrayAnswers, 1, timeout );
-}
-
-
-int8_t Connection::SendATcommand(	const char* ATcommand, 
-									const char* expectedAnswer1, 
-									const char* expectedAnswer2, 
-									const unsigned int & timeout )
-{
-	const char * arrayAnswers[] = { expectedAnswer1, expectedAnswer2 };
-	
-	return SendATcommand( ATcommand, arrayAnswers, 2, timeout );						
-}
-
-
-int8_t Connection::SendATcommand(	const char* ATcommand,
-									const char ** expectedAnswers,
-									const int & totalAnwers,
-									const unsigned int & timeout )
-{
-	CleanSerialBuffer();
-	sim900Serial->println( ATcommand );
-
-	return ReceiveATReply( expectedAnswers, totalAnwers, timeout );
-}
-
-
-int8_t Connection::ReceiveATReply(	const char ** expectedAnswers,
-									const int & totalAnwers,
-									const unsigned int & timeout )
-{
-	uint8_t answerCount = 0;
-	char response[MAX_ATRESPONSE];
-	uint32_t previousTime;
-
-	memset( response, '\0', MAX_ATRESPONSE );
-	delay(100);
-
-	previousTime = millis();
-		
-	while( ( millis() - previousTime ) < timeout )
-	{
-		if( !WaitingSerialAvailable( previousTime, timeout ) )
-		{
-			return false;
-		}
-		
-		response[answerCount++] = sim900Serial->read();
-		
-		for ( int i = 0; i<totalAnwers; i++ )
-		{
-			if ( strstr( response, expectedAnswers[i] ) != NULL )
-			{
-				return i+1;
-			}
-		}
-
-	}
-
-	return 0;
-}
-
-
-int8_t Connection::ReceiveATReply(	const char * expectedAnswer,
-									const unsigned int & timeout )
-{
-	const char * expectedAnswers[] = { expectedAnswer };
-	
-	return ReceiveATReply( expectedAnswers, 1, timeout );
-}
+/** SIM900 Basic communication library for SIM900 gsm module. 
+ *
+ *	This library provide easy way to make GET and POST petitions to a web server. Use to interactue Arduino with restful apis, webs, etc.
+ *
+ *	Released under MIT license.		
+ *
+ *	@author	Miquel Vento (http://www.emevento.com)
+ *	@version 1.0 24/03/2015
+ *
+ */
+#include "SIM900.h"
+
+
+const char ConnectionBase::CREG_NOT_SEARCHING[] PROGMEM = "+CREG: 0,0";
+const char ConnectionBase::CREG_SEARCHING[] PROGMEM = "+CREG: 0,2";
+const char ConnectionBase::CREG_UNKNOWN[] PROGMEM = "+CREG: 0,4";
+const char ConnectionBase::CREG_HOME[] PROGMEM = "+CREG: 0,1";
+const char ConnectionBase::CREG_ROAMING[] PROGMEM = "+CREG: 0,5";
+
+const char ConnectionBase::URC_RING_PREFIX[] PROGMEM = "RING";
+const char ConnectionBase::URC_SMS_PREFIX[] PROGMEM = "+CMTI:";
+const char ConnectionBase::URC_SAPBR_DEACT_PREFIX[] PROGMEM = "+SAPBR 1: DEACT";
+const char ConnectionBase::URC_PDP_DEACT_PREFIX[] PROGMEM = "+PDP: DEACT";
+const char ConnectionBase::URC_CALL_READY_PREFIX[] PROGMEM = "Call Ready";
+const char ConnectionBase::URC_NORMAL_POWER_DOWN_PREFIX[] PROGMEM = "NORMAL POWER DOWN";
+const char ConnectionBase::URC_UNDER_VOLTAGE_PREFIX[] PROGMEM = "UNDER-VOLTAGE";
+const char ConnectionBase::URC_OVER_VOLTAGE_PREFIX[] PROGMEM = "OVER-VOLTAGE";
+const char ConnectionBase::URC_POWER_DOWN_SUFFIX[] PROGMEM = " POWER DOWN";
+
+const char ConnectionBase::BOOT_RDY[] PROGMEM = "RDY";
+const char ConnectionBase::BOOT_CPIN[] PROGMEM = "+CPIN:";
+const char ConnectionBase::BOOT_OK[] PROGMEM = "OK";
+
+const char ConnectionBase::SOCKET_RECEIVE_PREFIX[] PROGMEM = "+RECEIVE,";
+const char ConnectionBase::SOCKET_CLOSED_SUFFIX[] PROGMEM = ", CLOSED";
+
+// Errors of the module
+static const char ERROR_ANSWER[] PROGMEM = "ERROR";
+static const char CME_ERROR[] PROGMEM = "+CME ERROR";
+static const char CMS_ERROR[] PROGMEM = "+CMS ERROR";
+
+// Commands of every class, after "AT+"
+static const char COMMAND_CPIN[] PROGMEM = "CPIN";
+static const char COMMAND_CREG[] PROGMEM = "CREG";
+static const char COMMAND_CGATT[] PROGMEM = "CGATT";
+static const char COMMAND_SAPBR[] PROGMEM = "SAPBR";
+static const char COMMAND_HTTPINIT[] PROGMEM = "HTTPINIT";
+static const char COMMAND_HTTPPARA[] PROGMEM = "HTTPPARA";
+static const char COMMAND_HTTPDATA[] PROGMEM = "HTTPDATA";
+static const char COMMAND_HTTPACTION[] PROGMEM = "HTTPACTION";
+static const char COMMAND_HTTPREAD[] PROGMEM = "HTTPREAD";
+static const char COMMAND_HTTPHEAD[] PROGMEM = "HTTPHEAD";
+static const char COMMAND_HTTPTERM[] PROGMEM = "HTTPTERM";
+static const char COMMAND_CIP[] PROGMEM = "CIP";
+static const char COMMAND_CSTT[] PROGMEM = "CSTT";
+static const char COMMAND_CIICR[] PROGMEM = "CIICR";
+static const char COMMAND_CIFSR[] PROGMEM = "CIFSR";
+
+// Names of the classes for PrintCommandStats(), in CommandClass order
+static const char COMMAND_NAMES[] PROGMEM = "GENERAL SIM NETWORK BEARER HTTPINIT HTTPPARA HTTPDATA HTTPACTION HTTPREAD HTTPTERM SOCKET";
+
+const uint32_t ConnectionBase::BAUD_RATES[] PROGMEM = { 115200, 57600, 38400, 19200, 9600, 4800, 2400, 1200 };
+
+
+bool ConnectionBase::WriteToBuffer(	const char * chunk, 
+								uint16_t length, 
+								void * context )
+{
+	BufferSink * sink = (BufferSink *) context;
+	
+	// Keep counting the full body length when the buffer is full, to report truncation.
+	// It stops at 0xFFFF so a body of 64 KB or more doesn't wrap to a short one.
+	for ( uint16_t i = 0; i < length; i++ )
+	{
+		if ( sink->length + 1 < sink->size )
+		{
+			sink->buffer[sink->length] = chunk[i];
+			sink->buffer[sink->length+1] = '\0';
+		}
+		
+		if ( sink->length < 0xFFFF )
+			sink->length++;
+	}
+	
+	return true;
+}
+
+
+bool ConnectionBase::WriteToPrint(	const char * chunk, 
+								uint16_t length, 
+								void * context )
+{
+	Print * sink = (Print *) context;
+	
+	return sink->write( (const uint8_t *) chunk, length ) == length;
+}
+
+
+bool ConnectionBase::WriteToCache(	const char * chunk, 
+								uint16_t length, 
+								void * context )
+{
+	CacheTee * tee = (CacheTee *) context;
+	
+	tee->cache->Append( chunk, length );
+	return tee->callback( chunk, length, tee->context );
+}
+
+
+uint16_t ConnectionBase::ReadFromMemory(	char * buffer, 
+										uint16_t size, 
+										void * context )
+{
+	const char *& data = *(const char **) context;
+	
+	memcpy( buffer, data, size );
+	data += size;
+	
+	return size;
+}
+
+
+uint16_t ConnectionBase::ReadFromStream(	char * buffer, 
+										uint16_t size, 
+										void * context )
+{
+	Stream * source = (Stream *) context;
+	
+	return source->readBytes( buffer, size );
+}
+
+
+void ConnectionBase::BeginMatch(	AnswerMatcher & matcher,
+								const char * pattern,
+								const bool & inFlash )
+{
+	matcher.pattern = pattern;
+	matcher.inFlash = inFlash;
+	matcher.matched = 0;
+	matcher.length = 0;
+	
+	while ( matcher.length < 0xFF && PatternChar( pattern, matcher.length, inFlash ) != '\0' )
+		matcher.length++;
+}
+
+
+bool ConnectionBase::MatchNextChar(	AnswerMatcher & matcher,
+									const char & nextChar )
+{
+	if ( matcher.matched == matcher.length )
+		return true;
+	
+	matcher.matched = MatchNextChar( matcher.pattern, matcher.matched, nextChar, matcher.inFlash );
+	
+	return matcher.matched == matcher.length;
+}
+
+
+uint8_t ConnectionBase::MatchNextChar(	const char * pattern,
+									uint8_t matched,
+									const char & nextChar,
+									const bool & inFlash )
+{
+	char patternChar = PatternChar( pattern, matched, inFlash );
+	
+	if ( patternChar == '\0' )
+		return matched;
+	
+	if ( patternChar == nextChar )
+		return matched + 1;
+	
+	// Mismatch: fall back to the longest prefix of the pattern that is also
+	// a suffix of the received text (the matched chars plus nextChar).
+	for ( uint8_t k = matched; k > 0; k-- )
+	{
+		if ( PatternChar( pattern, k-1, inFlash ) != nextChar )
+			continue;
+		
+		uint8_t i = 0;
+		while ( i < k - 1 && PatternChar( pattern, i, inFlash ) == PatternChar( pattern, matched - k + 1 + i, inFlash ) )
+			i++;
+		
+		if ( i == k - 1 )
+			return k;
+	}
+	
+	return 0;
+}
+
+
+char ConnectionBase::PatternChar(	const char * pattern,
+								const uint8_t & position,
+								const bool & inFlash )
+{
+	if ( inFlash )
+		return pgm_read_byte( pattern + position );
+	
+	return pattern[position];
+}
+
+
+int8_t ConnectionBase::ClassifyUrc( const char * line )
+{
+	if ( LineStartsWith( line, URC_RING_PREFIX ) )
+		return URC_RING;
+	
+	if ( LineStartsWith( line, URC_SMS_PREFIX ) )
+		return URC_SMS;
+	
+	if ( LineStartsWith( line, URC_SAPBR_DEACT_PREFIX ) || LineStartsWith( line, URC_PDP_DEACT_PREFIX ) )
+		return URC_BEARER_DEACT;
+	
+	if ( LineStartsWith( line, URC_CALL_READY_PREFIX ) )
+		return URC_CALL_READY;
+	
+	// <link>, CLOSED
+	if ( line[0] >= '0' && line[0] < '0' + SOCKET_LINKS && LineStartsWith( line + 1, SOCKET_CLOSED_SUFFIX ) )
+		return URC_SOCKET_CLOSED;
+	
+	if ( LineStartsWith( line, URC_NORMAL_POWER_DOWN_PREFIX ) )
+		return URC_POWER_DOWN;
+	
+	// UNDER-VOLTAGE WARNNING or UNDER-VOLTAGE POWER DOWN, the same for OVER-VOLTAGE
+	if ( LineStartsWith( line, URC_UNDER_VOLTAGE_PREFIX ) )
+	{
+		if ( LineStartsWith( line + strlen_P( URC_UNDER_VOLTAGE_PREFIX ), URC_POWER_DOWN_SUFFIX ) )
+			return URC_POWER_DOWN;
+		return URC_UNDER_VOLTAGE;
+	}
+	
+	if ( LineStartsWith( line, URC_OVER_VOLTAGE_PREFIX ) )
+	{
+		if ( LineStartsWith( line + strlen_P( URC_OVER_VOLTAGE_PREFIX ), URC_POWER_DOWN_SUFFIX ) )
+			return URC_POWER_DOWN;
+		return URC_OVER_VOLTAGE;
+	}
+	
+	return -1;
+}
+
+
+bool ConnectionBase::LineStartsWith(	const char * line,
+									const char * prefix )
+{
+	for ( uint8_t i = 0; PatternChar( prefix, i, true ) != '\0'; i++ )
+	{
+		if ( line[i] != PatternChar( prefix, i, true ) )
+			return false;
+	}
+	
+	return true;
+}
+
+
+bool ConnectionBase::AddDigit(	uint32_t & number, 
+							const char & nextChar, 
+							const uint32_t & maximum )
+{
+	if ( nextChar < '0' || nextChar > '9' )
+		return false;
+	
+	uint8_t digit = nextChar - '0';
+	
+	if ( number > ( maximum - digit ) / 10 )
+		return false;
+	
+	number = number * 10 + digit;
+	return true;
+}
+
+
+bool ConnectionBase::IsErrorLine( const char * line )
+{
+	return LineStartsWith( line, ERROR_ANSWER ) || LineStartsWith( line, CME_ERROR ) || LineStartsWith( line, CMS_ERROR );
+}
+
+
+bool ConnectionBase::IsErrorAnswer(	const char * answer,
+									const bool & inFlash )
+{
+	for ( uint8_t i = 0; PatternChar( ERROR_ANSWER, i, true ) != '\0'; i++ )
+	{
+		if ( PatternChar( answer, i, inFlash ) != PatternChar( ERROR_ANSWER, i, true ) )
+			return false;
+	}
+	
+	return PatternChar( answer, strlen_P( ERROR_ANSWER ), inFlash ) == '\0';
+}
+
+
+ConnectionBase::CommandClass ConnectionBase::ClassifyCommand( const char * command )
+{
+	// Commands without + are general: AT, ATE0, AT&W
+	if ( command[0] != 'A' || command[1] != 'T' || command[2] != '+' )
+		return COMMAND_GENERAL;
+	
+	command += 3;
+	
+	if ( LineStartsWith( command, COMMAND_CPIN ) )
+		return COMMAND_SIM;
+	
+	if ( LineStartsWith( command, COMMAND_CREG ) || LineStartsWith( command, COMMAND_CGATT ) )
+		return COMMAND_NETWORK;
+	
+	if ( LineStartsWith( command, COMMAND_SAPBR ) )
+		return COMMAND_BEARER;
+	
+	if ( LineStartsWith( command, COMMAND_HTTPINIT ) )
+		return COMMAND_HTTP_INIT;
+	
+	if ( LineStartsWith( command, COMMAND_HTTPPARA ) )
+		return COMMAND_HTTP_PARA;
+	
+	if ( LineStartsWith( command, COMMAND_HTTPDATA ) )
+		return COMMAND_HTTP_DATA;
+	
+	if ( LineStartsWith( command, COMMAND_HTTPACTION ) )
+		return COMMAND_HTTP_ACTION;
+	
+	if ( LineStartsWith( command, COMMAND_HTTPREAD ) || LineStartsWith( command, COMMAND_HTTPHEAD ) )
+		return COMMAND_HTTP_READ;
+	
+	if ( LineStartsWith( command, COMMAND_HTTPTERM ) )
+		return COMMAND_HTTP_TERM;
+	
+	if ( LineStartsWith( command, COMMAND_CIP ) || LineStartsWith( command, COMMAND_CSTT ) || 
+		 LineStartsWith( command, COMMAND_CIICR ) || LineStartsWith( command, COMMAND_CIFSR ) )
+		return COMMAND_SOCKET;
+	
+	return COMMAND_GENERAL;
+}
+
+
+void ConnectionBase::PrintCommandStats(	Print & output, 
+									const CommandStats * stats )
+{
+	uint8_t name = 0;
+	
+	output.println( F("class calls replies timeouts errors retries min avg max out in") );
+	
+	for ( uint8_t i = 0; i < COMMAND_CLASSES; i++ )
+	{
+		const CommandStats & classStats = stats[i];
+		
+		if ( classStats.calls )
+		{
+			for ( uint8_t j = name; PatternChar( COMMAND_NAMES, j, true ) != ' ' && PatternChar( COMMAND_NAMES, j, true ) != '\0'; j++ )
+				output.print( PatternChar( COMMAND_NAMES, j, true ) );
+			
+			output.print( ' ' );
+			output.print( classStats.calls );
+			output.print( ' ' );
+			output.print( classStats.replies );
+			output.print( ' ' );
+			output.print( classStats.timeouts );
+			output.print( ' ' );
+			output.print( classStats.errors );
+			output.print( ' ' );
+			output.print( classStats.retries );
+			output.print( ' ' );
+			output.print( classStats.replies ? classStats.minLatency : 0 );
+			output.print( ' ' );
+			output.print( classStats.replies ? classStats.totalLatency / classStats.replies : 0 );
+			output.print( ' ' );
+			output.print( classStats.maxLatency );
+			output.print( ' ' );
+			output.print( classStats.bytesOut );
+			output.print( ' ' );
+			output.println( classStats.bytesIn );
+		}
+		
+		// Next name
+		while ( PatternChar( COMMAND_NAMES, name, true ) != ' ' && PatternChar( COMMAND_NAMES, name, true ) != '\0' )
+			name++;
+		name++;
+	}
+}
+
+
+ConnectionBase::SerialMeter::SerialMeter():
+	stream( NULL ),
+	stats( NULL ),
+	commandClass( COMMAND_GENERAL ),
+	newCommand( false ),
+	afterData( false ),
+	_lineLength( 0 )
+{
+}
+
+
+int ConnectionBase::SerialMeter::available()
+{
+	return stream->available();
+}
+
+
+int ConnectionBase::SerialMeter::read()
+{
+	int nextChar = stream->read();
+	
+	if ( nextChar >= 0 && stats )
+		stats[commandClass].bytesIn++;
+	
+	return nextChar;
+}
+
+
+int ConnectionBase::SerialMeter::peek()
+{
+	return stream->peek();
+}
+
+
+void ConnectionBase::SerialMeter::flush()
+{
+	stream->flush();
+}
+
+
+size_t ConnectionBase::SerialMeter::write( uint8_t nextChar )
+{
+	return write( &nextChar, 1 );
+}
+
+
+void ConnectionBase::SerialMeter::EndData()
+{
+	_lineLength = 0;
+	newCommand = true;
+	afterData = true;
+}
+
+
+size_t ConnectionBase::SerialMeter::write(	const uint8_t * buffer, 
+											size_t size )
+{
+	for ( size_t i = 0; i < size; i++ )
+	{
+		if ( stats )
+			stats[commandClass].bytesOut++;
+		
+		if ( buffer[i] != 0x0A )
+		{
+			if ( _lineLength < sizeof( _line ) - 1 )
+				_line[_lineLength] = buffer[i];
+			if ( _lineLength < 0xFFFF )
+				_lineLength++;
+			continue;
+		}
+		
+		// A command line: its bytes go to its class, counted from now on
+		_line[_lineLength < sizeof( _line ) ? _lineLength : sizeof( _line ) - 1] = '\0';
+		
+		if ( _line[0] == 'A' && _line[1] == 'T' )
+		{
+			CommandClass lineClass = ClassifyCommand( _line );
+			
+			if ( stats )
+			{
+				stats[commandClass].bytesOut -= _lineLength + 1;
+				stats[lineClass].bytesOut += _lineLength + 1;
+				stats[lineClass].calls++;
+			}
+			commandClass = lineClass;
+			newCommand = true;
+			afterData = false;
+		}
+		
+		_lineLength = 0;
+	}
+	
+	return stream->write( buffer, size );
+}
@@ -1,297 +1,1767 @@
-/** SIM900 Basic communication library for SIM900 gsm module. 
- *
- *	This library provide easy way to make GET and POST petitions to a web server. Use to interactue Arduino with restful apis, webs, etc.
- *
- *	Released under MIT license.		
- *
- *	@author	Miquel Vento (http://www.emevento.com)
- *	@version 1.0 24/03/2015
- *
- */
-#pragma once
-#ifndef __Connection_h__
-#define __Connection_h__
-
-#include <Arduino.h>
-
-class Connection
-{
-public:
-	/** \brief Constructuor
-	 *
-	 *	@param	IN	pin code of the SIM
-	 *	@param	IN	apn name of your provider
-	 *	@param	IN	apn user of your provider. Usually is ""
-	 *	@param	IN	apn password of your privider. Usually is ""
-	 *	@param	IN	enable pin for power on the board.
-	 *	@param	IN	serial port of your arduino.
-	 *	@param	IN	baudRate for communications. Defaults 115200.
-	 */
-	Connection( const char * pinCode, 
-				const char * apnName,  
-				const char * apnUser = "", 
-				const char * apnPass = "", 
-				const uint8_t & enablePin = 2, 
-				HardwareSerial &serialPort = Serial, 
-				uint32_t baudRate = 115200 );
-	
-
-	/** \brief Configure module to make connections.
-	 *		Is necessary to executate every time after power on or reboot the module.
-	 */
-	bool Configuration();
-	
-	/** \brief Make a Get petition to the server and receive data
-	 *		IMPORTANT! REMEMBER DELETE bodyReply content when you dont need more.
-	 *
-	 *	Request example www.example.com/api/europe/madrid/time	
-	 *
-	 *	@param	IN	Server domain or public IP. e.g. www.example.com OR 216.58.210.164
-	 *	@param	IN	Server path eg: api
-	 *	@param	IN	Server url eg: europe/madrid/time
-	 *	@param	OUT	Http Reply of the request: e.g. 200, 404, etc.
-	 *	@param	OUT	Reply of the request. The variable is initialized inside of method. REMEMBER DELETE when you don't need.
-	 *	@param	IN	Server port. The default value is 80
-	 *
-	 *	@return	true if the operation ends ok
-	 */
-	bool Get( 	const char * host, 
-				const char * path, 
-				const char * url, 
-				uint16_t & headerHttpReply, 
-				char *& bodyReply, 
-				const int port = 80 );
-
-	/** \brief Make a Post petition to the server
-	 *
-	 *	Request example www.example.com/api/europe/madrid/time	
-	 *
-	 *	@param	IN	Server domain or public IP. e.g. www.example.com OR 216.58.210.164
-	 *	@param	IN	Server path eg: api
-	 *	@param	IN	Server url eg: europe/madrid/time
-	 *	@param	IN	data to send.	eg: {"hour":10,"minutes":21,"seconds":13}
-	 *	@param	OUT	Http Reply of the request: e.g. 200, 404, etc.
-	 *	@param	IN	Server port. The default value is 80
-	 *
-	 *	@return	true if the operation ends ok
-	 */
-	bool Post( 	const char * host, 
-				const char * path, 
-				const char * url, 
-				const char * data, 
-				uint16_t & headerHttpReply, 
-				const int port = 80 );
-	
-	/** \brief Turn on the GPRS module.
-	 *	
-	 */
-	void PowerOn();
-	
-	/** \brief Turns off the GPRS module
-	 *
-	 */
-	void PowerOff();
-	
-protected:	
-	/** \brief Check if the GPRS module is on.
-	 *
-	 *	@return true if the module is on
-	 */
-	bool IsPowered();
-		
-	/** \brief Enables SIM900 AT command echo
-	 *	
-	 */
-	void EchoOn( );
-	/** \brief Disables SIM900 AT Command echo
-	 *	
-	 */
-	void EchoOff( );
-	
-	
-	/** \brief Introduces the pin code if is necessary
-	 *	
-	 */
-	bool AT_CPIN();
-	
-
-	/** \brief Check the status of the ME registration
-	 *
-	 *	-Correct Answers
-	 *		+CREG: 0,1 -> Registered, home network
-	 *		+CREG: 0,5 -> Registered, roaming
-	 *	-Waiting Answers
-	 *		+CREG: 0,0 -> Not registered, MT is not currently searching
-	 *		+CREG: 0,2 -> Not registered, MT is currently searching
-	 *		+CREG: 0,4 -> Unknow
-	 *
-	 *	@return true if the action ends OK
-	 */
-	bool AT_CREG();
-
-	/** \brief Check the state of the bearer
-	 *
-	 *	@return true if is opened
-	 */
-	bool IsBearerOpen();
-	
-
-	/** \brief Bearer settings for applications based on ip
-	 *
-	 *	@return true if the action ends OK
-	 */
-	bool OpenBearer();
-	
-	/** \brief Update the information of the APN provider. This action is only necessary if you changes the SIM service provider
-	 *
-	 *	@return true if the info is introduced and storaged correctly
-	 */
-	bool UpdateBearerInfo();
-
-	/** \brief Makes a Get petition  
-	 *
-	 */
-	bool AT_HTTPACTION_GET( uint16_t & httpHeader );
-
-	/** \brief Makes a Post petition
-	 *
-	 */
-	bool AT_HTTPACTION_POST( uint16_t & httpHeader );
-	
-	/** \brief Sends the content for POST petition
-	 *
-	 *	@param	IN	size of the data
-	 *	@param	IN	timeout for the operation
-	 *
-	 *	@return	true if the operation ends correctly
-	 */
-	bool AT_HTTPDATA( 	const int & size, 
-						const int & timeout );
-	
-	/** \brief Set the http parameters
-	 *
-	 *	@param	IN	host of the server
-	 *	@param	IN	path of the url
-	 *	@param	IN	the other part of the url
-	 *
-	 *	@return	true if the operation ends correctly
-	 */
-	bool AT_HTTPPARA_URL( 	const char * host, 
-							const char * path, 
-							const char * url );
-	
-	/** \brief Receive the httpheader of a GET or POST petition
-	 *
-	 *	Reply example: +HTTPACTION:1,201,0
-	 *
-	 *	@param	IN	expected answere (HTTPACTION:*,)
-	 *	@param	OUT	httpHeader received for operation
-	 *	@param	IN	timeout for the operation
-	 *
-	 *	@return	true if the operation ends correctly
-	 */
-	bool GetHttpHeader( const char * expected_answer, 
-						uint16_t & httpHeader, 
-						const uint16_t & timeout );
-	
-	/** \brief	Calculates if time for operation is run out
-	 *
-	 *	@return	true after timing out
-	 */
-	bool TimeOut( 	const uint32_t & previousTime, 
-					const uint16_t & timeOut );
-	
-	
-	/** \brief Get the size of the received data from server.
-	 *			Execute this method INMEDIATLY after AT+HTTPREAD operation
-	 */ 
-	uint16_t GetReceiveDataSize( const uint16_t & timeout );
-
-	/** \brief Waits for serial data, in accotated time.
-	 *
-	 */
-	bool WaitingSerialAvailable( 	const uint32_t & previousTime, 
-									const uint16_t & timeout );	
-	
-	/** \brief Receive data from server after Get request.
-	 *			Get the data after send AT+HTTPREAD command
-	 *
-	 *	@param	OUT	bodyReply	string of server answer
-	 *
-	 *	@return	true if operation finish ok
-	 */
-	bool ReceiveData(	char *& bodyReply, 
-						const uint16_t & timeout );
-	
-	/** \brief Cleans Serial input buffer.
-	 *
-	 */
-	void CleanSerialBuffer();
-
-	/** \brief Send AT commmand and check the answer
-	 *
-	 *	@return 0 if the recuest isn't correct
-	 */
-	int8_t SendATcommand( 	const char* ATcommand, 
-							const char* expectedAnswer, 
-							const unsigned int & timeout );
-
-	/** \brief Send AT command and check the two possible answers
-	 *
-	 *	@return the number of the answer or 0 if it don't exist
-	 */
-	int8_t SendATcommand(	const char* ATcommand, 
-							const char* expectedAnswer1, 
-							const char* expectedAnswer2, 
-							const unsigned int & timeout );
-
-	/** \brief Send AT command and check the N possible answers
-	 *
-	 *	@param	IN	ATcommand		AT command to send
-	 *	@param	IN	expectedAnswers	String array for posibles answers
-	 *	@param	IN	totalAnswers	size of expectedAnswers array
-	 *	@param	IN	timeout			max size for finish the operation
-	 *
-	 *	@return the number of the answer or 0 if it don't exist
-	 */
-	int8_t SendATcommand(	const char* ATcommand,
-							const char ** expectedAnswers,
-							const int & totalAnwers,
-							const unsigned int & timeout );	
-	
-	/** \brief Receive the response after AT Command Send.
-	 *
-	 *	@param	IN	expectedAnswers	String array for posibles answers
-	 *	@param	IN	totalAnswers	size of expectedAnswers array
-	 *	@param	IN	timeout			max size for finish the operation
-	 */
-	int8_t ReceiveATReply(	const char ** expectedAnswers,
-							const int & totalAnwers,
-							const unsigned int & timeout );	
-	
-	/** \brief Receive the response after AT Command Send.
-	 *
-	 *	@param	IN	expectedAnswer	expected answer to receive
-	 *	@param	IN	timeout			max size for finish the operation
-	 */
-	int8_t ReceiveATReply(	const char * expectedAnswer,
-							const unsigned int & timeout );
-
-private:
-	const char * _pinCode;
-	const char * _apnName;
-	const char * _apnUser;
-	const char * _apnPass;
-	
-	const uint8_t _enablePin;
-	
-	// Configuration
-	const int CREG_WAITING_RETRIES;
-	const int SAPBR_WAITING_RETRIES;
-	const int CGATT_WAITING_RETRIES;
-	const int MAX_ATRESPONSE;
-	
-	HardwareSerial * sim900Serial;
-};
-
-#endif
+/** SIM900 Basic communication library for SIM900 gsm module. 
+ *
+ *	This library provide easy way to make GET and POST petitions to a web server. Use to interactue Arduino with restful apis, webs, etc.
+ *
+ *	Released under MIT license.		
+ *
+ *	@author	Miquel Vento (http://www.emevento.com)
+ *	@version 1.0 24/03/2015
+ *
+ */
+#pragma once
+#ifndef __Connection_h__
+#define __Connection_h__
+
+#include <Arduino.h>
+#include "SIM900Deflate.h"
+#include "SIM900Cache.h"
+
+/** \brief Default configuration of the library. It is resolved at compile time.
+ *		To change it, derive a struct from it, redefine the values and use BasicConnection<YourPolicy>
+ *
+ *	struct SlowNetworkPolicy : DefaultConnectionPolicy
+ *	{
+ *		enum { HTTPACTION_TIMEOUT = 30000 };
+ *	};
+ *	BasicConnection<SlowNetworkPolicy> * SIM900 = new BasicConnection<SlowNetworkPolicy>( ... );
+ */
+struct DefaultConnectionPolicy
+{
+	enum
+	{
+		// Retries
+		CREG_WAITING_RETRIES = 80,
+		SAPBR_WAITING_RETRIES = 5,
+		CGATT_WAITING_RETRIES = 30,
+		
+		// Size of the stack buffers used to send and receive data
+		BODY_CHUNK_SIZE = 32,
+		
+		// Biggest reply the Get that allocates the body accepts (bytes)
+		BODY_ALLOCATION_MAX = 1024,
+		
+		// Timeouts (ms)
+		HTTPINIT_TIMEOUT = 3000,
+		CID_TIMEOUT = 5000,
+		URL_TIMEOUT = 10000,
+		DOWNLOAD_TIMEOUT = 10000,
+		DATA_INPUT_TIME = 20000,
+		DATA_TIMEOUT = 10000,
+		HTTPACTION_TIMEOUT = 10000,
+		HTTPREAD_TIMEOUT = 30000,
+		BODY_TIMEOUT = 15000,
+		
+		// Boot: length of the power on pulse, max wait until the module is ready
+		// and time between AT probes while the module is silent (ms)
+		POWER_PULSE_TIME = 1200,
+		BOOT_TIMEOUT = 10000,
+		BOOT_PROBE_INTERVAL = 500,
+		
+		// Sleep: DTR low time before the module is probed, max wait until it answers after
+		// the wake, time between the AT probes and max wait for AT+CFUN (ms)
+		WAKE_DTR_TIME = 50,
+		WAKE_TIMEOUT = 2000,
+		WAKE_PROBE_INTERVAL = 100,
+		CFUN_TIMEOUT = 10000,
+		
+		// Baud rate negotiation: wait after changing the rate and AT round trips to verify it
+		BAUD_SWITCH_TIME = 100,
+		BAUD_VERIFY_ROUNDS = 3,
+		
+		// Sockets (ms): GPRS activation (AT+CIICR), connection, send, shutdown and data of +RECEIVE
+		SOCKET_GPRS_TIMEOUT = 60000,
+		SOCKET_CONNECT_TIMEOUT = 60000,
+		SOCKET_SEND_TIMEOUT = 10000,
+		SOCKET_SHUT_TIMEOUT = 10000,
+		SOCKET_DATA_TIMEOUT = 5000,
+		
+		// 1 to keep statistics of every class of command, see GetCommandStats()
+		COMMAND_STATS = 0,
+		
+		// 1 to shorten the waits to the response times seen for every class of command, like
+		// the TCP retransmission timeout. The timeouts above are the ceiling, this is the floor (ms)
+		ADAPTIVE_TIMEOUTS = 0,
+		ADAPTIVE_TIMEOUT_FLOOR = 1000,
+		
+		// Unsolicited result codes: chars kept of each line and codes waiting for ProcessUrcs()
+		URC_LINE_SIZE = 24,
+		URC_QUEUE_SIZE = 4,
+		
+		// Compressed Post: distance searched back for repeated text. Bigger compresses more but is slower
+		COMPRESSION_WINDOW = 256,
+		
+		// Response cache: chars kept of each header line read with AT+HTTPHEAD
+		CACHE_HEADER_LINE_SIZE = 64
+	};
+};
+
+
+/** \brief Parts of the connection that don't depend on the configuration
+ */
+class ConnectionBase
+{
+public:
+	/** \brief Function called while the library waits for the module.
+	 */
+	typedef void (*IdleCallback)();
+	
+	/** \brief Clock functions, millis() and delay() by default.
+	 */
+	typedef unsigned long (*MillisFunction)();
+	typedef void (*DelayFunction)( unsigned long );
+	
+	/** \brief Function that receives the body of a reply in chunks, as it comes from the module.
+	 *
+	 *	@param	IN	chunk of the body. It isn't NUL terminated.
+	 *	@param	IN	size of the chunk
+	 *	@param	IN	context pointer given with the request
+	 *
+	 *	@return	false to stop receiving
+	 */
+	typedef bool (*BodyCallback)( const char * chunk, uint16_t length, void * context );
+	
+	/** \brief Function that tells if the serial port of the host can be set to a baud rate
+	 *
+	 *	@param	IN	baud rate
+	 *	@param	IN	context pointer given with the function
+	 *
+	 *	@return	false to skip the rate
+	 */
+	typedef bool (*BaudRateCheck)( uint32_t baudRate, void * context );
+	
+	/** \brief Function that produces the data of a Post in chunks, as it is sent to the module.
+	 *
+	 *	@param	OUT	buffer for the data
+	 *	@param	IN	bytes requested. The producer must fill all of them.
+	 *	@param	IN	context pointer given with the request
+	 *
+	 *	@return	bytes written in buffer. 0 aborts the request.
+	 */
+	typedef uint16_t (*DataProducer)( char * buffer, uint16_t size, void * context );
+	
+	/** \brief Status of an asynchronous request
+	 */
+	enum RequestStatus
+	{
+		REQUEST_IDLE,
+		REQUEST_RUNNING,
+		REQUEST_DONE,
+		REQUEST_FAILED
+	};
+	
+	/** \brief Function called when an asynchronous request finishes.
+	 *
+	 *	@param	IN	REQUEST_DONE or REQUEST_FAILED
+	 *	@param	IN	Http Reply of the request: e.g. 200, 404, etc.
+	 *	@param	IN	context pointer given with the request
+	 */
+	typedef void (*RequestCallback)( RequestStatus status, uint16_t headerHttpReply, void * context );
+	
+	/** \brief Unsolicited result codes: lines the module sends without a command
+	 */
+	enum UrcCode
+	{
+		URC_RING,				// RING
+		URC_SMS,				// +CMTI: "SM",3
+		URC_BEARER_DEACT,		// +SAPBR 1: DEACT or +PDP: DEACT
+		URC_CALL_READY,			// Call Ready
+		URC_UNDER_VOLTAGE,		// UNDER-VOLTAGE WARNNING
+		URC_OVER_VOLTAGE,		// OVER-VOLTAGE WARNNING
+		URC_POWER_DOWN,			// NORMAL POWER DOWN, UNDER-VOLTAGE POWER DOWN, etc.
+		URC_SOCKET_CLOSED		// 0, CLOSED
+	};
+	
+	/** \brief Function called by ProcessUrcs() for every unsolicited result code received.
+	 *
+	 *	@param	IN	code received
+	 *	@param	IN	line of the code, truncated to URC_LINE_SIZE. e.g. +CMTI: "SM",3
+	 *	@param	IN	context pointer given with the callback
+	 */
+	typedef void (*UrcCallback)( UrcCode code, const char * line, void * context );
+	
+	/** \brief Protocol of a socket
+	 */
+	enum SocketType
+	{
+		SOCKET_TCP,
+		SOCKET_UDP
+	};
+	
+	/** \brief Function that receives the data of the sockets in chunks, as it comes from the module.
+	 *		It may be called while the library waits for any command, so it must not send commands.
+	 *
+	 *	@param	IN	link of the socket, 0 to SOCKET_LINKS-1
+	 *	@param	IN	chunk of data. It isn't NUL terminated.
+	 *	@param	IN	size of the chunk
+	 *	@param	IN	context pointer given with the callback
+	 */
+	typedef void (*SocketCallback)( uint8_t link, const char * chunk, uint16_t length, void * context );
+	
+	/** \brief Connections the module can keep open at the same time
+	 */
+	static const uint8_t SOCKET_LINKS = 6;
+	
+	/** \brief Sleep modes of the module ( AT+CSCLK )
+	 */
+	enum SleepMode
+	{
+		SLEEP_NONE = 0,			// always awake
+		SLEEP_DTR = 1,			// sleeps while the DTR pin is high
+		SLEEP_AUTO = 2			// sleeps when the serial port is idle, wakes with the next command
+	};
+	
+	/** \brief Functionality levels of the module ( AT+CFUN )
+	 */
+	enum FunctionLevel
+	{
+		FUNCTION_MINIMUM = 0,	// radio and SIM off
+		FUNCTION_FULL = 1,
+		FUNCTION_FLIGHT = 4		// radio off
+	};
+	
+	/** \brief Time awake and asleep, to trade energy against latency
+	 */
+	struct PowerStats
+	{
+		uint16_t wakes;			// Wake() calls that woke the module
+		uint16_t lastWakeTime;	// ms from the wake until the module answered
+		uint16_t maxWakeTime;
+		uint32_t lastAwakeTime;	// ms between the last Wake() and Sleep()
+		uint32_t awakeTime;		// total ms awake between Wake() and Sleep()
+		uint32_t sleepTime;		// total ms asleep between Sleep() and Wake()
+	};
+	
+	/** \brief Classes of AT commands the statistics are kept for
+	 */
+	enum CommandClass
+	{
+		COMMAND_GENERAL,		// AT, ATE0, AT+IPR, etc.
+		COMMAND_SIM,			// AT+CPIN
+		COMMAND_NETWORK,		// AT+CREG, AT+CGATT
+		COMMAND_BEARER,			// AT+SAPBR
+		COMMAND_HTTP_INIT,		// AT+HTTPINIT
+		COMMAND_HTTP_PARA,		// AT+HTTPPARA
+		COMMAND_HTTP_DATA,		// AT+HTTPDATA
+		COMMAND_HTTP_ACTION,	// AT+HTTPACTION
+		COMMAND_HTTP_READ,		// AT+HTTPREAD
+		COMMAND_HTTP_TERM,		// AT+HTTPTERM
+		COMMAND_SOCKET,			// AT+CIPxxx, AT+CSTT, AT+CIICR, AT+CIFSR
+		COMMAND_CLASSES
+	};
+	
+	/** \brief Statistics of a class of AT commands
+	 */
+	struct CommandStats
+	{
+		uint16_t calls;			// commands sent
+		uint16_t replies;		// expected answers received
+		uint16_t timeouts;		// waits that ended without answer
+		uint16_t errors;		// waits that ended with ERROR from the module
+		uint16_t retries;		// commands repeated after a failure
+		uint16_t minLatency;	// ms from the command to the expected answer
+		uint16_t maxLatency;
+		uint32_t totalLatency;
+		uint32_t bytesOut;		// bytes sent, commands and data
+		uint32_t bytesIn;		// bytes received, answers and data
+	};
+	
+	/** \brief Prints the statistics, a line for every class of command used
+	 *
+	 *	@param	IN	destination. e.g. Serial
+	 *	@param	IN	statistics of COMMAND_CLASSES classes
+	 */
+	static void PrintCommandStats(	Print & output, 
+									const CommandStats * stats );
+
+protected:	
+	/** \brief Steps of the asynchronous requests
+	 */
+	enum AsyncState
+	{
+		ASYNC_IDLE,
+		ASYNC_HTTPINIT,
+		ASYNC_HTTPTERM_RESTART,
+		ASYNC_CID,
+		ASYNC_HTTPDATA,
+		ASYNC_DATA,
+		ASYNC_DATA_OK,
+		ASYNC_URL,
+		ASYNC_ACTION,
+		ASYNC_ACTION_REPLY,
+		ASYNC_HTTPREAD,
+		ASYNC_HTTPREAD_SIZE,
+		ASYNC_HTTPREAD_DATA,
+		ASYNC_HTTPREAD_OK,
+		ASYNC_HTTPTERM
+	};
+	
+	/** \brief Body destination of the Get with caller buffer
+	 */
+	struct BufferSink
+	{
+		char * buffer;
+		uint16_t size;
+		uint16_t length;
+	};
+	
+	/** \brief BodyCallback that copies the chunks in a BufferSink
+	 */
+	static bool WriteToBuffer(	const char * chunk, 
+								uint16_t length, 
+								void * context );
+	
+	/** \brief BodyCallback that writes the chunks in a Print
+	 */
+	static bool WriteToPrint(	const char * chunk, 
+								uint16_t length, 
+								void * context );
+	
+	/** \brief Body destination of a Get that is also saved in the response cache
+	 */
+	struct CacheTee
+	{
+		BodyCallback callback;
+		void * context;
+		ResponseCacheBase * cache;
+	};
+	
+	/** \brief BodyCallback that adds the chunks to the cache and passes them to the callback of a CacheTee
+	 */
+	static bool WriteToCache(	const char * chunk, 
+								uint16_t length, 
+								void * context );
+	
+	/** \brief DataProducer that copies from a string. context is a pointer to the string pointer.
+	 */
+	static uint16_t ReadFromMemory(	char * buffer, 
+									uint16_t size, 
+									void * context );
+	
+	/** \brief DataProducer that reads from a Stream
+	 */
+	static uint16_t ReadFromStream(	char * buffer, 
+									uint16_t size, 
+									void * context );
+	
+	/** \brief Max expected answers of a wait
+	 */
+	static const uint8_t MAX_ANSWERS = 5;
+	
+	/** \brief Match state of an expected answer. Only the chars matched are kept, nothing
+	 *		of the received text has to be stored.
+	 */
+	struct AnswerMatcher
+	{
+		const char * pattern;
+		bool inFlash;
+		uint8_t length;
+		uint8_t matched;
+	};
+	
+	/** \brief Prepares the match of an expected answer
+	 *
+	 *	@param	OUT	matcher		match state
+	 *	@param	IN	pattern		expected answer
+	 *	@param	IN	inFlash		true if pattern is stored in flash (PROGMEM)
+	 */
+	static void BeginMatch(	AnswerMatcher & matcher,
+							const char * pattern,
+							const bool & inFlash );
+	
+	/** \brief Advances the match of an expected answer with the next received char
+	 *
+	 *	@param	IN/OUT	matcher		match state
+	 *	@param	IN		nextChar	char received from the module
+	 *
+	 *	@return true when the whole answer has been matched
+	 */
+	static bool MatchNextChar(	AnswerMatcher & matcher,
+								const char & nextChar );
+	
+	/** \brief Advances the match state of an expected answer with the next received char.
+	 *		On mismatch it rescans for the longest prefix of the pattern that still matches,
+	 *		O(m^2) for a pattern of m chars. The SIM900 answers are short and rarely overlap
+	 *		themselves, so the rescan is cheaper than a failure table.
+	 *
+	 *	@param	IN	pattern		expected answer
+	 *	@param	IN	matched		chars of pattern already matched
+	 *	@param	IN	nextChar	char received from the module
+	 *	@param	IN	inFlash		true if pattern is stored in flash (PROGMEM)
+	 *
+	 *	@return chars of pattern matched after nextChar. Equals strlen(pattern) on full match
+	 */
+	static uint8_t MatchNextChar(	const char * pattern,
+							uint8_t matched,
+							const char & nextChar,
+							const bool & inFlash = false );
+	
+	/** \brief Reads a char of a pattern stored in RAM or in flash
+	 *
+	 */
+	static char PatternChar(	const char * pattern,
+								const uint8_t & position,
+								const bool & inFlash );
+	
+	/** \brief Finds the unsolicited result code of a line
+	 *
+	 *	@param	IN	line received, without CR LF
+	 *
+	 *	@return	UrcCode of the line or -1 if it isn't an unsolicited result code
+	 */
+	static int8_t ClassifyUrc( const char * line );
+	
+	/** \brief Checks the start of a line
+	 *
+	 *	@param	IN	line received
+	 *	@param	IN	prefix stored in flash
+	 */
+	static bool LineStartsWith(	const char * line,
+								const char * prefix );
+	
+	/** \brief Adds a decimal digit received from the module to a number
+	 *
+	 *	@param	IN/OUT	number being parsed
+	 *	@param	IN		char received
+	 *	@param	IN		max value of the number
+	 *
+	 *	@return	false if the char isn't a digit or the number would exceed maximum
+	 */
+	static bool AddDigit(	uint32_t & number, 
+							const char & nextChar, 
+							const uint32_t & maximum );
+	
+	/** \brief Checks if a line is an error of the module: ERROR, +CME ERROR, +CMS ERROR
+	 */
+	static bool IsErrorLine( const char * line );
+	
+	/** \brief Checks if an expected answer is ERROR
+	 *
+	 *	@param	IN	expected answer
+	 *	@param	IN	true if answer is stored in flash (PROGMEM)
+	 */
+	static bool IsErrorAnswer(	const char * answer,
+								const bool & inFlash );
+	
+	/** \brief Finds the class of an AT command
+	 *
+	 *	@param	IN	start of the command line. e.g. AT+HTTPREAD=0,100
+	 */
+	static CommandClass ClassifyCommand( const char * command );
+	
+	/** \brief Stream between the library and the module that counts the bytes of every
+	 *		class of command. The class is taken from the command lines sent.
+	 */
+	class SerialMeter : public Stream
+	{
+	public:
+		SerialMeter();
+		
+		int available();
+		int read();
+		int peek();
+		void flush();
+		size_t write( uint8_t nextChar );
+		size_t write( const uint8_t * buffer, size_t size );
+		using Print::write;
+		
+		/** \brief Ends raw data written after a command ( HTTPDATA, CIPSEND ). The data has
+		 *		no line end, so the next command line starts clean instead of after it.
+		 */
+		void EndData();
+		
+		Stream * stream;
+		CommandStats * stats;
+		CommandClass commandClass;
+		bool newCommand;		// no answer has been waited for since the last command or its data
+		bool afterData;			// the data of the command has been sent, the answer ends the transfer
+		
+	private:
+		// Start of the line being sent, enough to classify it
+		char _line[16];
+		uint16_t _lineLength;
+	};
+	
+	// Expected answers used by several commands, stored in flash
+	static const char CREG_NOT_SEARCHING[];
+	static const char CREG_SEARCHING[];
+	static const char CREG_UNKNOWN[];
+	static const char CREG_HOME[];
+	static const char CREG_ROAMING[];
+	
+	// Unsolicited result codes, stored in flash
+	static const char URC_RING_PREFIX[];
+	static const char URC_SMS_PREFIX[];
+	static const char URC_SAPBR_DEACT_PREFIX[];
+	static const char URC_PDP_DEACT_PREFIX[];
+	static const char URC_CALL_READY_PREFIX[];
+	static const char URC_NORMAL_POWER_DOWN_PREFIX[];
+	static const char URC_UNDER_VOLTAGE_PREFIX[];
+	static const char URC_OVER_VOLTAGE_PREFIX[];
+	static const char URC_POWER_DOWN_SUFFIX[];
+	
+	// Boot messages, stored in flash
+	static const char BOOT_RDY[];
+	static const char BOOT_CPIN[];
+	static const char BOOT_OK[];
+	
+	// Baud rates supported by AT+IPR, from the fastest, stored in flash
+	static const uint32_t BAUD_RATES[];
+	static const uint8_t BAUD_RATES_COUNT = 8;
+	
+	// Socket messages, stored in flash
+	static const char SOCKET_RECEIVE_PREFIX[];
+	static const char SOCKET_CLOSED_SUFFIX[];
+};
+
+
+/** \brief Connection with the SIM900 module. Policy sets the compile time configuration,
+ *		see DefaultConnectionPolicy.
+ */
+template <class Policy>
+class BasicConnection : public ConnectionBase
+{
+public:
+	/** \brief Constructuor
+	 *
+	 *	@param	IN	pin code of the SIM
+	 *	@param	IN	apn name of your provider
+	 *	@param	IN	apn user of your provider. Usually is ""
+	 *	@param	IN	apn password of your privider. Usually is ""
+	 *	@param	IN	enable pin for power on the board.
+	 *	@param	IN	serial port of your arduino.
+	 *	@param	IN	baudRate for communications. Defaults 115200.
+	 */
+	BasicConnection( const char * pinCode, 
+				const char * apnName,  
+				const char * apnUser = "", 
+				const char * apnPass = "", 
+				const uint8_t & enablePin = 2, 
+				HardwareSerial &serialPort = Serial, 
+				uint32_t baudRate = 115200 );
+	
+	/** \brief Constructuor for any Stream ( SoftwareSerial, a simulated module, etc. ).
+	 *		The stream must be already initialized.
+	 *
+	 *	@param	IN	pin code of the SIM
+	 *	@param	IN	apn name of your provider
+	 *	@param	IN	apn user of your provider. Usually is ""
+	 *	@param	IN	apn password of your privider. Usually is ""
+	 *	@param	IN	enable pin for power on the board.
+	 *	@param	IN	stream connected to the module.
+	 */
+	BasicConnection( const char * pinCode, 
+				const char * apnName,  
+				const char * apnUser, 
+				const char * apnPass, 
+				const uint8_t & enablePin, 
+				Stream &serialPort );
+	
+
+	/** \brief Configure module to make connections.
+	 *		Is necessary to executate every time after power on or reboot the module.
+	 */
+	bool Configuration();
+	
+	/** \brief Make a Get petition to the server and receive data
+	 *		IMPORTANT! REMEMBER DELETE bodyReply content when you dont need more.
+	 *		The whole reply is allocated, use the other Get methods for big replies. A reply
+	 *		longer than BODY_ALLOCATION_MAX isn't read and the Get fails.
+	 *
+	 *	Request example www.example.com/api/europe/madrid/time	
+	 *
+	 *	@param	IN	Server domain or public IP. e.g. www.example.com OR 216.58.210.164
+	 *	@param	IN	Server path eg: api
+	 *	@param	IN	Server url eg: europe/madrid/time
+	 *	@param	OUT	Http Reply of the request: e.g. 200, 404, etc.
+	 *	@param	OUT	Reply of the request. The variable is initialized inside of method. REMEMBER DELETE when you don't need.
+	 *	@param	IN	Server port. The default value is 80
+	 *
+	 *	@return	true if the operation ends ok. bodyReply can be allocated when the body
+	 *			wasn't read whole, delete it anyway.
+	 */
+	bool Get( 	const char * host, 
+				const char * path, 
+				const char * url, 
+				uint16_t & headerHttpReply, 
+				char *& bodyReply, 
+				const int port = 80 );
+	
+	/** \brief Make a Get petition to the server and receive data in a buffer. It doesn't allocate memory.
+	 *
+	 *	@param	IN	Server domain or public IP. e.g. www.example.com OR 216.58.210.164
+	 *	@param	IN	Server path eg: api
+	 *	@param	IN	Server url eg: europe/madrid/time
+	 *	@param	OUT	Http Reply of the request: e.g. 200, 404, etc.
+	 *	@param	OUT	buffer for the reply. It is always NUL terminated.
+	 *	@param	IN	size of the buffer
+	 *	@param	OUT	length of the reply, 0xFFFF for 64 KB or more. If it is >= bodySize the reply was truncated.
+	 *	@param	IN	Server port. The default value is 80
+	 *
+	 *	@return	true if the operation ends ok
+	 */
+	bool Get( 	const char * host, 
+				const char * path, 
+				const char * url, 
+				uint16_t & headerHttpReply, 
+				char * body, 
+				const uint16_t & bodySize, 
+				uint16_t & bodyLength, 
+				const int port = 80 );
+	
+	/** \brief Make a Get petition to the server and write the reply to a Print ( Serial, File, etc. ).
+	 *		It doesn't allocate memory.
+	 *
+	 *	@param	IN	Server domain or public IP. e.g. www.example.com OR 216.58.210.164
+	 *	@param	IN	Server path eg: api
+	 *	@param	IN	Server url eg: europe/madrid/time
+	 *	@param	OUT	Http Reply of the request: e.g. 200, 404, etc.
+	 *	@param	IN	where the reply is written
+	 *	@param	IN	Server port. The default value is 80
+	 *
+	 *	@return	true if the operation ends ok
+	 */
+	bool Get( 	const char * host, 
+				const char * path, 
+				const char * url, 
+				uint16_t & headerHttpReply, 
+				Print & sink, 
+				const int port = 80 );
+	
+	/** \brief Make a Get petition to the server and pass the reply in chunks to a callback.
+	 *		It doesn't allocate memory.
+	 *
+	 *	@param	IN	Server domain or public IP. e.g. www.example.com OR 216.58.210.164
+	 *	@param	IN	Server path eg: api
+	 *	@param	IN	Server url eg: europe/madrid/time
+	 *	@param	OUT	Http Reply of the request: e.g. 200, 404, etc.
+	 *	@param	IN	function called for every chunk of the reply
+	 *	@param	IN	pointer passed to callback
+	 *	@param	IN	Server port. The default value is 80
+	 *
+	 *	@return	true if the operation ends ok
+	 */
+	bool Get( 	const char * host, 
+				const char * path, 
+				const char * url, 
+				uint16_t & headerHttpReply, 
+				BodyCallback callback, 
+				void * context, 
+				const int port = 80 );
+
+	/** \brief Make a Post petition to the server
+	 *
+	 *	Request example www.example.com/api/europe/madrid/time	
+	 *
+	 *	@param	IN	Server domain or public IP. e.g. www.example.com OR 216.58.210.164
+	 *	@param	IN	Server path eg: api
+	 *	@param	IN	Server url eg: europe/madrid/time
+	 *	@param	IN	data to send.	eg: {"hour":10,"minutes":21,"seconds":13}
+	 *	@param	OUT	Http Reply of the request: e.g. 200, 404, etc.
+	 *	@param	IN	Server port. The default value is 80
+	 *
+	 *	@return	true if the operation ends ok
+	 */
+	bool Post( 	const char * host, 
+				const char * path, 
+				const char * url, 
+				const char * data, 
+				uint16_t & headerHttpReply, 
+				const int port = 80 );
+	
+	/** \brief Make a Post petition to the server with the data read from a Stream ( File, Serial, etc. ).
+	 *		The data is sent in chunks, so it doesn't have to fit in memory.
+	 *
+	 *	@param	IN	Server domain or public IP. e.g. www.example.com OR 216.58.210.164
+	 *	@param	IN	Server path eg: api
+	 *	@param	IN	Server url eg: europe/madrid/time
+	 *	@param	IN	where the data is read
+	 *	@param	IN	length of the data. It must be known before sending.
+	 *	@param	OUT	Http Reply of the request: e.g. 200, 404, etc.
+	 *	@param	IN	Server port. The default value is 80
+	 *
+	 *	@return	true if the operation ends ok
+	 */
+	bool Post( 	const char * host, 
+				const char * path, 
+				const char * url, 
+				Stream & source, 
+				const uint32_t & dataLength, 
+				uint16_t & headerHttpReply, 
+				const int port = 80 );
+	
+	/** \brief Make a Post petition to the server with the data made by a producer function.
+	 *		The data is requested in chunks while it is sent, so it can be built on the fly.
+	 *
+	 *	@param	IN	Server domain or public IP. e.g. www.example.com OR 216.58.210.164
+	 *	@param	IN	Server path eg: api
+	 *	@param	IN	Server url eg: europe/madrid/time
+	 *	@param	IN	length of the data. It must be known before sending.
+	 *	@param	IN	function called for every chunk of data
+	 *	@param	IN	pointer passed to producer
+	 *	@param	OUT	Http Reply of the request: e.g. 200, 404, etc.
+	 *	@param	IN	Server port. The default value is 80
+	 *
+	 *	@return	true if the operation ends ok
+	 */
+	bool Post( 	const char * host, 
+				const char * path, 
+				const char * url, 
+				const uint32_t & dataLength, 
+				DataProducer producer, 
+				void * context, 
+				uint16_t & headerHttpReply, 
+				const int port = 80 );
+	
+	/** \brief Make a Post petition with the data compressed ( Content-Encoding: deflate ).
+	 *		The server must accept compressed bodies. The data is compressed twice, once to know
+	 *		its size and once while it is sent, so no buffer is needed. If it doesn't get smaller
+	 *		it is sent as it is.
+	 *
+	 *	@param	IN	Server domain or public IP. e.g. www.example.com OR 216.58.210.164
+	 *	@param	IN	Server path eg: api
+	 *	@param	IN	Server url eg: europe/madrid/time
+	 *	@param	IN	data to send.	eg: {"hour":10,"minutes":21,"seconds":13}
+	 *	@param	IN	Content-Type of the data. e.g. application/json. NULL keeps the module's default.
+	 *	@param	OUT	Http Reply of the request: e.g. 200, 404, etc.
+	 *	@param	IN	Server port. The default value is 80
+	 *
+	 *	@return	true if the operation ends ok
+	 */
+	bool PostCompressed(	const char * host, 
+							const char * path, 
+							const char * url, 
+							const char * data, 
+							const char * contentType, 
+							uint16_t & headerHttpReply, 
+							const int port = 80 );
+	
+	/** \brief Starts a Get petition without blocking. Call Poll() from loop() until it finishes.
+	 *		The module must be configured (Configuration()) before, it isn't done asynchronously.
+	 *		Don't call other methods while the request is running.
+	 *
+	 *	@param	IN	Server domain or public IP. e.g. www.example.com OR 216.58.210.164
+	 *	@param	IN	Server path eg: api
+	 *	@param	IN	Server url eg: europe/madrid/time
+	 *	@param	IN	function called for every chunk of the reply. Can be NULL.
+	 *	@param	IN	function called when the request finishes. Can be NULL.
+	 *	@param	IN	pointer passed to the callbacks
+	 *
+	 *	@return	true if the request is started
+	 */
+	bool StartGet(	const char * host, 
+					const char * path, 
+					const char * url, 
+					BodyCallback bodyCallback, 
+					RequestCallback requestCallback = NULL, 
+					void * context = NULL );
+	
+	/** \brief Starts a Post petition without blocking. Call Poll() from loop() until it finishes.
+	 *		The module must be configured (Configuration()) before, it isn't done asynchronously.
+	 *		Don't call other methods while the request is running.
+	 *
+	 *	@param	IN	Server domain or public IP. e.g. www.example.com OR 216.58.210.164
+	 *	@param	IN	Server path eg: api
+	 *	@param	IN	Server url eg: europe/madrid/time
+	 *	@param	IN	data to send. It must be valid until the request finishes.
+	 *	@param	IN	function called when the request finishes. Can be NULL.
+	 *	@param	IN	pointer passed to requestCallback
+	 *
+	 *	@return	true if the request is started
+	 */
+	bool StartPost(	const char * host, 
+					const char * path, 
+					const char * url, 
+					const char * data, 
+					RequestCallback requestCallback = NULL, 
+					void * context = NULL );
+	
+	/** \brief Starts a Post petition without blocking, with the data made by a producer function.
+	 *
+	 *	@param	IN	Server domain or public IP. e.g. www.example.com OR 216.58.210.164
+	 *	@param	IN	Server path eg: api
+	 *	@param	IN	Server url eg: europe/madrid/time
+	 *	@param	IN	length of the data
+	 *	@param	IN	function called for every chunk of data
+	 *	@param	IN	pointer passed to producer
+	 *	@param	IN	function called when the request finishes. Can be NULL.
+	 *	@param	IN	pointer passed to requestCallback
+	 *
+	 *	@return	true if the request is started
+	 */
+	bool StartPost(	const char * host, 
+					const char * path, 
+					const char * url, 
+					const uint32_t & dataLength, 
+					DataProducer producer, 
+					void * producerContext, 
+					RequestCallback requestCallback = NULL, 
+					void * context = NULL );
+	
+	/** \brief Runs the asynchronous request. Every call does one short step, call it often.
+	 *
+	 *	@return	the status of the request
+	 */
+	RequestStatus Poll();
+	
+	/** \brief Status of the last asynchronous request
+	 *
+	 */
+	RequestStatus GetRequestStatus();
+	
+	/** \brief Http Reply of the last asynchronous request: e.g. 200, 404, etc.
+	 *
+	 */
+	uint16_t GetRequestHttpReply();
+	
+	/** \brief Keeps the bodies of the Get replies that have an ETag or Last-Modified in a cache.
+	 *		The next Get of the same url sends If-None-Match or If-Modified-Since and, if the
+	 *		server answers 304 Not Modified, the body is read from the cache and the reply is 200.
+	 *		Only the blocking Get uses the cache.
+	 *
+	 *	@param	IN	cache, e.g. a ResponseCache<512>. NULL to disable it.
+	 */
+	void SetResponseCache( ResponseCacheBase * cache );
+	
+	/** \brief True if the body of the last Get was read from the response cache
+	 *
+	 */
+	bool IsCachedReply();
+	
+	/** \brief Keeps the HTTP service of the module initialized between requests.
+	 *		Get and Post will skip HTTPINIT, CID setup and HTTPTERM until EndSession() is called.
+	 *		If the module drops the session it is restarted automatically.
+	 *
+	 *	@return	true if the HTTP service is ready
+	 */
+	bool BeginSession();
+	
+	/** \brief Terminates the HTTP session opened with BeginSession()
+	 *
+	 */
+	void EndSession();
+	
+	/** \brief True between BeginSession() and EndSession()
+	 *
+	 */
+	bool IsSessionOpen();
+	
+	/** \brief IP address of the bearer, as it was read the last time it was checked.
+	 *
+	 *	@return	the IP address or "" if the bearer isn't open
+	 */
+	const char * GetIpAddress();
+	
+	/** \brief Number of times the bearer state has been asked to the module (AT+SAPBR=2,1)
+	 *
+	 */
+	uint16_t GetBearerProbes();
+	
+	/** \brief Number of bearer probes saved because the bearer state was cached
+	 *
+	 */
+	uint16_t GetBearerProbesSaved();
+	
+	/** \brief Sets the size of the windows the reply of a Get is read with (AT+HTTPREAD).
+	 *		The window must fit in the Serial buffer. Defaults 100.
+	 *
+	 *	@param	IN	window size in bytes
+	 */
+	void SetReadWindow( const uint16_t & window );
+	
+	/** \brief Sets the clock used by the library. Use it to run the library with a simulated time.
+	 *
+	 *	@param	IN	function that returns the ms since start, like millis()
+	 *	@param	IN	function that waits some ms, like delay()
+	 */
+	void SetClock(	MillisFunction millisFunction, 
+					DelayFunction delayFunction );
+	
+	/** \brief Current time of the library clock
+	 *
+	 *	@return	ms since start
+	 */
+	uint32_t Millis();
+	
+	/** \brief Sets the function to run while waiting for the module answers.
+	 *		Use it to attend sensors, watchdogs, etc. during long operations. It must return quickly.
+	 *
+	 *	@param	IN	function to call. NULL restores the default behaviour ( yield() ).
+	 */
+	void SetIdleCallback( IdleCallback idleCallback );
+	
+	/** \brief Sets the function that receives the unsolicited result codes ( RING, +CMTI, etc. )
+	 *
+	 *	@param	IN	function to call. NULL discards the codes.
+	 *	@param	IN	context pointer passed to the function
+	 */
+	void SetUrcCallback(	UrcCallback urcCallback, 
+							void * context = NULL );
+	
+	/** \brief Reads the pending input and calls the UrcCallback for the unsolicited result codes
+	 *		received since the last call. Call it from loop().
+	 *		The codes are queued while the library waits for the module, so the callback never
+	 *		runs in the middle of a command. A bearer DEACT aborts the current request
+	 *		immediately, without waiting for its timeout.
+	 */
+	void ProcessUrcs();
+	
+	/** \brief Unsolicited result codes lost because the queue was full
+	 */
+	uint16_t GetUrcDropped();
+	
+	/** \brief Brings up the GPRS context of the sockets ( AT+CIPMUX=1, AT+CSTT, AT+CIICR ).
+	 *		SocketOpen() calls it when it is needed. Call it after Configuration().
+	 *		It closes the open sockets.
+	 *
+	 *	@return	true if the operation ends ok
+	 */
+	bool StartSockets();
+	
+	/** \brief Opens a TCP connection or a UDP socket in the first free link ( AT+CIPSTART ).
+	 *		The received data is given to the SocketCallback.
+	 *
+	 *	@param	IN	SOCKET_TCP or SOCKET_UDP
+	 *	@param	IN	Server domain or public IP. e.g. www.example.com OR 216.58.210.164
+	 *	@param	IN	Server port
+	 *
+	 *	@return	link of the socket, -1 on failure
+	 */
+	int8_t SocketOpen(	SocketType type, 
+						const char * host, 
+						const uint16_t & port );
+	
+	/** \brief Sends data through a socket ( AT+CIPSEND )
+	 *
+	 *	@param	IN	link of the socket
+	 *	@param	IN	data to send
+	 *	@param	IN	size of the data
+	 *
+	 *	@return	true if the module sent the data
+	 */
+	bool SocketSend(	const uint8_t & link, 
+						const char * data, 
+						const uint16_t & length );
+	
+	/** \brief Closes a socket ( AT+CIPCLOSE )
+	 *
+	 *	@param	IN	link of the socket
+	 */
+	bool SocketClose( const uint8_t & link );
+	
+	/** \brief Checks if a socket is open. The sockets closed by the server are noticed
+	 *		when their CLOSED code is read, e.g. by ProcessUrcs().
+	 *
+	 *	@param	IN	link of the socket
+	 */
+	bool IsSocketOpen( const uint8_t & link );
+	
+	/** \brief Sets the function that receives the data of the sockets
+	 *
+	 *	@param	IN	function to call. NULL discards the data.
+	 *	@param	IN	context pointer passed to the function
+	 */
+	void SetSocketCallback(	SocketCallback socketCallback, 
+							void * context = NULL );
+	
+	/** \brief Statistics of a class of commands. They are kept only when the policy sets COMMAND_STATS.
+	 *
+	 *	@param	IN	class of command
+	 */
+	const CommandStats & GetCommandStats( CommandClass commandClass );
+	
+	/** \brief Prints the statistics of all the classes of command
+	 *
+	 *	@param	IN	destination. e.g. Serial
+	 */
+	void PrintCommandStats( Print & output );
+	
+	/** \brief Clears the statistics
+	 */
+	void ResetCommandStats();
+	
+	/** \brief Timeout learned for a class of commands when the policy sets ADAPTIVE_TIMEOUTS:
+	 *		smoothed response time plus four times its variation, before the floor and ceiling.
+	 *		The answer to the command line (e.g. DOWNLOAD, >) and the answer after its data
+	 *		(OK, SEND OK) are learned apart.
+	 *
+	 *	@param	IN	class of command
+	 *	@param	IN	true for the answer after the data of the command
+	 *
+	 *	@return	ms, 0 while no answer has been seen
+	 */
+	uint16_t GetAdaptiveTimeout(	CommandClass commandClass, 
+									const bool & afterData = false );
+	
+	/** \brief Turn on the GPRS module. It returns as soon as the module is ready: it has sent
+	 *		+CPIN or Call Ready, or answers the AT probes when it boots with autobaud.
+	 *	
+	 *	@return true if the module is ready before BOOT_TIMEOUT
+	 */
+	bool PowerOn();
+	
+	/** \brief Time from the power on pulse until the module was ready in the last PowerOn()
+	 *
+	 *	@return ms, 0 if the module wasn't ready
+	 */
+	uint32_t GetBootTime();
+	
+	/** \brief Finds the baud rate the module is using and moves both sides to the fastest
+	 *		rate up to maxBaudRate ( AT+IPR ). Every new rate is verified with AT round trips;
+	 *		if it fails the previous one is restored and the next slower rate is tried.
+	 *		Only available with the HardwareSerial constructor.
+	 *
+	 *	@param	IN	fastest rate allowed. e.g. 115200
+	 *	@param	IN	true to save the rate in the module ( AT&W ), so it doesn't need autobaud at the next boot
+	 *
+	 *	@return	baud rate in use, 0 if the module doesn't answer
+	 */
+	uint32_t NegotiateBaudRate(	const uint32_t & maxBaudRate = 115200, 
+								const bool & persist = false );
+	
+	/** \brief Baud rate of the serial port, 0 when it is unknown ( Stream constructor )
+	 */
+	uint32_t GetBaudRate();
+	
+	/** \brief Sets the function that tells the rates the serial port can be set to.
+	 *		NegotiateBaudRate() and the rate probes skip the other ones. HardwareSerial::begin()
+	 *		doesn't report an unsupported rate, the port just keeps the old one.
+	 *
+	 *	@param	IN	function to call. NULL allows every rate.
+	 *	@param	IN	context pointer passed to the function
+	 */
+	void SetBaudRateCheck(	BaudRateCheck baudRateCheck, 
+							void * context = NULL );
+	
+	/** \brief Turns off the GPRS module ( AT+CPOWD ). PowerOn() turns it on again.
+	 *
+	 */
+	void PowerOff();
+	
+	/** \brief Pin of the Arduino connected to the DTR of the module, for SLEEP_DTR
+	 *
+	 *	@param	IN	pin number
+	 */
+	void SetDtrPin( const uint8_t & dtrPin );
+	
+	/** \brief Puts the module in slow clock mode between requests. The bearer and the HTTP
+	 *		session are kept, so the next request doesn't need Configuration(). Get, Post and
+	 *		the sockets wake the module when they start.
+	 *
+	 *	@param	IN	SLEEP_DTR needs SetDtrPin(). SLEEP_AUTO wakes with any serial data.
+	 *
+	 *	@return	true if the module accepts the mode
+	 */
+	bool Sleep( SleepMode mode = SLEEP_AUTO );
+	
+	/** \brief Wakes the module and waits until it answers
+	 *
+	 *	@return	true if the module is awake
+	 */
+	bool Wake();
+	
+	/** \brief True between Sleep() and Wake()
+	 */
+	bool IsSleeping();
+	
+	/** \brief Sets the functionality level ( AT+CFUN ). Out of FUNCTION_FULL the radio is off and
+	 *		the bearer is lost: Configuration() opens it again after FUNCTION_FULL.
+	 *
+	 *	@param	IN	level
+	 *
+	 *	@return	true if the module accepts the level
+	 */
+	bool SetFunctionLevel( FunctionLevel level );
+	
+	/** \brief Wake latency and time awake and asleep
+	 */
+	const PowerStats & GetPowerStats();
+	
+protected:	
+	/** \brief Check if the GPRS module is on.
+	 *
+	 *	@return true if the module is on
+	 */
+	bool IsPowered();
+	
+	/** \brief Waits until the module boots. The boot messages are read as they come;
+	 *		if the module is silent it is probed with AT, and with AT+CPIN? once it answers.
+	 *
+	 *	@return true if the SIM can be read before BOOT_TIMEOUT
+	 */
+	bool WaitReady();
+	
+	/** \brief Checks the module answers at the current rate. Some ATs are needed
+	 *		when the module is in autobaud mode.
+	 */
+	bool AnswersAT();
+	
+	/** \brief Looks for the rate the module answers at, starting with the current one
+	 *
+	 *	@return true if the module answers
+	 */
+	bool ProbeBaudRate();
+	
+	/** \brief Changes the rate of the module ( AT+IPR ) and the serial port and verifies it.
+	 *		On failure the previous rate is restored. A rate the port can't be set to fails
+	 *		without sending AT+IPR.
+	 *
+	 *	@param	IN	new baud rate
+	 *
+	 *	@return true if the module answers at the new rate
+	 */
+	bool SwitchBaudRate( const uint32_t & baudRate );
+	
+	/** \brief Changes the rate of the serial port
+	 */
+	void SetLocalBaudRate( const uint32_t & baudRate );
+	
+	/** \brief True if the serial port can be set to a rate, see SetBaudRateCheck()
+	 */
+	bool CanSetBaudRate( const uint32_t & baudRate );
+		
+	/** \brief Enables SIM900 AT command echo
+	 *	
+	 */
+	void EchoOn( );
+	/** \brief Disables SIM900 AT Command echo
+	 *	
+	 */
+	void EchoOff( );
+	
+	
+	/** \brief Introduces the pin code if is necessary
+	 *	
+	 */
+	bool AT_CPIN();
+	
+
+	/** \brief Check the status of the ME registration
+	 *
+	 *	-Correct Answers
+	 *		+CREG: 0,1 -> Registered, home network
+	 *		+CREG: 0,5 -> Registered, roaming
+	 *	-Waiting Answers
+	 *		+CREG: 0,0 -> Not registered, MT is not currently searching
+	 *		+CREG: 0,2 -> Not registered, MT is currently searching
+	 *		+CREG: 0,4 -> Unknow
+	 *
+	 *	@return true if the action ends OK
+	 */
+	bool AT_CREG();
+
+	/** \brief Check the state of the bearer. Uses the cached state if the bearer is known to be open.
+	 *		The cache is invalidated by DEACT URCs, failed requests and PowerOn()
+	 *
+	 *	@return true if is opened
+	 */
+	bool IsBearerOpen();
+	
+	/** \brief Asks the module for the state of the bearer and updates the cached state and IP address
+	 *
+	 *	@return true if is opened
+	 */
+	bool ProbeBearer();
+	
+
+	/** \brief Bearer settings for applications based on ip
+	 *
+	 *	@return true if the action ends OK
+	 */
+	bool OpenBearer();
+	
+	/** \brief Update the information of the APN provider. This action is only necessary if you changes the SIM service provider
+	 *
+	 *	@return true if the info is introduced and storaged correctly
+	 */
+	bool UpdateBearerInfo();
+
+	/** \brief Initializes the HTTP service (HTTPINIT and CID) if it isn't already.
+	 *
+	 *	@return	true if the HTTP service is ready
+	 */
+	bool StartHttp();
+	
+	/** \brief Terminates and initializes again the HTTP service.
+	 *
+	 *	@return	true if the HTTP service is ready
+	 */
+	bool RestartHttp();
+	
+	/** \brief Terminates the HTTP service after a request, unless a session is open.
+	 *
+	 */
+	void StopHttp();
+
+	/** \brief Checks the module is ready and saves the common parameters of an asynchronous request
+	 *
+	 *	@return	true if the request can start
+	 */
+	bool StartRequest(	const char * host, 
+						const char * path, 
+						const char * url, 
+						RequestCallback requestCallback, 
+						void * context );
+	
+	/** \brief Asynchronous version of StartHttp
+	 */
+	void StartHttpAsync();
+	
+	/** \brief Asynchronous version of RestartHttp. Fails the request if it was already restarted.
+	 */
+	void RestartHttpAsync();
+	
+	/** \brief Sends the first command of the request after the HTTP service is ready: HTTPDATA or URL
+	 */
+	void SetupRequestAsync();
+	
+	/** \brief Sends a chunk of the Post data
+	 */
+	void SendDataAsync();
+	
+	/** \brief Reads the http reply and data length from +HTTPACTION
+	 */
+	void ReceiveActionAsync();
+	
+	/** \brief Requests the next window of the Get reply, or stops the HTTP service if it is all read
+	 */
+	void ReadWindowAsync();
+	
+	/** \brief Reads the size of the window from +HTTPREAD
+	 */
+	void ReceiveWindowSizeAsync();
+	
+	/** \brief Reads the window into a chunk and passes it to the body callback when it is full
+	 *		or the window ends
+	 */
+	void ReceiveDataAsync();
+	
+	/** \brief Asynchronous version of StopHttp
+	 */
+	void StopHttpAsync();
+	
+	/** \brief Ends the asynchronous request and calls the request callback
+	 *
+	 *	@return the final status of the request
+	 */
+	RequestStatus FinishRequest( bool success );
+	
+	/** \brief Sets the answers expected in the next step of the asynchronous request
+	 *
+	 *	@param	IN	state		next step
+	 *	@param	IN	expectedAnswer1	first answer, F() string
+	 *	@param	IN	expectedAnswer2	second answer. Can be NULL.
+	 *	@param	IN	timeout		max time for the step
+	 */
+	void AsyncExpect(	AsyncState state, 
+						const __FlashStringHelper * expectedAnswer1, 
+						const __FlashStringHelper * expectedAnswer2, 
+						const uint16_t & timeout );
+	
+	/** \brief Starts a step of the asynchronous request that moves data instead of waiting
+	 *		for an answer. It has its own timer, renewed by every chunk moved.
+	 *
+	 *	@param	IN	state		next step
+	 *	@param	IN	timeout		max time without data moved
+	 */
+	void AsyncTransfer(	AsyncState state, 
+						const uint16_t & timeout );
+	
+	/** \brief Matches the available input with the expected answers, without waiting.
+	 *
+	 *	@return the number of the answer or 0 if it isn't received yet
+	 */
+	int8_t AsyncReceive();
+	
+	/** \brief Sends a Get petition.
+	 *		After it the reply must be read with ReadBody and the HTTP service stopped.
+	 *
+	 *	@param	OUT	length of the reply
+	 *
+	 *	@return	true if the reply is ready to read
+	 */
+	bool SendGet(	const char * host, 
+					const char * path, 
+					const char * url, 
+					uint16_t & headerHttpReply, 
+					uint32_t & dataLength );
+
+	/** \brief Makes a Get petition  
+	 *
+	 */
+	bool AT_HTTPACTION_GET( uint16_t & httpHeader, 
+							uint32_t & dataLength );
+
+	/** \brief Makes a Post petition
+	 *
+	 */
+	bool AT_HTTPACTION_POST( uint16_t & httpHeader );
+	
+	/** \brief Reads the headers of the reply and keeps its validator in the response cache
+	 *
+	 *	@return	true if the headers are read
+	 */
+	bool AT_HTTPHEAD();
+	
+	/** \brief Serves a 304 reply from the response cache, or starts saving a 200 reply in it
+	 *
+	 *	@param	IN/OUT	Http Reply of the request
+	 *	@param	IN/OUT	length of the reply data
+	 */
+	void CacheReply(	uint16_t & httpHeader, 
+						uint32_t & dataLength );
+	
+	/** \brief Requests a window of the reply
+	 *
+	 *	@param	IN	position of the reply where the window starts
+	 *	@param	IN	size of the window
+	 *
+	 *	@return	true if the window is ready to read with ReceiveData
+	 */
+	bool AT_HTTPREAD(	const uint32_t & start, 
+						const uint16_t & size );
+	
+	/** \brief Writes the AT+HTTPREAD command, without waiting for the answer
+	 */
+	void WriteHttpRead(	const uint32_t & start, 
+						const uint16_t & size );
+	
+	/** \brief Sends the content for POST petition
+	 *
+	 *	@param	IN	size of the data
+	 *	@param	IN	timeout for the operation
+	 *
+	 *	@return	true if the operation ends correctly
+	 */
+	bool AT_HTTPDATA( 	const uint32_t & size, 
+						const int & timeout );
+	
+	/** \brief Writes the AT+HTTPDATA command, without waiting for the answer
+	 */
+	void WriteHttpData( const uint32_t & size, 
+						const int & timeout );
+	
+	/** \brief Sends the data of a POST petition after DOWNLOAD
+	 *
+	 *	@param	IN	length of the data
+	 *	@param	IN	function called for every chunk of data
+	 *	@param	IN	pointer passed to producer
+	 *
+	 *	@return	true if the module accepts the data
+	 */
+	bool SendData(	const uint32_t & dataLength, 
+					DataProducer producer, 
+					void * context );
+	
+	/** \brief Set the http parameters
+	 *
+	 *	@param	IN	host of the server
+	 *	@param	IN	path of the url
+	 *	@param	IN	the other part of the url
+	 *
+	 *	@return	true if the operation ends correctly
+	 */
+	bool AT_HTTPPARA_URL( 	const char * host, 
+							const char * path, 
+							const char * url );
+	
+	/** \brief Sets the Content-Type and Content-Encoding of the Post being sent, if it has them
+	 *
+	 *	@return	true if the operation ends correctly
+	 */
+	bool AT_HTTPPARA_HEADERS();
+	
+	/** \brief Sets the Content-Type and Content-Encoding back to the defaults, so they don't stay
+	 *		in an open session for the next requests
+	 */
+	void ClearHttpHeaders();
+	
+	/** \brief Writes the AT+HTTPPARA="URL" command, without waiting for the answer
+	 */
+	void WriteHttpParaUrl( 	const char * host, 
+							const char * path, 
+							const char * url );
+	
+	/** \brief Writes text inside the quotes of an AT string parameter. A quote or a backslash
+	 *		is sent as \22 or \5C, the escape of 3GPP TS 27.007, so it doesn't end the string.
+	 *		e.g. the ETag "5d8c72a5" of If-None-Match
+	 */
+	void PrintAtString( const char * text );
+	
+	/** \brief Receive the httpheader of a GET or POST petition
+	 *
+	 *	Reply example: +HTTPACTION:1,201,0
+	 *
+	 *	@param	IN	expected answere (HTTPACTION:*,)
+	 *	@param	OUT	httpHeader received for operation
+	 *	@param	OUT	length of the reply data
+	 *	@param	IN	timeout for the operation
+	 *
+	 *	@return	true if the operation ends correctly
+	 */
+	bool GetHttpHeader( const __FlashStringHelper * expected_answer, 
+						uint16_t & httpHeader, 
+						uint32_t & dataLength, 
+						const uint16_t & timeout );
+	
+	/** \brief	Calculates if time for operation is run out
+	 *
+	 *	@return	true after timing out
+	 */
+	bool TimeOut( 	const uint32_t & previousTime, 
+					const uint32_t & timeOut );
+	
+	
+	/** \brief Get the size of the received data from server.
+	 *			Execute this method INMEDIATLY after AT+HTTPREAD operation
+	 *
+	 *	@return	size of the data, 0 if the answer isn't a valid number
+	 */ 
+	uint16_t GetReceiveDataSize( const uint16_t & timeout );
+
+	/** \brief Waits for serial data, in accotated time.
+	 *
+	 */
+	bool WaitingSerialAvailable( 	const uint32_t & previousTime, 
+									const uint32_t & timeout );	
+	
+	/** \brief Waits the given time running the idle callback instead of sleeping.
+	 *
+	 *	@param	IN	time to wait in ms
+	 */
+	void Wait( const uint16_t & time );
+	
+	/** \brief Runs the idle callback, or yield() if it isn't set.
+	 *
+	 */
+	void Idle();
+	
+	/** \brief Reads the reply of a Get in windows and passes it to a callback.
+	 *
+	 *	@param	IN	dataLength	length of the reply
+	 *	@param	IN	callback	function called for every chunk
+	 *	@param	IN	context		pointer passed to callback
+	 *
+	 *	@return	true if the whole reply is read
+	 */
+	bool ReadBody(	const uint32_t & dataLength, 
+					BodyCallback callback, 
+					void * context );
+	
+	/** \brief Receive data from server after Get request and pass it in chunks to a callback.
+	 *			Get the data after send AT+HTTPREAD command
+	 *
+	 *	@param	IN	callback	function called for every chunk
+	 *	@param	IN	context		pointer passed to callback
+	 *	@param	OUT	dataSize	size of the received data
+	 *
+	 *	@return	true if operation finish ok
+	 */
+	bool ReceiveData(	BodyCallback callback, 
+						void * context, 
+						uint16_t & dataSize, 
+						const uint16_t & timeout );
+	
+	/** \brief Reads a char of an AT reply from the module, watching for unsolicited result codes.
+	 *
+	 */
+	char ReadSerial();
+	
+	/** \brief Adds a received char to the current line. Complete lines that are unsolicited
+	 *		result codes are queued, and link losses invalidate the bearer and http state.
+	 *
+	 *	@param	IN	char received
+	 */
+	void ReceiveLine( const char & nextChar );
+	
+	/** \brief Reads the data announced by a +RECEIVE,<link>,<length>: line and gives it to
+	 *		the SocketCallback
+	 *
+	 *	@param	IN	+RECEIVE line
+	 */
+	void ReceiveSocketData( const char * line );
+	
+	/** \brief Updates the statistics of the current class of command with the end of a wait
+	 *
+	 *	@param	IN	expected answer received, NULL if none
+	 *	@param	IN	true if answer is stored in flash (PROGMEM)
+	 *	@param	IN	time the wait started
+	 */
+	void RecordAnswer(	const char * answer, 
+						const bool & inFlash, 
+						const uint32_t & previousTime );
+	
+	/** \brief Counts a retry of the current class of command
+	 */
+	void CountRetry();
+	
+	/** \brief Timeout of the first wait after a command. With ADAPTIVE_TIMEOUTS it is the
+	 *		learned timeout of the class, between ADAPTIVE_TIMEOUT_FLOOR and timeout.
+	 *
+	 *	@param	IN	worst case timeout of the wait
+	 */
+	uint32_t AdaptTimeout( const uint32_t & timeout );
+	
+	/** \brief Learns from the end of the first wait after a command or its data: the response
+	 *		time of an expected answer is a sample, a timeout doubles the next timeout.
+	 *
+	 *	@param	IN	expected answer received, NULL if none
+	 *	@param	IN	true if answer is stored in flash (PROGMEM)
+	 *	@param	IN	time the wait started
+	 */
+	void LearnTimeout(	const char * answer, 
+						const bool & inFlash, 
+						const uint32_t & previousTime );
+	
+	/** \brief Cleans Serial input buffer.
+	 *
+	 */
+	void CleanSerialBuffer();
+
+	/** \brief Send AT commmand and check the answer
+	 *
+	 *	@return 0 if the recuest isn't correct
+	 */
+	int8_t SendATcommand( 	const char* ATcommand, 
+							const char* expectedAnswer, 
+							const unsigned int & timeout );
+
+	/** \brief Send AT command and check the two possible answers
+	 *
+	 *	@return the number of the answer or 0 if it don't exist
+	 */
+	int8_t SendATcommand(	const char* ATcommand, 
+							const char* expectedAnswer1, 
+							const char* expectedAnswer2, 
+							const unsigned int & timeout );
+
+	/** \brief Send AT command and check the N possible answers
+	 *
+	 *	@param	IN	ATcommand		AT command to send
+	 *	@param	IN	expectedAnswers	String array for posibles answers
+	 *	@param	IN	totalAnswers	size of expectedAnswers array
+	 *	@param	IN	timeout			max size for finish the operation
+	 *
+	 *	@return the number of the answer or 0 if it don't exist
+	 */
+	int8_t SendATcommand(	const char* ATcommand,
+							const char ** expectedAnswers,
+							const int & totalAnwers,
+							const unsigned int & timeout );	
+	
+	/** \brief Send AT commmand stored in flash, F("AT"), and check the answer
+	 *
+	 *	@return 0 if the recuest isn't correct
+	 */
+	int8_t SendATcommand( 	const __FlashStringHelper * ATcommand, 
+							const __FlashStringHelper * expectedAnswer, 
+							const unsigned int & timeout );
+
+	/** \brief Send AT command stored in flash and check the two possible answers
+	 *
+	 *	@return the number of the answer or 0 if it don't exist
+	 */
+	int8_t SendATcommand(	const __FlashStringHelper * ATcommand, 
+							const __FlashStringHelper * expectedAnswer1, 
+							const __FlashStringHelper * expectedAnswer2, 
+							const unsigned int & timeout );
+
+	/** \brief Send AT command stored in flash and check the N possible answers
+	 *
+	 *	@param	IN	ATcommand		AT command to send
+	 *	@param	IN	expectedAnswers	array of flash strings for posibles answers
+	 *	@param	IN	totalAnswers	size of expectedAnswers array
+	 *	@param	IN	timeout			max size for finish the operation
+	 *
+	 *	@return the number of the answer or 0 if it don't exist
+	 */
+	int8_t SendATcommand(	const __FlashStringHelper * ATcommand,
+							const __FlashStringHelper ** expectedAnswers,
+							const int & totalAnwers,
+							const unsigned int & timeout );	
+	
+	/** \brief Receive the response after AT Command Send.
+	 *
+	 *	@param	IN	expectedAnswers	String array for posibles answers
+	 *	@param	IN	totalAnswers	size of expectedAnswers array
+	 *	@param	IN	timeout			max size for finish the operation
+	 */
+	int8_t ReceiveATReply(	const char ** expectedAnswers,
+							const int & totalAnwers,
+							const unsigned int & timeout );	
+	
+	/** \brief Receive the response after AT Command Send.
+	 *
+	 *	@param	IN	expectedAnswer	expected answer to receive
+	 *	@param	IN	timeout			max size for finish the operation
+	 */
+	int8_t ReceiveATReply(	const char * expectedAnswer,
+							const unsigned int & timeout );
+	
+	/** \brief Receive the response after AT Command Send and check the two possible answers.
+	 *
+	 *	@return the number of the answer or 0 if it don't exist
+	 */
+	int8_t ReceiveATReply(	const char * expectedAnswer1,
+							const char * expectedAnswer2,
+							const unsigned int & timeout );
+	
+	/** \brief Receive the response after AT Command Send. The answers are read directly from flash.
+	 *
+	 *	@param	IN	expectedAnswers	array of flash strings for posibles answers
+	 *	@param	IN	totalAnswers	size of expectedAnswers array
+	 *	@param	IN	timeout			max size for finish the operation
+	 */
+	int8_t ReceiveATReply(	const __FlashStringHelper ** expectedAnswers,
+							const int & totalAnwers,
+							const unsigned int & timeout );	
+	
+	/** \brief Receive the response after AT Command Send.
+	 *
+	 *	@param	IN	expectedAnswer	expected answer to receive, F() string
+	 *	@param	IN	timeout			max size for finish the operation
+	 */
+	int8_t ReceiveATReply(	const __FlashStringHelper * expectedAnswer,
+							const unsigned int & timeout );
+	
+	/** \brief Receive the response after AT Command Send and check the two possible answers, F() strings.
+	 *
+	 *	@return the number of the answer or 0 if it don't exist
+	 */
+	int8_t ReceiveATReply(	const __FlashStringHelper * expectedAnswer1,
+							const __FlashStringHelper * expectedAnswer2,
+							const unsigned int & timeout );
+	
+	/** \brief Matches the response with the expected answers, stored in RAM or in flash.
+	 *		At most MAX_ANSWERS can be expected.
+	 *
+	 *	@return the number of the answer, 0 if it don't exist or if there are more than MAX_ANSWERS
+	 */
+	int8_t MatchATReply(	const char ** expectedAnswers,
+							const int & totalAnwers,
+							const unsigned int & timeout,
+							const bool & inFlash );
+
+private:
+	const char * _pinCode;
+	const char * _apnName;
+	const char * _apnUser;
+	const char * _apnPass;
+	
+	const uint8_t _enablePin;
+	
+	IdleCallback _idleCallback;
+	MillisFunction _millis;
+	DelayFunction _delay;
+	
+	bool _httpSession;
+	bool _httpInitialized;
+	
+	// Headers of the Post being sent
+	const char * _contentType;
+	bool _contentDeflate;
+	
+	// Response cache: key of the Get, validator sent, body read from or saved in the cache
+	ResponseCacheBase * _cache;
+	uint32_t _cacheKey;
+	bool _cacheConditional;
+	bool _cacheServing;
+	bool _cacheFilling;
+	bool _cachedReply;
+	
+	// Link state
+	bool _bearerOpen;
+	char _ipAddress[16];
+	bool _linkLost;
+	uint16_t _bearerProbes;
+	uint16_t _bearerProbesSaved;
+	
+	uint32_t _bootTime;
+	
+	// Sleep
+	uint8_t _dtrPin;
+	SleepMode _sleepMode;
+	bool _sleeping;
+	uint32_t _powerTime;		// of the last Sleep() or Wake()
+	PowerStats _powerStats;
+	
+	uint16_t _readWindow;
+	
+	// Asynchronous request
+	RequestStatus _requestStatus;
+	AsyncState _asyncState;
+	bool _asyncPost;
+	bool _asyncRetried;
+	const char * _asyncHost;
+	const char * _asyncPath;
+	const char * _asyncUrl;
+	const char * _asyncData;
+	BodyCallback _asyncBody;
+	DataProducer _asyncProducer;
+	void * _asyncProducerContext;
+	RequestCallback _asyncDone;
+	void * _asyncContext;
+	uint32_t _asyncLength;
+	uint32_t _asyncOffset;
+	uint16_t _asyncWindow;
+	uint16_t _asyncHttpReply;
+	uint8_t _asyncDigits;
+	char _asyncChunk[Policy::BODY_CHUNK_SIZE];
+	uint16_t _asyncChunkSize;
+	AnswerMatcher _asyncMatchers[2];
+	uint32_t _asyncTime;
+	uint16_t _asyncTimeout;
+	
+	// Unsolicited result codes
+	struct UrcEvent
+	{
+		UrcCode code;
+		char line[Policy::URC_LINE_SIZE];
+	};
+	
+	UrcCallback _urcCallback;
+	void * _urcContext;
+	char _line[Policy::URC_LINE_SIZE];
+	uint8_t _lineLength;
+	UrcEvent _urcQueue[Policy::URC_QUEUE_SIZE];
+	uint8_t _urcFirst;
+	uint8_t _urcCount;
+	uint16_t _urcDropped;
+	
+	// Sockets
+	bool _socketsStarted;
+	uint8_t _socketsOpen;
+	SocketCallback _socketCallback;
+	void * _socketContext;
+	
+	// Statistics
+	SerialMeter _meter;
+	CommandStats _commandStats[Policy::COMMAND_STATS ? COMMAND_CLASSES : 1];
+	bool _errorSeen;
+	
+	// Adaptive timeouts, ms
+	struct TimeoutEstimate
+	{
+		uint16_t smoothed;
+		uint16_t variation;
+		uint8_t backoff;
+	};
+	
+	// Per class, for the answer to the command line and for the answer after its data
+	TimeoutEstimate _timeouts[Policy::ADAPTIVE_TIMEOUTS ? COMMAND_CLASSES : 1][2];
+	bool _asyncLearning;
+	
+	Stream * sim900Serial;
+	HardwareSerial * _hardwareSerial;
+	uint32_t _baudRate;
+	BaudRateCheck _baudRateCheck;
+	void * _baudRateContext;
+};
+
+
+/** \brief Connection with the default configuration
+ */
+typedef BasicConnection<DefaultConnectionPolicy> Connection;
+
+#include "SIM900Impl.h"
+
+#endif
@@ -0,0 +1,263 @@
+/** SIM900 Basic communication library for SIM900 gsm module.
+ *
+ *	Response cache of Get replies.
+ *
+ *	Released under MIT license.
+ *
+ */
+#include "SIM900Cache.h"
+#include <ctype.h>
+
+const char ResponseCacheBase::ETAG_HEADER[] PROGMEM = "etag";
+const char ResponseCacheBase::LAST_MODIFIED_HEADER[] PROGMEM = "last-modified";
+
+// FNV-1a
+#define KEY_OFFSET_BASIS	2166136261UL
+#define KEY_PRIME			16777619UL
+
+
+ResponseCacheBase::ResponseCacheBase(	char * store,
+										const uint16_t & size ):
+	_store( store ),
+	_size( size ),
+	_used( 0 ),
+	_current( 0 ),
+	_pendingSize( 0 ),
+	_pendingLength( 0 ),
+	_validatorType( VALIDATOR_NONE ),
+	_hits( 0 )
+{
+	_validator[0] = '\0';
+}
+
+
+uint32_t ResponseCacheBase::Key(	const char * host,
+									const char * path,
+									const char * url )
+{
+	const char * parts[] = { host, path, url };
+	uint32_t key = KEY_OFFSET_BASIS;
+
+	// The same text as the URL parameter: host/path/url
+	for ( uint8_t i = 0; i < 3; i++ )
+	{
+		if ( i > 0 )
+			key = ( key ^ '/' ) * KEY_PRIME;
+
+		for ( const char * c = parts[i]; *c; c++ )
+			key = ( key ^ (uint8_t) *c ) * KEY_PRIME;
+	}
+
+	return key;
+}
+
+
+bool ResponseCacheBase::Find( const uint32_t & key )
+{
+	for ( _current = 0; _current < _used; _current += EntrySize( _current ) )
+		if ( ReadEntry( _current ).key == key )
+			return true;
+
+	return false;
+}
+
+
+ResponseCacheBase::ValidatorType ResponseCacheBase::GetValidatorType()
+{
+	if ( _current >= _used )
+		return VALIDATOR_NONE;
+
+	return (ValidatorType) ReadEntry( _current ).validatorType;
+}
+
+
+const char * ResponseCacheBase::GetValidator()
+{
+	if ( _current >= _used )
+		return "";
+
+	return _store + _current + sizeof( EntryHeader );
+}
+
+
+const char * ResponseCacheBase::GetBody()
+{
+	if ( _current >= _used )
+		return NULL;
+
+	return _store + _current + sizeof( EntryHeader ) + ReadEntry( _current ).validatorSize;
+}
+
+
+uint16_t ResponseCacheBase::GetBodyLength()
+{
+	if ( _current >= _used )
+		return 0;
+
+	return ReadEntry( _current ).bodyLength;
+}
+
+
+void ResponseCacheBase::StartHeaders()
+{
+	_validatorType = VALIDATOR_NONE;
+	_validator[0] = '\0';
+}
+
+
+void ResponseCacheBase::ReadHeader( const char * line )
+{
+	ValidatorType type = VALIDATOR_NONE;
+	const char * value;
+
+	if ( ( value = HeaderValue( line, ETAG_HEADER ) ) != NULL )
+		type = VALIDATOR_ETAG;
+	else if ( _validatorType != VALIDATOR_ETAG && ( value = HeaderValue( line, LAST_MODIFIED_HEADER ) ) != NULL )
+		type = VALIDATOR_DATE;
+
+	// A validator that doesn't fit would never match, it is better to have none
+	if ( type == VALIDATOR_NONE || !*value || strlen( value ) >= VALIDATOR_SIZE )
+		return;
+
+	strcpy( _validator, value );
+	_validatorType = type;
+}
+
+
+bool ResponseCacheBase::Begin(	const uint32_t & key,
+								const uint16_t & bodyLength )
+{
+	uint8_t validatorSize = strlen( _validator ) + 1;
+	uint32_t size = sizeof( EntryHeader ) + validatorSize + (uint32_t) bodyLength;
+
+	Remove( key );
+	_pendingSize = 0;
+
+	if ( _validatorType == VALIDATOR_NONE || size > _size )
+		return false;
+
+	while ( _used + size > _size )
+		RemoveAt( 0 );
+
+	EntryHeader header = { key, bodyLength, (uint8_t) _validatorType, validatorSize };
+
+	memcpy( _store + _used, &header, sizeof( header ) );
+	memcpy( _store + _used + sizeof( header ), _validator, validatorSize );
+
+	_current = _used;
+	_pendingSize = size;
+	_pendingLength = 0;
+	return true;
+}
+
+
+void ResponseCacheBase::Append(	const char * chunk,
+								const uint16_t & length )
+{
+	if ( !_pendingSize )
+		return;
+
+	uint16_t bodyLength = ReadEntry( _used ).bodyLength;
+	uint16_t copied = length;
+
+	if ( copied > bodyLength - _pendingLength )
+		copied = bodyLength - _pendingLength;
+
+	memcpy( _store + _used + _pendingSize - bodyLength + _pendingLength, chunk, copied );
+	_pendingLength += copied;
+}
+
+
+bool ResponseCacheBase::Commit()
+{
+	bool complete = _pendingSize && _pendingLength == ReadEntry( _used ).bodyLength;
+
+	if ( complete )
+		_used += _pendingSize;
+
+	_pendingSize = 0;
+	_current = _used;
+	return complete;
+}
+
+
+void ResponseCacheBase::Remove( const uint32_t & key )
+{
+	if ( Find( key ) )
+		RemoveAt( _current );
+
+	_current = _used;
+}
+
+
+void ResponseCacheBase::Clear()
+{
+	_used = 0;
+	_current = 0;
+	_pendingSize = 0;
+}
+
+
+uint16_t ResponseCacheBase::GetHits()
+{
+	return _hits;
+}
+
+
+void ResponseCacheBase::CountHit()
+{
+	_hits++;
+}
+
+
+uint16_t ResponseCacheBase::GetUsed()
+{
+	return _used;
+}
+
+
+ResponseCacheBase::EntryHeader ResponseCacheBase::ReadEntry( const uint16_t & offset )
+{
+	EntryHeader header;
+
+	// The store has no alignment
+	memcpy( &header, _store + offset, sizeof( header ) );
+	return header;
+}
+
+
+uint16_t ResponseCacheBase::EntrySize( const uint16_t & offset )
+{
+	EntryHeader header = ReadEntry( offset );
+
+	return sizeof( header ) + header.validatorSize + header.bodyLength;
+}
+
+
+void ResponseCacheBase::RemoveAt( const uint16_t & offset )
+{
+	uint16_t size = EntrySize( offset );
+
+	memmove( _store + offset, _store + offset + size, _used - offset - size );
+	_used -= size;
+}
+
+
+const char * ResponseCacheBase::HeaderValue(	const char * line,
+												const char * name )
+{
+	char nameChar;
+
+	// Header names are case insensitive
+	while ( ( nameChar = pgm_read_byte( name++ ) ) != '\0' )
+		if ( tolower( *line++ ) != nameChar )
+			return NULL;
+
+	if ( *line++ != ':' )
+		return NULL;
+
+	while ( *line == ' ' )
+		line++;
+
+	return line;
+}
@@ -0,0 +1,192 @@
+/** SIM900 Basic communication library for SIM900 gsm module.
+ *
+ *	Response cache: keeps the body of Get replies with their ETag or Last-Modified, so the
+ *	next Get of the same url asks the server if it changed and, if not ( 304 ), the body
+ *	is read from the cache instead of downloaded again.
+ *
+ *	Released under MIT license.
+ *
+ */
+#pragma once
+#ifndef __ResponseCache_h__
+#define __ResponseCache_h__
+
+#include <Arduino.h>
+
+/** \brief Cache of Get replies in a fixed store. Use ResponseCache<SIZE>.
+ *		Entries are kept in the order they are saved and the oldest are dropped when
+ *		there is no room for a new one.
+ */
+class ResponseCacheBase
+{
+public:
+	enum
+	{
+		// Max chars of an ETag or Last-Modified, with the NUL
+		VALIDATOR_SIZE = 48
+	};
+
+	/** \brief Header that tells if a body changed
+	 */
+	enum ValidatorType
+	{
+		VALIDATOR_NONE,
+		VALIDATOR_ETAG,			// sent back as If-None-Match
+		VALIDATOR_DATE			// Last-Modified, sent back as If-Modified-Since
+	};
+
+	/** \brief Key of a url. Entries are found by this hash, the url isn't stored.
+	 */
+	static uint32_t Key(	const char * host,
+							const char * path,
+							const char * url );
+
+	/** \brief Looks for an entry. The entry found is the current one until the next
+	 *		Find, Begin or Remove.
+	 *
+	 *	@return	true if found
+	 */
+	bool Find( const uint32_t & key );
+
+	/** \brief Validator of the current entry
+	 */
+	ValidatorType GetValidatorType();
+	const char * GetValidator();
+
+	/** \brief Body of the current entry. It isn't NUL terminated.
+	 */
+	const char * GetBody();
+	uint16_t GetBodyLength();
+
+	/** \brief Forgets the validator read from the headers of the last reply
+	 */
+	void StartHeaders();
+
+	/** \brief Reads a line of the headers of a reply and keeps its validator.
+	 *		ETag is preferred to Last-Modified.
+	 *
+	 *	@param	IN	header line without CR LF. e.g. ETag: "5d8c72a5"
+	 */
+	void ReadHeader( const char * line );
+
+	/** \brief Starts saving a body with the validator read from the headers.
+	 *		The old entry of the key is removed even if the new one isn't saved.
+	 *
+	 *	@param	IN	key of the url
+	 *	@param	IN	length of the body
+	 *
+	 *	@return	false if the reply has no validator or doesn't fit in the store
+	 */
+	bool Begin(	const uint32_t & key,
+				const uint16_t & bodyLength );
+
+	/** \brief Adds a chunk of the body started with Begin
+	 */
+	void Append(	const char * chunk,
+					const uint16_t & length );
+
+	/** \brief Saves the entry started with Begin if the whole body was added
+	 *
+	 *	@return	true if saved
+	 */
+	bool Commit();
+
+	/** \brief Removes the entry of a key
+	 */
+	void Remove( const uint32_t & key );
+
+	/** \brief Removes all the entries
+	 */
+	void Clear();
+
+	/** \brief Number of replies served from the cache
+	 */
+	uint16_t GetHits();
+
+	/** \brief Count a reply served from the cache
+	 */
+	void CountHit();
+
+	/** \brief Bytes of the store in use
+	 */
+	uint16_t GetUsed();
+
+protected:
+	/** \brief Constructuor
+	 *
+	 *	@param	IN	store of the entries
+	 *	@param	IN	size of store
+	 */
+	ResponseCacheBase(	char * store,
+						const uint16_t & size );
+
+	/** \brief Fixed part of an entry. The validator, with its NUL, and the body follow it.
+	 */
+	struct EntryHeader
+	{
+		uint32_t key;
+		uint16_t bodyLength;
+		uint8_t validatorType;
+		uint8_t validatorSize;
+	};
+
+	/** \brief Reads the fixed part of the entry at an offset
+	 */
+	EntryHeader ReadEntry( const uint16_t & offset );
+
+	/** \brief Size of the entry at an offset
+	 */
+	uint16_t EntrySize( const uint16_t & offset );
+
+	/** \brief Removes the entry at an offset, moving the next ones back
+	 */
+	void RemoveAt( const uint16_t & offset );
+
+	/** \brief If the line is the header name, followed by ':', gives its value
+	 *
+	 *	@param	IN	header line
+	 *	@param	IN	header name in flash memory, lower case
+	 *
+	 *	@return	the value without leading spaces or NULL
+	 */
+	static const char * HeaderValue(	const char * line,
+										const char * name );
+
+	static const char ETAG_HEADER[] PROGMEM;
+	static const char LAST_MODIFIED_HEADER[] PROGMEM;
+
+private:
+	char * _store;
+	uint16_t _size;
+	uint16_t _used;
+
+	// Current entry, _used if none
+	uint16_t _current;
+
+	// Entry being saved: it is written after the used part
+	uint16_t _pendingSize;
+	uint16_t _pendingLength;
+
+	// Validator of the last reply
+	ValidatorType _validatorType;
+	char _validator[VALIDATOR_SIZE];
+
+	uint16_t _hits;
+};
+
+
+/** \brief Response cache of SIZE bytes of RAM
+ */
+template <uint16_t SIZE>
+class ResponseCache : public ResponseCacheBase
+{
+public:
+	ResponseCache() :
+		ResponseCacheBase( _buffer, SIZE )
+	{}
+
+private:
+	char _buffer[SIZE];
+};
+
+#endif
@@ -0,0 +1,276 @@
+/** SIM900 Basic communication library for SIM900 gsm module.
+ *
+ *	Deflate compressor for the Post data.
+ *
+ *	Released under MIT license.
+ *
+ */
+#include "SIM900Deflate.h"
+
+// Deflate limits ( RFC 1951 )
+#define MIN_MATCH			3
+#define MAX_MATCH			258
+#define END_OF_BLOCK		256
+#define FIRST_LENGTH_CODE	257
+#define ADLER_MODULUS		65521
+
+
+Deflate::Deflate(	const char * data,
+					const uint32_t & length,
+					const uint16_t & window ):
+	_data( data ),
+	_length( length ),
+	_window( window )
+{
+	Rewind();
+}
+
+
+void Deflate::Rewind()
+{
+	_stage = STAGE_HEADER;
+	_position = 0;
+	_bits = 0;
+	_bitCount = 0;
+	_pendingDistance = 0;
+	_checksumA = 1;
+	_checksumB = 0;
+}
+
+
+uint32_t Deflate::CompressedLength()
+{
+	char chunk[32];
+	uint32_t length = 0;
+	uint16_t size;
+
+	Rewind();
+
+	do
+	{
+		size = Read( chunk, sizeof( chunk ) );
+		length += size;
+	} while ( size == sizeof( chunk ) );
+
+	Rewind();
+	return length;
+}
+
+
+uint16_t Deflate::Read(	char * buffer,
+						uint16_t size )
+{
+	uint16_t length = 0;
+
+	while ( length < size )
+	{
+		// Whole bytes go out first, so there is always room for the next code
+		if ( _bitCount >= 8 )
+		{
+			buffer[length++] = _bits & 0xFF;
+			_bits >>= 8;
+			_bitCount -= 8;
+			continue;
+		}
+
+		if ( _pendingDistance )
+		{
+			PutDistance( _pendingDistance );
+			_pendingDistance = 0;
+			continue;
+		}
+
+		switch ( _stage )
+		{
+			case STAGE_HEADER:
+				// zlib header: deflate, no dictionary. Then one final block with fixed codes
+				PutBits( 0x78, 8 );
+				PutBits( 0x01, 8 );
+				_stage = STAGE_DATA;
+				break;
+
+			case STAGE_DATA:
+				if ( _position == 0 && _bitCount == 0 )
+				{
+					PutBits( 1, 1 );	// BFINAL
+					PutBits( 1, 2 );	// BTYPE fixed Huffman
+				}
+
+				if ( _position < _length )
+				{
+					uint16_t distance;
+					uint16_t match = FindMatch( distance );
+
+					if ( match )
+					{
+						PutLength( match );
+						_pendingDistance = distance;
+						Consume( match );
+					}
+					else
+					{
+						PutSymbol( (uint8_t) _data[_position] );
+						Consume( 1 );
+					}
+				}
+				else
+				{
+					PutSymbol( END_OF_BLOCK );
+
+					// The checksum starts on a byte boundary
+					_bitCount = ( _bitCount + 7 ) & ~7;
+					_stage = STAGE_CHECKSUM_HIGH;
+				}
+				break;
+
+			case STAGE_CHECKSUM_HIGH:
+				// Adler-32, most significant byte first
+				PutBits( _checksumB >> 8, 8 );
+				PutBits( _checksumB & 0xFF, 8 );
+				_stage = STAGE_CHECKSUM_LOW;
+				break;
+
+			case STAGE_CHECKSUM_LOW:
+				PutBits( _checksumA >> 8, 8 );
+				PutBits( _checksumA & 0xFF, 8 );
+				_stage = STAGE_DONE;
+				break;
+
+			default:
+				return length;
+		}
+	}
+
+	return length;
+}
+
+
+uint16_t Deflate::ReadCompressed(	char * buffer,
+									uint16_t size,
+									void * context )
+{
+	return ( (Deflate *) context )->Read( buffer, size );
+}
+
+
+void Deflate::PutBits(	const uint32_t & bits,
+						const uint8_t & count )
+{
+	_bits |= bits << _bitCount;
+	_bitCount += count;
+}
+
+
+void Deflate::PutCode(	const uint16_t & code,
+						const uint8_t & count )
+{
+	uint16_t reversed = 0;
+
+	for ( uint8_t i = 0; i < count; i++ )
+		reversed |= ( ( code >> i ) & 1 ) << ( count - 1 - i );
+
+	PutBits( reversed, count );
+}
+
+
+void Deflate::PutSymbol( const uint16_t & symbol )
+{
+	// Fixed Huffman codes ( RFC 1951 3.2.6 )
+	if ( symbol < 144 )
+		PutCode( 0x30 + symbol, 8 );
+	else if ( symbol < 256 )
+		PutCode( 0x190 + symbol - 144, 9 );
+	else if ( symbol < 280 )
+		PutCode( symbol - 256, 7 );
+	else
+		PutCode( 0xC0 + symbol - 280, 8 );
+}
+
+
+void Deflate::PutLength( const uint16_t & length )
+{
+	uint16_t base = MIN_MATCH;
+
+	if ( length == MAX_MATCH )
+	{
+		PutSymbol( FIRST_LENGTH_CODE + 28 );
+		return;
+	}
+
+	// Codes 257-264 have no extra bits, then every 4 codes have one more
+	for ( uint8_t code = 0; code < 28; code++ )
+	{
+		uint8_t extra = code < 8 ? 0 : ( code - 4 ) / 4;
+
+		if ( length < base + ( 1 << extra ) )
+		{
+			PutSymbol( FIRST_LENGTH_CODE + code );
+			PutBits( length - base, extra );
+			return;
+		}
+
+		base += 1 << extra;
+	}
+}
+
+
+void Deflate::PutDistance( const uint16_t & distance )
+{
+	uint16_t base = 1;
+
+	// Codes 0-3 have no extra bits, then every 2 codes have one more
+	for ( uint8_t code = 0; code < 30; code++ )
+	{
+		uint8_t extra = code < 4 ? 0 : ( code - 2 ) / 2;
+
+		if ( distance < base + ( (uint32_t) 1 << extra ) )
+		{
+			PutCode( code, 5 );
+			PutBits( distance - base, extra );
+			return;
+		}
+
+		base += 1 << extra;
+	}
+}
+
+
+uint16_t Deflate::FindMatch( uint16_t & distance )
+{
+	uint16_t best = 0;
+	uint32_t start = _position > _window ? _position - _window : 0;
+	uint32_t available = _length - _position;
+
+	if ( available > MAX_MATCH )
+		available = MAX_MATCH;
+
+	if ( available < MIN_MATCH )
+		return 0;
+
+	// The nearest match is tried first, it has the shortest distance code
+	for ( uint32_t candidate = _position; candidate-- > start && best < available; )
+	{
+		uint16_t length = 0;
+
+		while ( length < available && _data[candidate + length] == _data[_position + length] )
+			length++;
+
+		if ( length > best )
+		{
+			best = length;
+			distance = _position - candidate;
+		}
+	}
+
+	return best >= MIN_MATCH ? best : 0;
+}
+
+
+void Deflate::Consume( const uint16_t & count )
+{
+	for ( uint16_t i = 0; i < count; i++ )
+	{
+		_checksumA = ( (uint32_t) _checksumA + (uint8_t) _data[_position++] ) % ADLER_MODULUS;
+		_checksumB = ( (uint32_t) _checksumB + _checksumA ) % ADLER_MODULUS;
+	}
+}
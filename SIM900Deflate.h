@@ -0,0 +1,118 @@
+/** SIM900 Basic communication library for SIM900 gsm module.
+ *
+ *	Deflate compressor for the Post data: zlib format ( Content-Encoding: deflate ) with
+ *	the fixed Huffman codes. It reads the data in memory and needs no buffer, the matches
+ *	are searched in the data already sent.
+ *
+ *	Released under MIT license.
+ *
+ */
+#pragma once
+#ifndef __Deflate_h__
+#define __Deflate_h__
+
+#include <Arduino.h>
+
+class Deflate
+{
+public:
+	/** \brief Constructuor
+	 *
+	 *	@param	IN	data to compress. It must be valid until the compression ends.
+	 *	@param	IN	size of the data
+	 *	@param	IN	max distance searched back for repeated text, up to 32768. Bigger compresses more but is slower.
+	 */
+	Deflate(	const char * data,
+				const uint32_t & length,
+				const uint16_t & window = 256 );
+
+	/** \brief Starts the compression again from the beginning
+	 */
+	void Rewind();
+
+	/** \brief Size of the compressed data. It compresses the whole data, so it takes
+	 *		as long as sending it, and rewinds.
+	 */
+	uint32_t CompressedLength();
+
+	/** \brief Writes the next compressed bytes
+	 *
+	 *	@param	OUT	buffer for the compressed data
+	 *	@param	IN	size of buffer
+	 *
+	 *	@return	bytes written, less than size only at the end
+	 */
+	uint16_t Read(	char * buffer,
+					uint16_t size );
+
+	/** \brief Connection::DataProducer that reads from a Deflate. context is the Deflate.
+	 */
+	static uint16_t ReadCompressed(	char * buffer,
+									uint16_t size,
+									void * context );
+
+protected:
+	/** \brief Parts of the zlib stream
+	 */
+	enum Stage
+	{
+		STAGE_HEADER,
+		STAGE_DATA,
+		STAGE_CHECKSUM_HIGH,
+		STAGE_CHECKSUM_LOW,
+		STAGE_DONE
+	};
+
+	/** \brief Adds bits to the output, the least significant first
+	 */
+	void PutBits(	const uint32_t & bits,
+					const uint8_t & count );
+
+	/** \brief Adds a Huffman code to the output, the most significant bit first
+	 */
+	void PutCode(	const uint16_t & code,
+					const uint8_t & count );
+
+	/** \brief Adds a literal/length symbol with its fixed Huffman code
+	 *
+	 *	@param	IN	symbol 0 to 287
+	 */
+	void PutSymbol( const uint16_t & symbol );
+
+	/** \brief Adds the code of a match length, 3 to 258, and its extra bits
+	 */
+	void PutLength( const uint16_t & length );
+
+	/** \brief Adds the code of a match distance, 1 to 32768, and its extra bits
+	 */
+	void PutDistance( const uint16_t & distance );
+
+	/** \brief Finds the longest text already read that matches the text at the position
+	 *
+	 *	@param	OUT	distance back to the match
+	 *
+	 *	@return	length of the match, 0 if it is shorter than 3
+	 */
+	uint16_t FindMatch( uint16_t & distance );
+
+	/** \brief Moves the position and adds the data to the checksum
+	 */
+	void Consume( const uint16_t & count );
+
+private:
+	const char * _data;
+	uint32_t _length;
+	uint16_t _window;
+
+	Stage _stage;
+	uint32_t _position;
+	uint32_t _bits;
+	uint8_t _bitCount;
+	uint16_t _pendingDistance;
+
+	// Adler-32
+	uint16_t _checksumA;
+	uint16_t _checksumB;
+};
+
+#endif
@@ -0,0 +1,62 @@
+/** SIM900 Basic communication library for SIM900 gsm module.
+ *
+ *	Journal storage in the EEPROM of the Arduino.
+ *
+ *	Released under MIT license.
+ *
+ */
+#pragma once
+#ifndef __EepromStorage_h__
+#define __EepromStorage_h__
+
+#include <EEPROM.h>
+#include "SIM900Journal.h"
+
+/** \brief A part of the EEPROM used as JournalStorage
+ */
+class EepromStorage : public JournalStorage
+{
+public:
+	/** \brief Constructuor
+	 *
+	 *	@param	IN	first address of the EEPROM used
+	 *	@param	IN	bytes used
+	 */
+	EepromStorage(	const uint16_t & start,
+					const uint16_t & size ):
+		_start( start ),
+		_size( size )
+	{}
+
+	uint32_t Size()
+	{
+		return _size;
+	}
+
+	bool Read(	const uint32_t & address,
+				void * buffer,
+				const uint16_t & length )
+	{
+		for ( uint16_t i = 0; i < length; i++ )
+			( (uint8_t *) buffer )[i] = EEPROM.read( _start + address + i );
+
+		return true;
+	}
+
+	bool Write(	const uint32_t & address,
+				const void * data,
+				const uint16_t & length )
+	{
+		// update() skips the bytes that don't change, they don't wear the cell
+		for ( uint16_t i = 0; i < length; i++ )
+			EEPROM.update( _start + address + i, ( (const uint8_t *) data )[i] );
+
+		return true;
+	}
+
+private:
+	uint16_t _start;
+	uint16_t _size;
+};
+
+#endif
@@ -0,0 +1,75 @@
+/** SIM900 Basic communication library for SIM900 gsm module.
+ *
+ *	Journal storage in a file, for hosts with stdio: tests and gateways.
+ *
+ *	Released under MIT license.
+ *
+ */
+#pragma once
+#ifndef __FileStorage_h__
+#define __FileStorage_h__
+
+#include <stdio.h>
+#include "SIM900Journal.h"
+
+/** \brief A file of fixed size used as JournalStorage. A new file is filled with 0xFF,
+ *		like an erased EEPROM.
+ */
+class FileStorage : public JournalStorage
+{
+public:
+	/** \brief Constructuor. Opens the file or creates it.
+	 *
+	 *	@param	IN	name of the file
+	 *	@param	IN	size of the storage
+	 */
+	FileStorage(	const char * fileName,
+					const uint32_t & size ):
+		_size( size )
+	{
+		_file = fopen( fileName, "r+b" );
+
+		if ( !_file && ( _file = fopen( fileName, "w+b" ) ) != NULL )
+			for ( uint32_t i = 0; i < size; i++ )
+				fputc( 0xFF, _file );
+	}
+
+	~FileStorage()
+	{
+		if ( _file )
+			fclose( _file );
+	}
+
+	/** \brief True if the file is open
+	 */
+	bool IsOpen()
+	{
+		return _file != NULL;
+	}
+
+	uint32_t Size()
+	{
+		return _file ? _size : 0;
+	}
+
+	bool Read(	const uint32_t & address,
+				void * buffer,
+				const uint16_t & length )
+	{
+		return _file && fseek( _file, address, SEEK_SET ) == 0 && fread( buffer, 1, length, _file ) == length;
+	}
+
+	bool Write(	const uint32_t & address,
+				const void * data,
+				const uint16_t & length )
+	{
+		// Flushed at once, so a record survives the end of the process
+		return _file && fseek( _file, address, SEEK_SET ) == 0 && fwrite( data, 1, length, _file ) == length && fflush( _file ) == 0;
+	}
+
+private:
+	FILE * _file;
+	uint32_t _size;
+};
+
+#endif
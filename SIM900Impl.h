@@ -0,0 +1,2793 @@
+/** SIM900 Basic communication library for SIM900 gsm module. 
+ *
+ *	Implementation of BasicConnection. It is included by SIM900.h, don't include it directly.
+ *
+ *	Released under MIT license.		
+ *
+ */
+#pragma once
+#ifndef __ConnectionImpl_h__
+#define __ConnectionImpl_h__
+
+
+template <class Policy>
+BasicConnection<Policy>::BasicConnection(	const char * pinCode, 
+						const char * apnName,  
+						const char * apnUser, 
+						const char * apnPass, 
+						const uint8_t & enablePin, 
+						HardwareSerial & serialPort,
+						uint32_t baudRate ):
+	BasicConnection( pinCode, apnName, apnUser, apnPass, enablePin, (Stream &) serialPort )
+{
+	_hardwareSerial = &serialPort;
+	_baudRate = baudRate;
+	serialPort.begin( baudRate );
+}
+
+
+template <class Policy>
+BasicConnection<Policy>::BasicConnection(	const char * pinCode, 
+						const char * apnName,  
+						const char * apnUser, 
+						const char * apnPass, 
+						const uint8_t & enablePin, 
+						Stream & serialPort ):
+	_pinCode( pinCode ),
+	_apnName( apnName ),
+	_apnUser( apnUser ),
+	_apnPass( apnPass ),
+	_enablePin( enablePin ),
+	_idleCallback( NULL ),
+	_millis( millis ),
+	_delay( delay ),
+	_httpSession( false ),
+	_httpInitialized( false ),
+	_contentType( NULL ),
+	_contentDeflate( false ),
+	_cache( NULL ),
+	_cacheKey( 0 ),
+	_cacheConditional( false ),
+	_cacheServing( false ),
+	_cacheFilling( false ),
+	_cachedReply( false ),
+	_bearerOpen( false ),
+	_linkLost( false ),
+	_bearerProbes( 0 ),
+	_bearerProbesSaved( 0 ),
+	_bootTime( 0 ),
+	_dtrPin( 0xFF ),
+	_sleepMode( SLEEP_NONE ),
+	_sleeping( false ),
+	_powerTime( 0 ),
+	_readWindow( 100 ),
+	_requestStatus( REQUEST_IDLE ),
+	_asyncState( ASYNC_IDLE ),
+	_urcCallback( NULL ),
+	_urcContext( NULL ),
+	_lineLength( 0 ),
+	_urcFirst( 0 ),
+	_urcCount( 0 ),
+	_urcDropped( 0 ),
+	_socketsStarted( false ),
+	_socketsOpen( 0 ),
+	_socketCallback( NULL ),
+	_socketContext( NULL ),
+	_errorSeen( false ),
+	_asyncLearning( false )
+{
+	_ipAddress[0] = '\0';
+	memset( &_powerStats, 0, sizeof( _powerStats ) );
+	pinMode( enablePin, OUTPUT );
+	
+	sim900Serial = &serialPort;
+	_hardwareSerial = NULL;
+	_baudRate = 0;
+	_baudRateCheck = NULL;
+	_baudRateContext = NULL;
+	
+	// The meter sits between the library and the module only when it is used
+	if ( Policy::COMMAND_STATS || Policy::ADAPTIVE_TIMEOUTS )
+	{
+		_meter.stream = &serialPort;
+		_meter.stats = Policy::COMMAND_STATS ? _commandStats : NULL;
+		sim900Serial = &_meter;
+	}
+	
+	ResetCommandStats();
+	memset( _timeouts, 0, sizeof( _timeouts ) );
+}
+
+
+template <class Policy>
+bool BasicConnection<Policy>::Configuration() 
+{	
+	if ( !sim900Serial )					
+		return false;
+	
+	// A sleeping module doesn't answer: the power pulse would turn it off
+	if ( _sleeping && !Wake() )
+		return false;
+		
+	if ( !IsPowered() )		
+		if ( !PowerOn() )
+			return false;
+	
+	if ( !AT_CPIN() )
+		return false;
+	
+	if ( !AT_CREG() )
+		return false;	
+			
+	if ( !OpenBearer() )
+		return false;
+	
+	return true;
+}
+
+
+template <class Policy>
+bool BasicConnection<Policy>::Get(	const char * host, 
+						const char * path, 
+						const char * url, 
+						uint16_t & headerHttpReply, 
+						char *& bodyReply, 
+						const int /* port */ )
+{
+	uint32_t dataLength;
+	
+	bodyReply = NULL;
+	
+	if ( !SendGet( host, path, url, headerHttpReply, dataLength ) )
+		return false;
+	
+	// The length comes from the server: bound it before allocating
+	if ( dataLength > Policy::BODY_ALLOCATION_MAX || dataLength >= 0xFFFF )
+	{
+		StopHttp();
+		return false;
+	}
+	
+	bodyReply = new char[dataLength+1];
+	if ( !bodyReply )
+	{
+		StopHttp();
+		return false;
+	}
+	
+	BufferSink sink = { bodyReply, (uint16_t)( dataLength + 1 ), 0 };
+	bodyReply[0] = '\0';
+	
+	bool received = ReadBody( dataLength, WriteToBuffer, &sink );
+	StopHttp();
+	return received;
+}
+
+
+template <class Policy>
+bool BasicConnection<Policy>::Get(	const char * host, 
+						const char * path, 
+						const char * url, 
+						uint16_t & headerHttpReply, 
+						char * body, 
+						const uint16_t & bodySize, 
+						uint16_t & bodyLength, 
+						const int port )
+{
+	BufferSink sink = { body, bodySize, 0 };
+	
+	if ( bodySize > 0 )
+		body[0] = '\0';
+	
+	bool received = Get( host, path, url, headerHttpReply, WriteToBuffer, &sink, port );
+	bodyLength = sink.length;
+	
+	return received;
+}
+
+
+template <class Policy>
+bool BasicConnection<Policy>::Get(	const char * host, 
+						const char * path, 
+						const char * url, 
+						uint16_t & headerHttpReply, 
+						Print & sink, 
+						const int port )
+{
+	return Get( host, path, url, headerHttpReply, WriteToPrint, &sink, port );
+}
+
+
+template <class Policy>
+bool BasicConnection<Policy>::Get(	const char * host, 
+						const char * path, 
+						const char * url, 
+						uint16_t & headerHttpReply, 
+						BodyCallback callback, 
+						void * context, 
+						const int /* port */ )
+{
+	uint32_t dataLength;
+	
+	if ( !SendGet( host, path, url, headerHttpReply, dataLength ) )
+		return false;
+	
+	bool received = ReadBody( dataLength, callback, context );
+	StopHttp();
+	return received;
+}
+
+
+template <class Policy>
+bool BasicConnection<Policy>::Post(	const char * host, 
+						const char * path, 
+						const char * url, 
+						const char * data, 
+						uint16_t & headerHttpReply, 
+						const int port )
+{
+	return Post( host, path, url, strlen( data ), ReadFromMemory, &data, headerHttpReply, port );
+}
+
+
+template <class Policy>
+bool BasicConnection<Policy>::Post(	const char * host, 
+						const char * path, 
+						const char * url, 
+						Stream & source, 
+						const uint32_t & dataLength, 
+						uint16_t & headerHttpReply, 
+						const int port )
+{
+	return Post( host, path, url, dataLength, ReadFromStream, &source, headerHttpReply, port );
+}
+
+
+template <class Policy>
+bool BasicConnection<Policy>::Post(	const char * host, 
+						const char * path, 
+						const char * url, 
+						const uint32_t & dataLength, 
+						DataProducer producer, 
+						void * context, 
+						uint16_t & headerHttpReply, 
+						const int /* port */ )
+{
+	if ( !sim900Serial || _requestStatus == REQUEST_RUNNING )
+		return false;
+	
+	if ( _sleeping && !Wake() )
+		return false;
+		
+	if ( !OpenBearer() )
+		if ( !Configuration() )
+			return false;
+
+	if ( !StartHttp() || !AT_HTTPPARA_HEADERS() )
+		return false;
+
+	// If the modem dropped the HTTP session the data is refused, so restart it once
+	if ( AT_HTTPDATA( dataLength, Policy::DATA_INPUT_TIME ) || ( RestartHttp() && AT_HTTPPARA_HEADERS() && AT_HTTPDATA( dataLength, Policy::DATA_INPUT_TIME ) ) )
+	{
+		if ( SendData( dataLength, producer, context ) )
+		{
+			if ( AT_HTTPPARA_URL( host, path, url ) )
+			{
+				if ( AT_HTTPACTION_POST( headerHttpReply ) )
+				{
+					StopHttp();
+					return true;
+				}
+			}
+		}
+	}
+
+	_httpInitialized = false;
+	_bearerOpen = false;
+	return false;
+}
+
+
+template <class Policy>
+bool BasicConnection<Policy>::PostCompressed(	const char * host, 
+								const char * path, 
+								const char * url, 
+								const char * data, 
+								const char * contentType, 
+								uint16_t & headerHttpReply, 
+								const int port )
+{
+	uint32_t dataLength = strlen( data );
+	Deflate deflate( data, dataLength, Policy::COMPRESSION_WINDOW );
+	uint32_t compressedLength = deflate.CompressedLength();
+	bool sent;
+	
+	_contentType = contentType;
+	_contentDeflate = compressedLength < dataLength;
+	
+	if ( _contentDeflate )
+		sent = Post( host, path, url, compressedLength, Deflate::ReadCompressed, &deflate, headerHttpReply, port );
+	else
+		sent = Post( host, path, url, dataLength, ReadFromMemory, &data, headerHttpReply, port );
+	
+	// The HTTPPARA values last until HTTPTERM
+	if ( _httpInitialized )
+		ClearHttpHeaders();
+	
+	_contentType = NULL;
+	_contentDeflate = false;
+	return sent;
+}
+
+
+template <class Policy>
+bool BasicConnection<Policy>::StartGet(	const char * host, 
+							const char * path, 
+							const char * url, 
+							BodyCallback bodyCallback, 
+							RequestCallback requestCallback, 
+							void * context )
+{
+	if ( !StartRequest( host, path, url, requestCallback, context ) )
+		return false;
+	
+	_asyncPost = false;
+	_asyncBody = bodyCallback;
+	
+	StartHttpAsync();
+	return true;
+}
+
+
+template <class Policy>
+bool BasicConnection<Policy>::StartPost(	const char * host, 
+							const char * path, 
+							const char * url, 
+							const char * data, 
+							RequestCallback requestCallback, 
+							void * context )
+{
+	if ( _requestStatus == REQUEST_RUNNING )
+		return false;
+	
+	// The string pointer is kept in the connection, ReadFromMemory advances it
+	_asyncData = data;
+	
+	return StartPost( host, path, url, strlen( data ), ReadFromMemory, &_asyncData, requestCallback, context );
+}
+
+
+template <class Policy>
+bool BasicConnection<Policy>::StartPost(	const char * host, 
+							const char * path, 
+							const char * url, 
+							const uint32_t & dataLength, 
+							DataProducer producer, 
+							void * producerContext, 
+							RequestCallback requestCallback, 
+							void * context )
+{
+	if ( !StartRequest( host, path, url, requestCallback, context ) )
+		return false;
+	
+	_asyncPost = true;
+	_asyncProducer = producer;
+	_asyncProducerContext = producerContext;
+	_asyncLength = dataLength;
+	
+	StartHttpAsync();
+	return true;
+}
+
+
+template <class Policy>
+ConnectionBase::RequestStatus BasicConnection<Policy>::Poll()
+{
+	int8_t answer;
+	
+	if ( _requestStatus != REQUEST_RUNNING )
+		return _requestStatus;
+	
+	// Answers that arrived before this call are read before the timer is checked: a late
+	// Poll() isn't a timeout of the module
+	if ( TimeOut( _asyncTime, _asyncTimeout ) && !sim900Serial->available() )
+	{
+		if ( _asyncLearning )
+			LearnTimeout( NULL, true, _asyncTime );
+		RecordAnswer( NULL, true, _asyncTime );
+		
+		// The OK after HTTPREAD data and the HTTPTERM result are ignored like in the blocking requests
+		if ( _asyncState == ASYNC_HTTPREAD_OK )
+			ReadWindowAsync();
+		else
+			FinishRequest( _asyncState == ASYNC_HTTPTERM );
+		
+		return _requestStatus;
+	}
+	
+	switch ( _asyncState )
+	{
+		case ASYNC_HTTPINIT:
+			answer = AsyncReceive();
+			if ( answer == 1 )
+			{
+				sim900Serial->println( F("AT+HTTPPARA=\"CID\",1") );
+				AsyncExpect( ASYNC_CID, F("OK"), F("ERROR"), Policy::CID_TIMEOUT );
+			}
+			else if ( answer == 2 )
+				RestartHttpAsync();
+			break;
+			
+		case ASYNC_HTTPTERM_RESTART:
+			if ( AsyncReceive() )
+			{
+				sim900Serial->println( F("AT+HTTPINIT") );
+				AsyncExpect( ASYNC_HTTPINIT, F("OK"), F("ERROR"), Policy::HTTPINIT_TIMEOUT );
+			}
+			break;
+			
+		case ASYNC_CID:
+			answer = AsyncReceive();
+			if ( answer == 1 )
+			{
+				_httpInitialized = true;
+				SetupRequestAsync();
+			}
+			else if ( answer == 2 )
+				FinishRequest( false );
+			break;
+			
+		case ASYNC_HTTPDATA:
+			answer = AsyncReceive();
+			if ( answer == 1 )
+			{
+				_asyncOffset = 0;
+				AsyncTransfer( ASYNC_DATA, Policy::DATA_TIMEOUT );
+			}
+			else if ( answer == 2 )
+				RestartHttpAsync();
+			break;
+			
+		case ASYNC_DATA:
+			SendDataAsync();
+			break;
+			
+		case ASYNC_DATA_OK:
+			if ( AsyncReceive() )
+			{
+				WriteHttpParaUrl( _asyncHost, _asyncPath, _asyncUrl );
+				AsyncExpect( ASYNC_URL, F("OK"), F("ERROR"), Policy::URL_TIMEOUT );
+			}
+			break;
+			
+		case ASYNC_URL:
+			answer = AsyncReceive();
+			if ( answer == 1 )
+			{
+				if ( _asyncPost )
+				{
+					sim900Serial->println( F("AT+HTTPACTION=1") );
+					AsyncExpect( ASYNC_ACTION, F("+HTTPACTION:1,"), NULL, Policy::HTTPACTION_TIMEOUT );
+				}
+				else
+				{
+					sim900Serial->println( F("AT+HTTPACTION=0") );
+					AsyncExpect( ASYNC_ACTION, F("+HTTPACTION:0,"), NULL, Policy::HTTPACTION_TIMEOUT );
+				}
+			}
+			else if ( answer == 2 )
+				RestartHttpAsync();
+			break;
+			
+		case ASYNC_ACTION:
+			if ( AsyncReceive() )
+			{
+				_asyncHttpReply = 0;
+				_asyncDigits = 0;
+				if ( !_asyncPost )
+					_asyncLength = 0;
+				_asyncState = ASYNC_ACTION_REPLY;
+			}
+			break;
+			
+		case ASYNC_ACTION_REPLY:
+			ReceiveActionAsync();
+			break;
+			
+		case ASYNC_HTTPREAD:
+			answer = AsyncReceive();
+			if ( answer == 1 )
+			{
+				_asyncWindow = 0;
+				_asyncChunkSize = 0;
+				_asyncState = ASYNC_HTTPREAD_SIZE;
+			}
+			else if ( answer == 2 )
+				FinishRequest( false );
+			break;
+			
+		case ASYNC_HTTPREAD_SIZE:
+			ReceiveWindowSizeAsync();
+			break;
+			
+		case ASYNC_HTTPREAD_DATA:
+			ReceiveDataAsync();
+			break;
+			
+		case ASYNC_HTTPREAD_OK:
+			if ( AsyncReceive() )
+				ReadWindowAsync();
+			break;
+			
+		case ASYNC_HTTPTERM:
+			if ( AsyncReceive() )
+				FinishRequest( true );
+			break;
+			
+		default:
+			break;
+	}
+	
+	// The bearer was closed, the module won't answer the request
+	if ( _linkLost && _requestStatus == REQUEST_RUNNING )
+		FinishRequest( false );
+	
+	return _requestStatus;
+}
+
+
+template <class Policy>
+ConnectionBase::RequestStatus BasicConnection<Policy>::GetRequestStatus()
+{
+	return _requestStatus;
+}
+
+
+template <class Policy>
+uint16_t BasicConnection<Policy>::GetRequestHttpReply()
+{
+	return _asyncHttpReply;
+}
+
+
+template <class Policy>
+void BasicConnection<Policy>::SetResponseCache( ResponseCacheBase * cache )
+{
+	_cache = cache;
+}
+
+
+template <class Policy>
+bool BasicConnection<Policy>::IsCachedReply()
+{
+	return _cachedReply;
+}
+
+
+template <class Policy>
+bool BasicConnection<Policy>::BeginSession()
+{
+	if ( !sim900Serial )
+		return false;
+	
+	_httpSession = true;
+	
+	return StartHttp();
+}
+
+
+template <class Policy>
+void BasicConnection<Policy>::EndSession()
+{
+	_httpSession = false;
+	StopHttp();
+}
+
+
+template <class Policy>
+bool BasicConnection<Policy>::IsSessionOpen()
+{
+	return _httpSession;
+}
+
+
+template <class Policy>
+const char * BasicConnection<Policy>::GetIpAddress()
+{
+	return _bearerOpen ? _ipAddress : "";
+}
+
+
+template <class Policy>
+uint16_t BasicConnection<Policy>::GetBearerProbes()
+{
+	return _bearerProbes;
+}
+
+
+template <class Policy>
+uint16_t BasicConnection<Policy>::GetBearerProbesSaved()
+{
+	return _bearerProbesSaved;
+}
+
+
+template <class Policy>
+void BasicConnection<Policy>::SetReadWindow( const uint16_t & window )
+{
+	if ( window > 0 )
+		_readWindow = window;
+}
+
+
+template <class Policy>
+void BasicConnection<Policy>::SetClock(	MillisFunction millisFunction, 
+							DelayFunction delayFunction )
+{
+	_millis = millisFunction;
+	_delay = delayFunction;
+}
+
+
+template <class Policy>
+void BasicConnection<Policy>::SetIdleCallback( IdleCallback idleCallback )
+{
+	_idleCallback = idleCallback;
+}
+
+
+template <class Policy>
+void BasicConnection<Policy>::SetUrcCallback(	UrcCallback urcCallback, 
+									void * context )
+{
+	_urcCallback = urcCallback;
+	_urcContext = context;
+}
+
+
+template <class Policy>
+void BasicConnection<Policy>::ProcessUrcs()
+{
+	// Without a request running the pending input can only hold unsolicited codes
+	if ( _requestStatus != REQUEST_RUNNING )
+		CleanSerialBuffer();
+	
+	while ( _urcCount )
+	{
+		// The callback may send commands that queue more codes, so the event is copied
+		UrcEvent event = _urcQueue[_urcFirst];
+		_urcFirst = ( _urcFirst + 1 ) % Policy::URC_QUEUE_SIZE;
+		_urcCount--;
+		
+		if ( _urcCallback )
+			_urcCallback( event.code, event.line, _urcContext );
+	}
+}
+
+
+template <class Policy>
+uint16_t BasicConnection<Policy>::GetUrcDropped()
+{
+	return _urcDropped;
+}
+
+
+template <class Policy>
+bool BasicConnection<Policy>::StartSockets()
+{
+	if ( !sim900Serial || ( _sleeping && !Wake() ) )
+		return false;
+	
+	_socketsStarted = false;
+	_socketsOpen = 0;
+	
+	// CIPMUX and CSTT are only accepted in IP INITIAL state
+	if ( SendATcommand( F("AT+CIPSHUT"), F("SHUT OK"), F("ERROR"), Policy::SOCKET_SHUT_TIMEOUT ) != 1 )
+		return false;
+	
+	if ( SendATcommand( F("AT+CIPMUX=1"), F("OK"), F("ERROR"), 1000 ) != 1 )
+		return false;
+	
+	CleanSerialBuffer();
+	sim900Serial->print( F("AT+CSTT=\"") );
+	sim900Serial->print( _apnName );
+	sim900Serial->print( F("\",\"") );
+	sim900Serial->print( _apnUser );
+	sim900Serial->print( F("\",\"") );
+	sim900Serial->print( _apnPass );
+	sim900Serial->println( F("\"") );
+	
+	if ( ReceiveATReply( F("OK"), F("ERROR"), 1000 ) != 1 )
+		return false;
+	
+	if ( SendATcommand( F("AT+CIICR"), F("OK"), F("ERROR"), Policy::SOCKET_GPRS_TIMEOUT ) != 1 )
+		return false;
+	
+	// AT+CIFSR answers the IP without OK. It is needed to move to IP STATUS
+	if ( SendATcommand( F("AT+CIFSR"), F("."), F("ERROR"), 2000 ) != 1 )
+		return false;
+	
+	_socketsStarted = true;
+	return true;
+}
+
+
+template <class Policy>
+int8_t BasicConnection<Policy>::SocketOpen(	SocketType type, 
+								const char * host, 
+								const uint16_t & port )
+{
+	int8_t link = -1;
+	
+	if ( _sleeping && !Wake() )
+		return -1;
+	
+	if ( !_socketsStarted && !StartSockets() )
+		return -1;
+	
+	for ( uint8_t i = 0; i < SOCKET_LINKS && link < 0; i++ )
+	{
+		if ( !IsSocketOpen( i ) )
+			link = i;
+	}
+	
+	if ( link < 0 )
+		return -1;
+	
+	// Reply example: OK ... 0, CONNECT OK
+	char connectOk[] = "0, CONNECT OK";
+	char connectFail[] = "0, CONNECT FAIL";
+	connectOk[0] += link;
+	connectFail[0] += link;
+	const char * expectedAnswers[] = { connectOk, connectFail, "ERROR" };
+	
+	CleanSerialBuffer();
+	sim900Serial->print( F("AT+CIPSTART=") );
+	sim900Serial->print( link );
+	sim900Serial->print( type == SOCKET_TCP ? F(",\"TCP\",\"") : F(",\"UDP\",\"") );
+	sim900Serial->print( host );
+	sim900Serial->print( F("\",\"") );
+	sim900Serial->print( port );
+	sim900Serial->println( F("\"") );
+	
+	if ( ReceiveATReply( expectedAnswers, 3, Policy::SOCKET_CONNECT_TIMEOUT ) != 1 )
+		return -1;
+	
+	_socketsOpen |= 1 << link;
+	return link;
+}
+
+
+template <class Policy>
+bool BasicConnection<Policy>::SocketSend(	const uint8_t & link, 
+								const char * data, 
+								const uint16_t & length )
+{
+	if ( !IsSocketOpen( link ) || ( _sleeping && !Wake() ) )
+		return false;
+	
+	CleanSerialBuffer();
+	sim900Serial->print( F("AT+CIPSEND=") );
+	sim900Serial->print( link );
+	sim900Serial->print( F(",") );
+	sim900Serial->println( length );
+	
+	if ( ReceiveATReply( F(">"), F("ERROR"), 5000 ) != 1 )
+		return false;
+	
+	sim900Serial->write( (const uint8_t *) data, length );
+	_meter.EndData();
+	
+	// Reply example: 0, SEND OK
+	char sendOk[] = "0, SEND OK";
+	sendOk[0] += link;
+	const char * expectedAnswers[] = { sendOk, "SEND FAIL", "ERROR" };
+	
+	return ReceiveATReply( expectedAnswers, 3, Policy::SOCKET_SEND_TIMEOUT ) == 1;
+}
+
+
+template <class Policy>
+bool BasicConnection<Policy>::SocketClose( const uint8_t & link )
+{
+	if ( !IsSocketOpen( link ) )
+		return false;
+	
+	// Reply example: 0, CLOSE OK
+	char closeOk[] = "0, CLOSE OK";
+	closeOk[0] += link;
+	
+	CleanSerialBuffer();
+	sim900Serial->print( F("AT+CIPCLOSE=") );
+	sim900Serial->println( link );
+	
+	// The link is free even if the answer is lost
+	_socketsOpen &= ~( 1 << link );
+	
+	return ReceiveATReply( closeOk, "ERROR", 2000 ) == 1;
+}
+
+
+template <class Policy>
+bool BasicConnection<Policy>::IsSocketOpen( const uint8_t & link )
+{
+	if ( link >= SOCKET_LINKS )
+		return false;
+	
+	return _socketsOpen & ( 1 << link );
+}
+
+
+template <class Policy>
+void BasicConnection<Policy>::SetSocketCallback(	SocketCallback socketCallback, 
+										void * context )
+{
+	_socketCallback = socketCallback;
+	_socketContext = context;
+}
+
+
+template <class Policy>
+const ConnectionBase::CommandStats & BasicConnection<Policy>::GetCommandStats( CommandClass commandClass )
+{
+	return _commandStats[Policy::COMMAND_STATS ? commandClass : 0];
+}
+
+
+template <class Policy>
+void BasicConnection<Policy>::PrintCommandStats( Print & output )
+{
+	if ( Policy::COMMAND_STATS )
+		ConnectionBase::PrintCommandStats( output, _commandStats );
+}
+
+
+template <class Policy>
+void BasicConnection<Policy>::ResetCommandStats()
+{
+	memset( _commandStats, 0, sizeof( _commandStats ) );
+	
+	for ( uint8_t i = 0; i < sizeof( _commandStats ) / sizeof( _commandStats[0] ); i++ )
+		_commandStats[i].minLatency = 0xFFFF;
+}
+
+
+template <class Policy>
+bool BasicConnection<Policy>::PowerOn()
+{	
+	uint32_t previousTime = Millis();
+	
+	_bearerOpen = false;
+	_httpInitialized = false;
+	_bootTime = 0;
+	
+	digitalWrite( _enablePin, HIGH );
+	_delay( Policy::POWER_PULSE_TIME );
+	digitalWrite( _enablePin, LOW );
+	
+	if ( !WaitReady() )
+		return false;
+	
+	_bootTime = Millis() - previousTime;
+	return true;
+}
+
+
+template <class Policy>
+uint32_t BasicConnection<Policy>::GetBootTime()
+{
+	return _bootTime;
+}
+
+
+template <class Policy>
+uint32_t BasicConnection<Policy>::NegotiateBaudRate(	const uint32_t & maxBaudRate, 
+										const bool & persist )
+{
+	if ( !_hardwareSerial || !ProbeBaudRate() )
+		return 0;
+	
+	// The rates go from the fastest, the first one allowed that works is kept
+	for ( uint8_t i = 0; i < BAUD_RATES_COUNT; i++ )
+	{
+		uint32_t baudRate = pgm_read_dword( &BAUD_RATES[i] );
+		
+		if ( baudRate > maxBaudRate )
+			continue;
+		
+		if ( baudRate == _baudRate || SwitchBaudRate( baudRate ) )
+			break;
+	}
+	
+	if ( persist )
+		SendATcommand( F("AT&W"), F("OK"), 1000 );
+	
+	return _baudRate;
+}
+
+
+template <class Policy>
+uint32_t BasicConnection<Policy>::GetBaudRate()
+{
+	return _baudRate;
+}
+
+
+template <class Policy>
+void BasicConnection<Policy>::SetBaudRateCheck(	BaudRateCheck baudRateCheck, 
+									void * context )
+{
+	_baudRateCheck = baudRateCheck;
+	_baudRateContext = context;
+}
+
+
+template <class Policy>
+void BasicConnection<Policy>::PowerOff()
+{
+	if ( _sleeping )
+		Wake();
+	
+	SendATcommand( F("AT+CPOWD=1"), F("NORMAL POWER DOWN"), 5000 );
+	
+	// The module forgets everything, a session is opened again with BeginSession()
+	_httpSession = false;
+	_bearerOpen = false;
+	_httpInitialized = false;
+	_socketsStarted = false;
+	_socketsOpen = 0;
+	_sleepMode = SLEEP_NONE;
+	_sleeping = false;
+}
+
+
+template <class Policy>
+void BasicConnection<Policy>::SetDtrPin( const uint8_t & dtrPin )
+{
+	_dtrPin = dtrPin;
+	pinMode( dtrPin, OUTPUT );
+	digitalWrite( dtrPin, LOW );
+}
+
+
+template <class Policy>
+bool BasicConnection<Policy>::Sleep( SleepMode mode )
+{
+	if ( !sim900Serial || _sleeping || _requestStatus == REQUEST_RUNNING )
+		return false;
+	
+	if ( mode == SLEEP_DTR && _dtrPin == 0xFF )
+		return false;
+	
+	if ( mode != _sleepMode )
+	{
+		CleanSerialBuffer();
+		sim900Serial->print( F("AT+CSCLK=") );
+		sim900Serial->println( (uint8_t) mode );
+		
+		if ( ReceiveATReply( F("OK"), F("ERROR"), 1000 ) != 1 )
+			return false;
+		
+		_sleepMode = mode;
+	}
+	
+	if ( mode == SLEEP_NONE )
+		return true;
+	
+	if ( mode == SLEEP_DTR )
+		digitalWrite( _dtrPin, HIGH );
+	
+	uint32_t now = Millis();
+	
+	// Only the periods opened by Wake() are counted as awake
+	if ( _powerStats.wakes )
+	{
+		_powerStats.lastAwakeTime = now - _powerTime;
+		_powerStats.awakeTime += _powerStats.lastAwakeTime;
+	}
+	
+	_powerTime = now;
+	_sleeping = true;
+	return true;
+}
+
+
+template <class Policy>
+bool BasicConnection<Policy>::Wake()
+{
+	if ( !_sleeping )
+		return true;
+	
+	uint32_t previousTime = Millis();
+	bool awake = false;
+	
+	if ( _sleepMode == SLEEP_DTR )
+	{
+		digitalWrite( _dtrPin, LOW );
+		_delay( Policy::WAKE_DTR_TIME );
+	}
+	
+	// In SLEEP_AUTO the first chars only wake the module, they are lost
+	while ( !awake && !TimeOut( previousTime, Policy::WAKE_TIMEOUT ) )
+		awake = SendATcommand( F("AT"), F("OK"), Policy::WAKE_PROBE_INTERVAL ) == 1;
+	
+	if ( !awake )
+		return false;
+	
+	// Slow clock would stop the module between the chars of the next commands
+	if ( _sleepMode == SLEEP_AUTO && SendATcommand( F("AT+CSCLK=0"), F("OK"), 1000 ) == 1 )
+		_sleepMode = SLEEP_NONE;
+	
+	uint32_t now = Millis();
+	uint32_t wakeTime = now - previousTime;
+	
+	_powerStats.wakes++;
+	_powerStats.lastWakeTime = wakeTime > 0xFFFF ? 0xFFFF : wakeTime;
+	if ( _powerStats.lastWakeTime > _powerStats.maxWakeTime )
+		_powerStats.maxWakeTime = _powerStats.lastWakeTime;
+	_powerStats.sleepTime += previousTime - _powerTime;
+	
+	_powerTime = now;
+	_sleeping = false;
+	return true;
+}
+
+
+template <class Policy>
+bool BasicConnection<Policy>::IsSleeping()
+{
+	return _sleeping;
+}
+
+
+template <class Policy>
+bool BasicConnection<Policy>::SetFunctionLevel( FunctionLevel level )
+{
+	if ( !sim900Serial || ( _sleeping && !Wake() ) )
+		return false;
+	
+	CleanSerialBuffer();
+	sim900Serial->print( F("AT+CFUN=") );
+	sim900Serial->println( (uint8_t) level );
+	
+	if ( ReceiveATReply( F("OK"), F("ERROR"), Policy::CFUN_TIMEOUT ) != 1 )
+		return false;
+	
+	// Without radio the bearer and the sockets are gone
+	if ( level != FUNCTION_FULL )
+	{
+		_bearerOpen = false;
+		_httpInitialized = false;
+		_socketsStarted = false;
+		_socketsOpen = 0;
+	}
+	
+	return true;
+}
+
+
+template <class Policy>
+const typename BasicConnection<Policy>::PowerStats & BasicConnection<Policy>::GetPowerStats()
+{
+	return _powerStats;
+}
+
+
+template <class Policy>
+bool BasicConnection<Policy>::IsPowered()
+{
+	if ( SendATcommand(F("AT"), F("OK"), 200 ) > 0 )
+		return true;
+	else
+		return false;
+}
+
+
+template <class Policy>
+bool BasicConnection<Policy>::WaitReady()
+{
+	uint32_t previousTime = Millis();
+	uint32_t probeTime = previousTime;
+	AnswerMatcher rdy;
+	AnswerMatcher cpin;
+	AnswerMatcher callReady;
+	AnswerMatcher ok;
+	bool answering = false;
+	
+	BeginMatch( rdy, BOOT_RDY, true );
+	BeginMatch( cpin, BOOT_CPIN, true );
+	BeginMatch( callReady, URC_CALL_READY_PREFIX, true );
+	BeginMatch( ok, BOOT_OK, true );
+	
+	// SIM900 sends garbage through Serial while it boots, the matchers skip it
+	while ( !TimeOut( previousTime, Policy::BOOT_TIMEOUT ) )
+	{
+		if ( !sim900Serial->available() )
+		{
+			// With autobaud the module is silent until it receives an AT
+			if ( TimeOut( probeTime, Policy::BOOT_PROBE_INTERVAL ) )
+			{
+				if ( answering )
+					sim900Serial->println( F("AT+CPIN?") );
+				else
+					sim900Serial->println( F("AT") );
+				probeTime = Millis();
+			}
+			
+			Idle();
+			continue;
+		}
+		
+		char nextChar = ReadSerial();
+		
+		// +CPIN: READY, +CPIN: SIM PIN, etc. The SIM can be read. Every matcher sees every char: | instead of ||
+		if ( MatchNextChar( cpin, nextChar ) | MatchNextChar( callReady, nextChar ) )
+			return true;
+		
+		// The module accepts commands but the SIM may be busy yet, probe it at once
+		bool ready = MatchNextChar( rdy, nextChar ) | MatchNextChar( ok, nextChar );
+		if ( !answering && ready )
+		{
+			answering = true;
+			probeTime = Millis() - Policy::BOOT_PROBE_INTERVAL;
+		}
+	}
+	
+	return false;
+}
+
+
+template <class Policy>
+bool BasicConnection<Policy>::AnswersAT()
+{
+	for ( uint8_t i = Policy::BAUD_VERIFY_ROUNDS; i > 0; i-- )
+	{
+		if ( IsPowered() )
+			return true;
+	}
+	
+	return false;
+}
+
+
+template <class Policy>
+bool BasicConnection<Policy>::ProbeBaudRate()
+{
+	uint32_t previousRate = _baudRate;
+	
+	if ( AnswersAT() )
+		return true;
+	
+	for ( uint8_t i = 0; i < BAUD_RATES_COUNT; i++ )
+	{
+		uint32_t baudRate = pgm_read_dword( &BAUD_RATES[i] );
+		
+		if ( baudRate == previousRate || !CanSetBaudRate( baudRate ) )
+			continue;
+		
+		SetLocalBaudRate( baudRate );
+		if ( AnswersAT() )
+			return true;
+	}
+	
+	SetLocalBaudRate( previousRate );
+	return false;
+}
+
+
+template <class Policy>
+bool BasicConnection<Policy>::SwitchBaudRate( const uint32_t & baudRate )
+{
+	uint32_t previousRate = _baudRate;
+	bool verified = true;
+	
+	if ( !CanSetBaudRate( baudRate ) )
+		return false;
+	
+	// The module answers at the old rate and then changes
+	CleanSerialBuffer();
+	sim900Serial->print( F("AT+IPR=") );
+	sim900Serial->println( baudRate );
+	
+	if ( !ReceiveATReply( F("OK"), 500 ) )
+		return false;
+	
+	SetLocalBaudRate( baudRate );
+	
+	// Every round trip must work, a noisy line at this rate would corrupt the bodies
+	for ( uint8_t i = Policy::BAUD_VERIFY_ROUNDS; i > 0 && verified; i-- )
+		verified = IsPowered();
+	
+	if ( verified )
+		return true;
+	
+	// The command may not be understood at the new rate, so the old one is probed too
+	sim900Serial->print( F("AT+IPR=") );
+	sim900Serial->println( previousRate );
+	SetLocalBaudRate( previousRate );
+	
+	ProbeBaudRate();
+	return false;
+}
+
+
+template <class Policy>
+void BasicConnection<Policy>::SetLocalBaudRate( const uint32_t & baudRate )
+{
+	// Send the pending output at the old rate
+	_hardwareSerial->flush();
+	_hardwareSerial->begin( baudRate );
+	_baudRate = baudRate;
+	
+	_delay( Policy::BAUD_SWITCH_TIME );
+}
+
+
+template <class Policy>
+bool BasicConnection<Policy>::CanSetBaudRate( const uint32_t & baudRate )
+{
+	return !_baudRateCheck || _baudRateCheck( baudRate, _baudRateContext );
+}
+
+
+template <class Policy>
+void BasicConnection<Policy>::EchoOn( )
+{
+	SendATcommand(F("ATE1"), F("OK"), 1000 );
+}
+
+
+template <class Policy>
+void BasicConnection<Policy>::EchoOff( )
+{
+	 sim900Serial->println( F("ATE0") );
+}
+
+
+template <class Policy>
+bool BasicConnection<Policy>::AT_CPIN()
+{
+	int answer = SendATcommand( F("AT+CPIN?"), F("READY"), F("SIM PIN"), 500 );
+	
+	if ( answer == 1 )
+	{
+		return true;
+	}
+	else if ( answer == 2 )
+	{
+		CleanSerialBuffer();
+		sim900Serial->print(F("AT+CPIN=\""));
+		sim900Serial->print( _pinCode );
+		sim900Serial->println( F("\"") );	
+	}
+	
+	return ReceiveATReply( F("OK"), 2000 );	
+}
+
+
+template <class Policy>
+bool BasicConnection<Policy>::AT_CREG()
+{
+	int errorCount;
+	const int totalAnswers  = 5;
+	const __FlashStringHelper * expectedAnswers[totalAnswers] = { 	(const __FlashStringHelper *) CREG_NOT_SEARCHING, 
+																	(const __FlashStringHelper *) CREG_SEARCHING, 
+																	(const __FlashStringHelper *) CREG_UNKNOWN, 
+																	(const __FlashStringHelper *) CREG_HOME, 
+																	(const __FlashStringHelper *) CREG_ROAMING };
+				
+		
+	for ( errorCount = Policy::CREG_WAITING_RETRIES; errorCount ; errorCount-- )
+	{
+		int answer = SendATcommand( F("AT+CREG?"), expectedAnswers, totalAnswers, 2000 );
+		if ( answer >= 4  )
+			return true;
+		else if ( answer == 0 )
+			return false;						
+		
+		CountRetry();
+		Wait( 1000 );
+	}
+			
+	return false;
+}
+
+
+template <class Policy>
+bool BasicConnection<Policy>::IsBearerOpen()
+{
+	// Pending input may hold a DEACT URC
+	CleanSerialBuffer();
+	
+	if ( _bearerOpen )
+	{
+		_bearerProbesSaved++;
+		return true;
+	}
+	
+	return ProbeBearer();
+}
+
+
+template <class Policy>
+bool BasicConnection<Policy>::ProbeBearer()
+{
+	uint32_t previousTime = Millis();
+	uint8_t length = 0;
+	
+	_bearerProbes++;
+	_bearerOpen = false;
+	
+	// Reply example: +SAPBR: 1,1,"10.89.193.1"
+	if ( SendATcommand( F("AT+SAPBR=2,1"), F("1,1,\""), F("1,3"), 2000 ) != 1 )
+		return false;
+	
+	while ( WaitingSerialAvailable( previousTime, 2000 ) )
+	{
+		char nextChar = ReadSerial();
+		
+		if ( nextChar == '"' )
+			break;
+		
+		if ( length < sizeof( _ipAddress ) - 1 )
+			_ipAddress[length++] = nextChar;
+	}
+	_ipAddress[length] = '\0';
+	
+	_bearerOpen = true;
+	return true;
+}
+
+
+template <class Policy>
+bool BasicConnection<Policy>::OpenBearer()
+{	
+	uint8_t errorCount;
+	
+	if ( IsBearerOpen() )
+		return true;
+	
+	// Waiting for GPRS Attachment
+	for ( unsigned int i = Policy::CGATT_WAITING_RETRIES; i > 0; i-- )
+	{
+		if ( SendATcommand(F("AT+CGATT?"), F(": 0"), F(": 1"), 1000 ) == 2 )
+			break;
+		CountRetry();
+		Wait( 1000 );
+	}
+	
+	// Open Bearer
+	if ( SendATcommand( F("AT+SAPBR=1,1"), F("OK"), F("ERROR"), 3000 )  == 2 )
+		return false;
+	
+	// Wait for open the bearer										
+	for ( errorCount = Policy::SAPBR_WAITING_RETRIES; errorCount > 0; errorCount-- )
+	{
+		if ( ProbeBearer() )
+			break;
+		CountRetry();
+		Wait( 1000 );
+	}
+	
+	if ( !errorCount )
+		return false;
+	else
+		return true;
+}
+
+
+template <class Policy>
+bool BasicConnection<Policy>::UpdateBearerInfo()
+{
+	// GPRS connection
+	SendATcommand( F("AT+SAPBR=3,1,\"Contype\",\"GPRS\""), F("OK"), 500 );
+	
+	// Set APN Name
+	CleanSerialBuffer();
+	sim900Serial->print( F("AT+SAPBR=3,1,\"APN\",\"") );
+	sim900Serial->print( _apnName );
+	sim900Serial->println( F("\"") );
+	if ( !ReceiveATReply( F("OK"), 500 ) )
+		return false;	
+	
+	// Set APN User
+	CleanSerialBuffer();
+	sim900Serial->print( F("AT+SAPBR=3,1,\"USER\",\"") );
+	sim900Serial->print( _apnUser );
+	sim900Serial->println( F("\"") );
+	if ( !ReceiveATReply( F("OK"), 500 ) )
+		return false;	
+	
+	// Set APN Passwd
+	CleanSerialBuffer();
+	sim900Serial->print( F("AT+SAPBR=3,1,\"PWD\",\"") );
+	sim900Serial->print( _apnPass );
+	sim900Serial->println( F("\"") );
+	if ( !ReceiveATReply( F("OK"), 500 ) )
+		return false;
+		
+	// Save APN Info in NVRAM
+	return SendATcommand( F("AT+SAPBR=5,1"), F("OK"), 500 );
+}
+
+
+template <class Policy>
+bool BasicConnection<Policy>::StartHttp()
+{
+	if ( _httpInitialized )
+		return true;
+	
+	if ( SendATcommand( F("AT+HTTPINIT"), F("OK"), F("ERROR"), Policy::HTTPINIT_TIMEOUT) != 1 )
+	{
+		CountRetry();
+		SendATcommand( F("AT+HTTPTERM"), F("OK"), 1000 );
+		if ( SendATcommand( F("AT+HTTPINIT"), F("OK"), F("ERROR"), Policy::HTTPINIT_TIMEOUT) != 1 )
+			return false;
+	}
+
+	if ( SendATcommand(F("AT+HTTPPARA=\"CID\",1"), F("OK"), Policy::CID_TIMEOUT) != 1 )
+		return false;
+	
+	_httpInitialized = true;
+	return true;
+}
+
+
+template <class Policy>
+bool BasicConnection<Policy>::RestartHttp()
+{
+	CountRetry();
+	_httpInitialized = false;
+	SendATcommand( F("AT+HTTPTERM"), F("OK"), 1000 );
+	
+	return StartHttp();
+}
+
+
+template <class Policy>
+void BasicConnection<Policy>::StopHttp()
+{
+	if ( _httpSession )
+		return;
+	
+	SendATcommand( F("AT+HTTPTERM"), F("OK"), 500 );
+	_httpInitialized = false;
+}
+
+
+template <class Policy>
+bool BasicConnection<Policy>::StartRequest(	const char * host, 
+								const char * path, 
+								const char * url, 
+								RequestCallback requestCallback, 
+								void * context )
+{
+	if ( !sim900Serial || _requestStatus == REQUEST_RUNNING )
+		return false;
+	
+	if ( _sleeping && !Wake() )
+		return false;
+	
+	// Configuration can take minutes, so it isn't done asynchronously
+	if ( !IsBearerOpen() )
+		return false;
+	
+	_asyncHost = host;
+	_asyncPath = path;
+	_asyncUrl = url;
+	_asyncDone = requestCallback;
+	_asyncContext = context;
+	_asyncRetried = false;
+	_asyncHttpReply = 0;
+	_requestStatus = REQUEST_RUNNING;
+	
+	CleanSerialBuffer();
+	return true;
+}
+
+
+template <class Policy>
+void BasicConnection<Policy>::StartHttpAsync()
+{
+	if ( _httpInitialized )
+	{
+		SetupRequestAsync();
+		return;
+	}
+	
+	sim900Serial->println( F("AT+HTTPINIT") );
+	AsyncExpect( ASYNC_HTTPINIT, F("OK"), F("ERROR"), Policy::HTTPINIT_TIMEOUT );
+}
+
+
+template <class Policy>
+void BasicConnection<Policy>::RestartHttpAsync()
+{
+	_httpInitialized = false;
+	
+	if ( _asyncRetried )
+	{
+		FinishRequest( false );
+		return;
+	}
+	
+	_asyncRetried = true;
+	CountRetry();
+	sim900Serial->println( F("AT+HTTPTERM") );
+	AsyncExpect( ASYNC_HTTPTERM_RESTART, F("OK"), F("ERROR"), 1000 );
+}
+
+
+template <class Policy>
+void BasicConnection<Policy>::SetupRequestAsync()
+{
+	if ( _asyncPost )
+	{
+		WriteHttpData( _asyncLength, Policy::DATA_INPUT_TIME );
+		AsyncExpect( ASYNC_HTTPDATA, F("DOWNLOAD"), F("ERROR"), Policy::DOWNLOAD_TIMEOUT );
+	}
+	else
+	{
+		WriteHttpParaUrl( _asyncHost, _asyncPath, _asyncUrl );
+		AsyncExpect( ASYNC_URL, F("OK"), F("ERROR"), Policy::URL_TIMEOUT );
+	}
+}
+
+
+template <class Policy>
+void BasicConnection<Policy>::SendDataAsync()
+{
+	char chunk[Policy::BODY_CHUNK_SIZE];
+	uint16_t size = Policy::BODY_CHUNK_SIZE;
+	
+	if ( _asyncLength - _asyncOffset < size )
+		size = _asyncLength - _asyncOffset;
+	
+	if ( size > 0 )
+	{
+		size = _asyncProducer( chunk, size, _asyncProducerContext );
+		if ( size == 0 )
+		{
+			_meter.EndData();
+			FinishRequest( false );
+			return;
+		}
+		
+		sim900Serial->write( (const uint8_t *) chunk, size );
+		_asyncOffset += size;
+		_asyncTime = Millis();
+	}
+	
+	if ( _asyncOffset >= _asyncLength )
+	{
+		_meter.EndData();
+		AsyncExpect( ASYNC_DATA_OK, F("OK"), NULL, Policy::DATA_TIMEOUT );
+	}
+}
+
+
+template <class Policy>
+void BasicConnection<Policy>::ReceiveActionAsync()
+{
+	// Reply example: +HTTPACTION:0,200,1024
+	for ( uint16_t i = Policy::BODY_CHUNK_SIZE; i > 0 && sim900Serial->available(); i-- )
+	{
+		char nextChar = ReadSerial();
+		
+		if ( nextChar == 0x0D )
+		{
+			if ( _asyncPost )
+				StopHttpAsync();
+			else if ( _asyncHttpReply > 0 && _asyncHttpReply < 600 )
+			{
+				_asyncOffset = 0;
+				ReadWindowAsync();
+			}
+			else
+				FinishRequest( false );
+			return;
+		}
+		
+		// The first field is the http reply, the second the data length
+		if ( nextChar == ',' && _asyncDigits == 0 )
+		{
+			_asyncDigits++;
+			continue;
+		}
+		
+		// The length of a Post reply is checked but not kept, _asyncLength is the data sent
+		uint32_t number = _asyncDigits ? ( _asyncPost ? 0 : _asyncLength ) : _asyncHttpReply;
+		
+		if ( !AddDigit( number, nextChar, _asyncDigits ? 0xFFFFFFFF : 999 ) )
+		{
+			FinishRequest( false );
+			return;
+		}
+		
+		if ( !_asyncDigits )
+			_asyncHttpReply = number;
+		else if ( !_asyncPost )
+			_asyncLength = number;
+	}
+}
+
+
+template <class Policy>
+void BasicConnection<Policy>::ReadWindowAsync()
+{
+	uint16_t window = _readWindow;
+	
+	if ( _asyncOffset >= _asyncLength )
+	{
+		StopHttpAsync();
+		return;
+	}
+	
+	if ( _asyncLength - _asyncOffset < window )
+		window = _asyncLength - _asyncOffset;
+	
+	WriteHttpRead( _asyncOffset, window );
+	AsyncExpect( ASYNC_HTTPREAD, F("+HTTPREAD:"), F("ERROR"), Policy::HTTPREAD_TIMEOUT );
+}
+
+
+template <class Policy>
+void BasicConnection<Policy>::ReceiveWindowSizeAsync()
+{
+	for ( uint16_t i = Policy::BODY_CHUNK_SIZE; i > 0 && sim900Serial->available(); i-- )
+	{
+		char nextChar = ReadSerial();
+		uint32_t number = _asyncWindow;
+		
+		if ( nextChar == ' ' || nextChar == 0x0D )
+			continue;
+		
+		if ( nextChar == 0x0A )
+		{
+			if ( _asyncWindow == 0 )
+				FinishRequest( false );
+			else
+				AsyncTransfer( ASYNC_HTTPREAD_DATA, Policy::BODY_TIMEOUT );
+			return;
+		}
+		
+		if ( !AddDigit( number, nextChar, 0xFFFF ) )
+		{
+			FinishRequest( false );
+			return;
+		}
+		
+		_asyncWindow = number;
+	}
+}
+
+
+template <class Policy>
+void BasicConnection<Policy>::ReceiveDataAsync()
+{
+	uint16_t size = 0;
+	
+	// The chars of several Polls are gathered, the callback gets BODY_CHUNK_SIZE chars
+	// at a time and the rest of the window at its end
+	while ( _asyncChunkSize < Policy::BODY_CHUNK_SIZE && size < _asyncWindow && sim900Serial->available() )
+	{
+		_asyncChunk[_asyncChunkSize++] = sim900Serial->read();
+		size++;
+	}
+	
+	if ( size == 0 )
+		return;
+	
+	_asyncWindow -= size;
+	_asyncOffset += size;
+	_asyncTime = Millis();
+	
+	if ( _asyncChunkSize < Policy::BODY_CHUNK_SIZE && _asyncWindow > 0 )
+		return;
+	
+	uint16_t chunkSize = _asyncChunkSize;
+	
+	_asyncChunkSize = 0;
+	if ( _asyncBody && !_asyncBody( _asyncChunk, chunkSize, _asyncContext ) )
+	{
+		FinishRequest( false );
+		return;
+	}
+	
+	if ( _asyncWindow == 0 )
+		AsyncExpect( ASYNC_HTTPREAD_OK, F("OK"), NULL, 500 );
+}
+
+
+template <class Policy>
+void BasicConnection<Policy>::StopHttpAsync()
+{
+	if ( _httpSession )
+	{
+		FinishRequest( true );
+		return;
+	}
+	
+	sim900Serial->println( F("AT+HTTPTERM") );
+	AsyncExpect( ASYNC_HTTPTERM, F("OK"), NULL, 500 );
+}
+
+
+template <class Policy>
+ConnectionBase::RequestStatus BasicConnection<Policy>::FinishRequest( bool success )
+{
+	if ( !success )
+	{
+		_httpInitialized = false;
+		_bearerOpen = false;
+	}
+	else if ( !_httpSession )
+	{
+		_httpInitialized = false;
+	}
+	
+	_asyncState = ASYNC_IDLE;
+	_requestStatus = success ? REQUEST_DONE : REQUEST_FAILED;
+	
+	if ( _asyncDone )
+		_asyncDone( _requestStatus, _asyncHttpReply, _asyncContext );
+	
+	return _requestStatus;
+}
+
+
+template <class Policy>
+void BasicConnection<Policy>::AsyncExpect(	AsyncState state, 
+								const __FlashStringHelper * expectedAnswer1, 
+								const __FlashStringHelper * expectedAnswer2, 
+								const uint16_t & timeout )
+{
+	_asyncState = state;
+	BeginMatch( _asyncMatchers[0], (const char *) expectedAnswer1, true );
+	_asyncMatchers[1].pattern = NULL;
+	if ( expectedAnswer2 )
+		BeginMatch( _asyncMatchers[1], (const char *) expectedAnswer2, true );
+	_asyncTime = Millis();
+	_asyncTimeout = timeout;
+	_errorSeen = false;
+	
+	// Only the first wait after a command measures its response time
+	_asyncLearning = Policy::ADAPTIVE_TIMEOUTS && _meter.newCommand;
+	_meter.newCommand = false;
+	if ( _asyncLearning )
+		_asyncTimeout = AdaptTimeout( timeout );
+}
+
+
+template <class Policy>
+void BasicConnection<Policy>::AsyncTransfer(	AsyncState state, 
+								const uint16_t & timeout )
+{
+	_asyncState = state;
+	_asyncTime = Millis();
+	_asyncTimeout = timeout;
+	
+	// The time of a transfer depends on its size, it isn't a response time of the class
+	_asyncLearning = false;
+}
+
+
+template <class Policy>
+int8_t BasicConnection<Policy>::AsyncReceive()
+{
+	for ( uint16_t n = Policy::BODY_CHUNK_SIZE; n > 0 && sim900Serial->available(); n-- )
+	{
+		char nextChar = ReadSerial();
+		
+		for ( uint8_t i = 0; i < 2; i++ )
+		{
+			if ( !_asyncMatchers[i].pattern )
+				continue;
+			
+			if ( MatchNextChar( _asyncMatchers[i], nextChar ) )
+			{
+				if ( _asyncLearning )
+					LearnTimeout( _asyncMatchers[i].pattern, true, _asyncTime );
+				_asyncLearning = false;
+				RecordAnswer( _asyncMatchers[i].pattern, true, _asyncTime );
+				return i+1;
+			}
+		}
+	}
+	
+	return 0;
+}
+
+
+template <class Policy>
+bool BasicConnection<Policy>::SendGet(	const char * host, 
+							const char * path, 
+							const char * url, 
+							uint16_t & headerHttpReply, 
+							uint32_t & dataLength )
+{
+	if ( !sim900Serial || _requestStatus == REQUEST_RUNNING )
+		return false;
+	
+	if ( _sleeping && !Wake() )
+		return false;
+		
+	if ( !IsBearerOpen() )
+		if ( !Configuration() )
+			return false;
+	
+	_cacheServing = false;
+	_cacheFilling = false;
+	_cachedReply = false;
+	
+	if ( _cache )
+	{
+		_cacheKey = ResponseCacheBase::Key( host, path, url );
+		_cacheConditional = _cache->Find( _cacheKey );
+	}
+	
+	if ( StartHttp() && AT_HTTPPARA_HEADERS() )
+	{
+		// If the modem dropped the HTTP session the URL is refused, so restart it once
+		if ( AT_HTTPPARA_URL( host, path, url ) || ( RestartHttp() && AT_HTTPPARA_HEADERS() && AT_HTTPPARA_URL( host, path, url ) ) )
+		{
+			if ( AT_HTTPACTION_GET( headerHttpReply, dataLength ) && headerHttpReply > 0 && headerHttpReply < 600 )
+			{
+				// The HTTPPARA values last until HTTPTERM
+				if ( _httpSession )
+					ClearHttpHeaders();
+				
+				CacheReply( headerHttpReply, dataLength );
+				_cacheConditional = false;
+				return true;
+			}
+		}
+	}
+	
+	_cacheConditional = false;
+	_httpInitialized = false;
+	_bearerOpen = false;
+	return false;
+}
+
+
+template <class Policy>
+bool BasicConnection<Policy>::AT_HTTPACTION_GET( 	uint16_t & httpHeader, 
+										uint32_t & dataLength )
+{
+	sim900Serial->println(F("AT+HTTPACTION=0"));
+		
+	return GetHttpHeader( F("+HTTPACTION:0,"), httpHeader, dataLength, Policy::HTTPACTION_TIMEOUT );
+}
+
+
+template <class Policy>
+bool BasicConnection<Policy>::AT_HTTPACTION_POST( uint16_t & httpHeader )
+{
+	uint32_t dataLength;
+	
+	sim900Serial->println(F("AT+HTTPACTION=1"));
+	
+	return GetHttpHeader( F("+HTTPACTION:1,"), httpHeader, dataLength, Policy::HTTPACTION_TIMEOUT );
+}
+
+
+template <class Policy>
+bool BasicConnection<Policy>::AT_HTTPHEAD()
+{
+	char line[Policy::CACHE_HEADER_LINE_SIZE];
+	uint8_t length = 0;
+	bool truncated = false;
+	uint16_t size;
+	uint32_t previousTime;
+	
+	CleanSerialBuffer();
+	sim900Serial->println( F("AT+HTTPHEAD") );
+	
+	if ( ReceiveATReply( F("+HTTPHEAD:"), F("ERROR"), Policy::HTTPREAD_TIMEOUT ) != 1 )
+		return false;
+	
+	// Reply example: +HTTPHEAD: 120 and the header lines
+	size = GetReceiveDataSize( 500 );
+	_cache->StartHeaders();
+	previousTime = Millis();
+	
+	for ( ; size > 0; size-- )
+	{
+		if ( !WaitingSerialAvailable( previousTime, Policy::BODY_TIMEOUT ) )
+			return false;
+		
+		char nextChar = sim900Serial->read();
+		
+		if ( nextChar == '\n' )
+		{
+			// Truncated lines are skipped, a cut validator would never match
+			line[length] = '\0';
+			if ( !truncated )
+				_cache->ReadHeader( line );
+			
+			length = 0;
+			truncated = false;
+		}
+		else if ( nextChar != '\r' )
+		{
+			if ( length < sizeof( line ) - 1 )
+				line[length++] = nextChar;
+			else
+				truncated = true;
+		}
+	}
+	
+	ReceiveATReply( F("OK"), 500 );
+	return true;
+}
+
+
+template <class Policy>
+void BasicConnection<Policy>::CacheReply(	uint16_t & httpHeader, 
+								uint32_t & dataLength )
+{
+	if ( !_cache )
+		return;
+	
+	if ( httpHeader == 304 && _cacheConditional )
+	{
+		httpHeader = 200;
+		dataLength = _cache->GetBodyLength();
+		_cache->CountHit();
+		_cacheServing = true;
+		_cachedReply = true;
+	}
+	else if ( httpHeader == 200 )
+	{
+		// A body bigger than the store isn't saved, but the old one is dropped anyway
+		if ( dataLength <= 0xFFFF && AT_HTTPHEAD() )
+			_cacheFilling = _cache->Begin( _cacheKey, dataLength );
+		else
+			_cache->Remove( _cacheKey );
+	}
+}
+
+
+template <class Policy>
+bool BasicConnection<Policy>::AT_HTTPREAD(	const uint32_t & start, 
+								const uint16_t & size )
+{
+	CleanSerialBuffer();
+	WriteHttpRead( start, size );
+	
+	return ReceiveATReply( F("+HTTPREAD:"), F("ERROR"), Policy::HTTPREAD_TIMEOUT ) == 1;
+}
+
+
+template <class Policy>
+void BasicConnection<Policy>::WriteHttpRead(	const uint32_t & start, 
+								const uint16_t & size )
+{
+	sim900Serial->print( F("AT+HTTPREAD=") );
+	sim900Serial->print( start );
+	sim900Serial->print( F(",") );
+	sim900Serial->println( size );
+}
+
+
+template <class Policy>
+bool BasicConnection<Policy>::AT_HTTPDATA( 	const uint32_t & size, 
+								const int & timeout )
+{
+	CleanSerialBuffer();
+	WriteHttpData( size, timeout );
+	
+	return ReceiveATReply( F("DOWNLOAD"), F("ERROR"), Policy::DOWNLOAD_TIMEOUT ) == 1;
+}
+
+
+template <class Policy>
+void BasicConnection<Policy>::WriteHttpData(	const uint32_t & size, 
+								const int & timeout )
+{
+	sim900Serial->print( F("AT+HTTPDATA="));
+	sim900Serial->print( size );
+	sim900Serial->print( F(",") );
+	sim900Serial->println( timeout );
+}
+
+
+template <class Policy>
+bool BasicConnection<Policy>::SendData(	const uint32_t & dataLength, 
+							DataProducer producer, 
+							void * context )
+{
+	char chunk[Policy::BODY_CHUNK_SIZE];
+	uint32_t remaining = dataLength;
+	
+	while ( remaining > 0 )
+	{
+		uint16_t size = Policy::BODY_CHUNK_SIZE;
+		
+		if ( remaining < size )
+			size = remaining;
+		
+		size = producer( chunk, size, context );
+		if ( size == 0 )
+			break;
+		
+		sim900Serial->write( (const uint8_t *) chunk, size );
+		remaining -= size;
+	}
+	
+	_meter.EndData();
+	if ( remaining > 0 )
+		return false;
+	
+	return ReceiveATReply( F("OK"), Policy::DATA_TIMEOUT );
+}
+
+
+template <class Policy>
+bool BasicConnection<Policy>::AT_HTTPPARA_URL( 	const char * host, 
+									const char * path, 
+									const char * url )
+{
+	CleanSerialBuffer();
+	WriteHttpParaUrl( host, path, url );
+	
+	return ReceiveATReply( F("OK"), Policy::URL_TIMEOUT );	
+}
+
+
+template <class Policy>
+bool BasicConnection<Policy>::AT_HTTPPARA_HEADERS()
+{
+	if ( _contentType )
+	{
+		CleanSerialBuffer();
+		sim900Serial->print( F("AT+HTTPPARA=\"CONTENT\",\"") );
+		sim900Serial->print( _contentType );
+		sim900Serial->println( F("\"") );
+		
+		if ( !ReceiveATReply( F("OK"), Policy::URL_TIMEOUT ) )
+			return false;
+	}
+	
+	if ( _contentDeflate )
+		return SendATcommand( F("AT+HTTPPARA=\"USERDATA\",\"Content-Encoding: deflate\""), F("OK"), Policy::URL_TIMEOUT ) == 1;
+	
+	// The quotes of an ETag are part of it, they are escaped
+	if ( _cacheConditional )
+	{
+		CleanSerialBuffer();
+		sim900Serial->print( F("AT+HTTPPARA=\"USERDATA\",\"") );
+		if ( _cache->GetValidatorType() == ResponseCacheBase::VALIDATOR_ETAG )
+			sim900Serial->print( F("If-None-Match: ") );
+		else
+			sim900Serial->print( F("If-Modified-Since: ") );
+		PrintAtString( _cache->GetValidator() );
+		sim900Serial->println( F("\"") );
+		
+		return ReceiveATReply( F("OK"), Policy::URL_TIMEOUT );
+	}
+	
+	return true;
+}
+
+
+template <class Policy>
+void BasicConnection<Policy>::ClearHttpHeaders()
+{
+	if ( _contentType )
+		SendATcommand( F("AT+HTTPPARA=\"CONTENT\",\"text/plain\""), F("OK"), Policy::URL_TIMEOUT );
+	
+	if ( _contentDeflate || _cacheConditional )
+		SendATcommand( F("AT+HTTPPARA=\"USERDATA\",\"\""), F("OK"), Policy::URL_TIMEOUT );
+}
+
+
+template <class Policy>
+void BasicConnection<Policy>::WriteHttpParaUrl( 	const char * host, 
+									const char * path, 
+									const char * url )
+{
+	sim900Serial->print( F("AT+HTTPPARA=\"URL\",\"") );
+	sim900Serial->print( host );
+	sim900Serial->print( F("/") );
+	sim900Serial->print( path );
+	sim900Serial->print( F("/") );
+	sim900Serial->print( url );
+	sim900Serial->println( F("\"") );
+}
+
+
+template <class Policy>
+void BasicConnection<Policy>::PrintAtString( const char * text )
+{
+	for ( ; *text; text++ )
+	{
+		if ( *text == '"' )
+			sim900Serial->print( F("\\22") );
+		else if ( *text == '\\' )
+			sim900Serial->print( F("\\5C") );
+		else
+			sim900Serial->write( *text );
+	}
+}
+
+
+template <class Policy>
+bool BasicConnection<Policy>::GetHttpHeader( const __FlashStringHelper * expected_answer, 
+								uint16_t & httpHeader, 
+								uint32_t & dataLength, 
+								const uint16_t & timeout )
+{
+	uint32_t previousTime;
+	char nextChar;
+	
+	httpHeader = 0;
+	dataLength = 0;
+
+	// this loop waits for the answer
+	previousTime = Millis();
+	
+	uint32_t number = 0;
+	uint8_t digits = 0;
+	
+	if ( !ReceiveATReply( expected_answer, timeout ) )
+		return false;
+	
+	// Reply example: +HTTPACTION:0,200,1024
+	// Http reply, up to 3 digits until the comma
+	while ( true )
+	{	
+		if ( !WaitingSerialAvailable( previousTime,timeout ) )
+			return false;
+			
+		nextChar = ReadSerial();	
+		
+		if ( nextChar == ',' && digits > 0 )
+			break;
+		
+		if ( !AddDigit( number, nextChar, 999 ) )
+			return false;
+		digits++;
+	}
+	
+	httpHeader = number;
+	number = 0;
+	digits = 0;
+	
+	// Data length, until the end of the line
+	while ( true )
+	{
+		if ( !WaitingSerialAvailable( previousTime,timeout ) )
+			return false;
+		
+		nextChar = ReadSerial();
+		
+		if ( nextChar == 0x0D && digits > 0 )
+			break;
+		
+		if ( !AddDigit( number, nextChar, 0xFFFFFFFF ) )
+			return false;
+		digits++;
+	}
+	
+	dataLength = number;
+	
+	// Consume the LF, so the next command starts on a clean buffer
+	return ReceiveATReply( F("\n"), timeout );
+}
+
+
+template <class Policy>
+bool BasicConnection<Policy>::TimeOut( 	const uint32_t & previousTime, 
+							const uint32_t & timeOut )
+{
+	if ( Millis() - previousTime > timeOut )
+		return true;
+	
+	return false;
+}
+
+
+template <class Policy>
+uint16_t BasicConnection<Policy>::GetReceiveDataSize( const uint16_t & timeout )
+{
+	uint32_t dataSize = 0;
+	uint8_t digits = 0;
+	uint32_t previousTime = Millis();
+	char nextChar;
+	
+	// Reply example: +HTTPREAD:100 or +HTTPREAD: 100
+	while ( true )
+	{
+		if ( !WaitingSerialAvailable( previousTime, timeout ) )
+			return 0;
+			
+		nextChar = ReadSerial();
+		
+		if ( nextChar == ' ' && digits == 0 )
+			continue;
+		
+		if ( nextChar == 0x0D && digits > 0 )
+			break;
+		
+		// Not a number: 0 makes the caller stop reading
+		if ( !AddDigit( dataSize, nextChar, 0xFFFF ) )
+			return 0;
+		digits++;
+	}
+
+	// Consume the LF, the data comes after it
+	if ( !WaitingSerialAvailable( previousTime, timeout ) || ReadSerial() != 0x0A )
+		return 0;
+
+	return dataSize;
+}
+
+
+template <class Policy>
+bool BasicConnection<Policy>::WaitingSerialAvailable( 	const uint32_t & previousTime, 
+											const uint32_t & timeout )
+{
+	while( !sim900Serial->available() )
+	{
+		if ( TimeOut( previousTime, timeout ) || _linkLost )
+			return false;
+		
+		Idle();
+	}
+	return !_linkLost;
+}
+
+
+template <class Policy>
+void BasicConnection<Policy>::Wait( const uint16_t & time )
+{
+	uint32_t previousTime = Millis();
+	
+	while( !TimeOut( previousTime, time ) )
+		Idle();
+}
+
+
+template <class Policy>
+uint32_t BasicConnection<Policy>::Millis()
+{
+	return _millis();
+}
+
+
+template <class Policy>
+void BasicConnection<Policy>::Idle()
+{
+	if ( _idleCallback )
+		_idleCallback();
+	else
+		yield();
+}
+
+
+template <class Policy>
+bool BasicConnection<Policy>::ReadBody(	const uint32_t & dataLength, 
+							BodyCallback callback, 
+							void * context )
+{
+	uint32_t offset = 0;
+	
+	// The cached body is given in chunks like a body read from the module
+	if ( _cacheServing )
+	{
+		const char * body = _cache->GetBody();
+		
+		_cacheServing = false;
+		for ( ; offset < dataLength; offset += Policy::BODY_CHUNK_SIZE )
+		{
+			uint16_t length = Policy::BODY_CHUNK_SIZE;
+			
+			if ( dataLength - offset < length )
+				length = dataLength - offset;
+			
+			if ( !callback( body + offset, length, context ) )
+				return false;
+		}
+		
+		return true;
+	}
+	
+	if ( _cacheFilling )
+	{
+		CacheTee tee = { callback, context, _cache };
+		
+		_cacheFilling = false;
+		bool received = ReadBody( dataLength, WriteToCache, &tee );
+		
+		_cache->Commit();
+		return received;
+	}
+	
+	// Every window is requested after the previous one is consumed by callback,
+	// so only a window has to fit in the serial buffer.
+	while ( offset < dataLength )
+	{
+		uint16_t window = _readWindow;
+		uint16_t received;
+		
+		if ( dataLength - offset < window )
+			window = dataLength - offset;
+		
+		if ( !AT_HTTPREAD( offset, window ) )
+			return false;
+		
+		if ( !ReceiveData( callback, context, received, Policy::BODY_TIMEOUT ) || received == 0 )
+			return false;
+		
+		ReceiveATReply( F("OK"), 500 );
+		offset += received;
+	}
+	
+	return true;
+}
+
+
+template <class Policy>
+bool BasicConnection<Policy>::ReceiveData(	BodyCallback callback, 
+								void * context, 
+								uint16_t & dataSize, 
+								const uint16_t & timeout )
+{
+	char chunk[Policy::BODY_CHUNK_SIZE];
+	uint16_t chunkCount = 0;
+	uint32_t previousTime;
+	
+	previousTime = Millis();
+	
+	dataSize = GetReceiveDataSize( 500 );
+	
+	for ( uint16_t i = dataSize; i > 0; i-- )
+	{
+		if ( !WaitingSerialAvailable( previousTime, timeout ) )
+			return false;
+		
+		chunk[chunkCount++] = sim900Serial->read();
+		
+		if ( chunkCount == Policy::BODY_CHUNK_SIZE || i == 1 )
+		{
+			if ( !callback( chunk, chunkCount, context ) )
+				return false;
+			chunkCount = 0;
+		}
+	}
+	
+	return true;
+}
+
+
+template <class Policy>
+char BasicConnection<Policy>::ReadSerial()
+{
+	char nextChar = sim900Serial->read();
+	
+	ReceiveLine( nextChar );
+	
+	return nextChar;
+}
+
+
+template <class Policy>
+void BasicConnection<Policy>::ReceiveLine( const char & nextChar )
+{
+	if ( nextChar == 0x0D )
+		return;
+	
+	if ( nextChar != 0x0A )
+	{
+		// Long lines are truncated, the codes are recognized by their start
+		if ( _lineLength + 1 < Policy::URC_LINE_SIZE )
+			_line[_lineLength++] = nextChar;
+		return;
+	}
+	
+	_line[_lineLength] = '\0';
+	_lineLength = 0;
+	
+	// The data of the sockets follows its line, it is read before anything else
+	if ( LineStartsWith( _line, SOCKET_RECEIVE_PREFIX ) )
+	{
+		ReceiveSocketData( _line );
+		return;
+	}
+	
+	if ( IsErrorLine( _line ) )
+	{
+		_errorSeen = true;
+		return;
+	}
+	
+	int8_t code = ClassifyUrc( _line );
+	if ( code < 0 )
+		return;
+	
+	// The bearer is closed: the command being waited for will never finish
+	if ( code == URC_BEARER_DEACT || code == URC_POWER_DOWN )
+	{
+		_bearerOpen = false;
+		_httpInitialized = false;
+		_linkLost = true;
+		_socketsStarted = false;
+		_socketsOpen = 0;
+	}
+	
+	if ( code == URC_SOCKET_CLOSED )
+		_socketsOpen &= ~( 1 << ( _line[0] - '0' ) );
+	
+	if ( _urcCount == Policy::URC_QUEUE_SIZE )
+	{
+		_urcDropped++;
+		return;
+	}
+	
+	UrcEvent & event = _urcQueue[( _urcFirst + _urcCount ) % Policy::URC_QUEUE_SIZE];
+	event.code = (UrcCode) code;
+	strcpy( event.line, _line );
+	_urcCount++;
+}
+
+
+template <class Policy>
+void BasicConnection<Policy>::ReceiveSocketData( const char * line )
+{
+	char chunk[Policy::BODY_CHUNK_SIZE];
+	uint16_t chunkCount = 0;
+	uint32_t previousTime = Millis();
+	uint16_t length = 0;
+	
+	// Line example: +RECEIVE,0,12:
+	const char * field = line + strlen_P( SOCKET_RECEIVE_PREFIX );
+	uint8_t link = *field - '0';
+	uint32_t number = 0;
+	
+	if ( link >= SOCKET_LINKS || field[1] != ',' )
+		return;
+	
+	for ( field += 2; *field != ':'; field++ )
+	{
+		if ( !AddDigit( number, *field, 0xFFFF ) )
+			return;
+	}
+	
+	length = number;
+	
+	for ( uint16_t i = length; i > 0; i-- )
+	{
+		if ( !WaitingSerialAvailable( previousTime, Policy::SOCKET_DATA_TIMEOUT ) )
+			return;
+		
+		chunk[chunkCount++] = sim900Serial->read();
+		
+		if ( chunkCount == Policy::BODY_CHUNK_SIZE || i == 1 )
+		{
+			if ( _socketCallback )
+				_socketCallback( link, chunk, chunkCount, _socketContext );
+			chunkCount = 0;
+		}
+	}
+}
+
+
+template <class Policy>
+void BasicConnection<Policy>::RecordAnswer(	const char * answer, 
+								const bool & inFlash, 
+								const uint32_t & previousTime )
+{
+	if ( !Policy::COMMAND_STATS )
+		return;
+	
+	CommandStats & stats = _commandStats[_meter.commandClass];
+	
+	// A wait aborted by a link loss isn't a timeout of the command
+	if ( !answer )
+	{
+		if ( _errorSeen )
+			stats.errors++;
+		else if ( !_linkLost )
+			stats.timeouts++;
+		return;
+	}
+	
+	if ( IsErrorAnswer( answer, inFlash ) )
+	{
+		stats.errors++;
+		return;
+	}
+	
+	uint16_t latency = Millis() - previousTime;
+	
+	stats.replies++;
+	stats.totalLatency += latency;
+	if ( latency < stats.minLatency )
+		stats.minLatency = latency;
+	if ( latency > stats.maxLatency )
+		stats.maxLatency = latency;
+}
+
+
+template <class Policy>
+void BasicConnection<Policy>::CountRetry()
+{
+	if ( Policy::COMMAND_STATS )
+		_commandStats[_meter.commandClass].retries++;
+}
+
+
+template <class Policy>
+uint16_t BasicConnection<Policy>::GetAdaptiveTimeout(	CommandClass commandClass, 
+											const bool & afterData )
+{
+	if ( !Policy::ADAPTIVE_TIMEOUTS )
+		return 0;
+	
+	const TimeoutEstimate & estimate = _timeouts[commandClass][afterData ? 1 : 0];
+	uint32_t timeout = ( (uint32_t) estimate.smoothed + 4 * (uint32_t) estimate.variation ) << estimate.backoff;
+	
+	return timeout > 0xFFFF ? 0xFFFF : timeout;
+}
+
+
+template <class Policy>
+uint32_t BasicConnection<Policy>::AdaptTimeout( const uint32_t & timeout )
+{
+	uint16_t adaptive = GetAdaptiveTimeout( _meter.commandClass, _meter.afterData );
+	
+	// Until the first answer the worst case is used
+	if ( adaptive == 0 )
+		return timeout;
+	
+	if ( adaptive < Policy::ADAPTIVE_TIMEOUT_FLOOR )
+		adaptive = Policy::ADAPTIVE_TIMEOUT_FLOOR;
+	
+	return adaptive < timeout ? adaptive : timeout;
+}
+
+
+template <class Policy>
+void BasicConnection<Policy>::LearnTimeout(	const char * answer, 
+								const bool & inFlash, 
+								const uint32_t & previousTime )
+{
+	TimeoutEstimate & estimate = _timeouts[_meter.commandClass][_meter.afterData ? 1 : 0];
+	
+	// A timeout: back off until the next answer, up to 16 times the estimate
+	if ( !answer )
+	{
+		if ( !_errorSeen && !_linkLost && estimate.smoothed && estimate.backoff < 4 )
+			estimate.backoff++;
+		return;
+	}
+	
+	// An error answer says nothing about the response time
+	if ( IsErrorAnswer( answer, inFlash ) )
+		return;
+	
+	uint16_t sample = Millis() - previousTime;
+	
+	// RFC 6298: variation = 3/4 variation + 1/4 |smoothed - sample|, smoothed = 7/8 smoothed + 1/8 sample
+	if ( estimate.smoothed == 0 )
+	{
+		estimate.smoothed = sample ? sample : 1;
+		estimate.variation = sample / 2;
+	}
+	else
+	{
+		uint16_t difference = estimate.smoothed > sample ? estimate.smoothed - sample : sample - estimate.smoothed;
+		
+		estimate.variation = ( 3 * (uint32_t) estimate.variation + difference ) / 4;
+		estimate.smoothed = ( 7 * (uint32_t) estimate.smoothed + sample ) / 8;
+		if ( estimate.smoothed == 0 )
+			estimate.smoothed = 1;
+	}
+	
+	estimate.backoff = 0;
+}
+
+
+template <class Policy>
+void BasicConnection<Policy>::CleanSerialBuffer()
+{
+	while( sim900Serial->available() > 0)
+	{
+		ReadSerial();
+	}
+	
+	// A link loss received before the next command is already in the bearer state
+	_linkLost = false;
+}
+
+
+template <class Policy>
+int8_t BasicConnection<Policy>::SendATcommand( 	const char* ATcommand, 
+									const char* expectedAnswer, 
+									const unsigned int & timeout )
+{	
+	const char * arrayAnswers[] = { expectedAnswer };
+		
+	return SendATcommand( ATcommand, arrayAnswers, 1, timeout );
+}
+
+
+template <class Policy>
+int8_t BasicConnection<Policy>::SendATcommand(	const char* ATcommand, 
+									const char* expectedAnswer1, 
+									const char* expectedAnswer2, 
+									const unsigned int & timeout )
+{
+	const char * arrayAnswers[] = { expectedAnswer1, expectedAnswer2 };
+	
+	return SendATcommand( ATcommand, arrayAnswers, 2, timeout );						
+}
+
+
+template <class Policy>
+int8_t BasicConnection<Policy>::SendATcommand(	const char* ATcommand,
+									const char ** expectedAnswers,
+									const int & totalAnwers,
+									const unsigned int & timeout )
+{
+	CleanSerialBuffer();
+	sim900Serial->println( ATcommand );
+
+	return ReceiveATReply( expectedAnswers, totalAnwers, timeout );
+}
+
+
+template <class Policy>
+int8_t BasicConnection<Policy>::SendATcommand( 	const __FlashStringHelper * ATcommand, 
+									const __FlashStringHelper * expectedAnswer, 
+									const unsigned int & timeout )
+{	
+	const __FlashStringHelper * arrayAnswers[] = { expectedAnswer };
+		
+	return SendATcommand( ATcommand, arrayAnswers, 1, timeout );
+}
+
+
+template <class Policy>
+int8_t BasicConnection<Policy>::SendATcommand(	const __FlashStringHelper * ATcommand, 
+									const __FlashStringHelper * expectedAnswer1, 
+									const __FlashStringHelper * expectedAnswer2, 
+									const unsigned int & timeout )
+{
+	const __FlashStringHelper * arrayAnswers[] = { expectedAnswer1, expectedAnswer2 };
+	
+	return SendATcommand( ATcommand, arrayAnswers, 2, timeout );						
+}
+
+
+template <class Policy>
+int8_t BasicConnection<Policy>::SendATcommand(	const __FlashStringHelper * ATcommand,
+									const __FlashStringHelper ** expectedAnswers,
+									const int & totalAnwers,
+									const unsigned int & timeout )
+{
+	CleanSerialBuffer();
+	sim900Serial->println( ATcommand );
+
+	return ReceiveATReply( expectedAnswers, totalAnwers, timeout );
+}
+
+
+template <class Policy>
+int8_t BasicConnection<Policy>::ReceiveATReply(	const char ** expectedAnswers,
+									const int & totalAnwers,
+									const unsigned int & timeout )
+{
+	return MatchATReply( expectedAnswers, totalAnwers, timeout, false );
+}
+
+
+template <class Policy>
+int8_t BasicConnection<Policy>::ReceiveATReply(	const __FlashStringHelper ** expectedAnswers,
+									const int & totalAnwers,
+									const unsigned int & timeout )
+{
+	return MatchATReply( (const char **) expectedAnswers, totalAnwers, timeout, true );
+}
+
+
+template <class Policy>
+int8_t BasicConnection<Policy>::MatchATReply(	const char ** expectedAnswers,
+									const int & totalAnwers,
+									const unsigned int & timeout,
+									const bool & inFlash )
+{
+	AnswerMatcher matchers[MAX_ANSWERS];
+	uint8_t answers = totalAnwers;
+	uint32_t previousTime;
+	
+	if ( totalAnwers < 0 || totalAnwers > MAX_ANSWERS )
+		return 0;
+	
+	// Only the first wait after a command measures its response time
+	bool learning = Policy::ADAPTIVE_TIMEOUTS && _meter.newCommand;
+	uint32_t wait = learning ? AdaptTimeout( timeout ) : timeout;
+	_meter.newCommand = false;
+
+	for ( uint8_t i = 0; i < answers; i++ )
+		BeginMatch( matchers[i], expectedAnswers[i], inFlash );
+
+	previousTime = Millis();
+	_errorSeen = false;
+	
+	// WaitingSerialAvailable ends the wait: the input received while the idle callback ran
+	// is read even when the time is over
+	while( true )
+	{
+		if( !WaitingSerialAvailable( previousTime, wait ) )
+			break;
+		
+		char nextChar = ReadSerial();
+		
+		if ( _linkLost )
+			break;
+		
+		for ( uint8_t i = 0; i < answers; i++ )
+		{
+			if ( MatchNextChar( matchers[i], nextChar ) )
+			{
+				if ( learning )
+					LearnTimeout( expectedAnswers[i], inFlash, previousTime );
+				RecordAnswer( expectedAnswers[i], inFlash, previousTime );
+				return i+1;
+			}
+		}
+
+	}
+
+	if ( learning )
+		LearnTimeout( NULL, inFlash, previousTime );
+	RecordAnswer( NULL, inFlash, previousTime );
+	return 0;
+}
+
+
+template <class Policy>
+int8_t BasicConnection<Policy>::ReceiveATReply(	const char * expectedAnswer,
+									const unsigned int & timeout )
+{
+	const char * expectedAnswers[] = { expectedAnswer };
+	
+	return ReceiveATReply( expectedAnswers, 1, timeout );
+}
+
+
+template <class Policy>
+int8_t BasicConnection<Policy>::ReceiveATReply(	const char * expectedAnswer1,
+									const char * expectedAnswer2,
+									const unsigned int & timeout )
+{
+	const char * expectedAnswers[] = { expectedAnswer1, expectedAnswer2 };
+	
+	return ReceiveATReply( expectedAnswers, 2, timeout );
+}
+
+
+template <class Policy>
+int8_t BasicConnection<Policy>::ReceiveATReply(	const __FlashStringHelper * expectedAnswer,
+									const unsigned int & timeout )
+{
+	const __FlashStringHelper * expectedAnswers[] = { expectedAnswer };
+	
+	return ReceiveATReply( expectedAnswers, 1, timeout );
+}
+
+
+template <class Policy>
+int8_t BasicConnection<Policy>::ReceiveATReply(	const __FlashStringHelper * expectedAnswer1,
+									const __FlashStringHelper * expectedAnswer2,
+									const unsigned int & timeout )
+{
+	const __FlashStringHelper * expectedAnswers[] = { expectedAnswer1, expectedAnswer2 };
+	
+	return ReceiveATReply( expectedAnswers, 2, timeout );
+}
+
+#endif
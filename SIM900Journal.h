@@ -0,0 +1,883 @@
+/** SIM900 Basic communication library for SIM900 gsm module.
+ *
+ *	Post journal: keeps the Post petitions that can't be sent in a persistent storage
+ *	( EEPROM, flash, a file ) and sends them in order when the link returns, even after
+ *	a reset.
+ *
+ *	The storage is used as a ring of slots. Every record is appended after the last one,
+ *	so the writes are spread over the whole storage. A record is valid only if its
+ *	checksum matches, so a record cut by a reset is ignored. When requests are delivered
+ *	a commit record is appended; requests sent but not committed when the power fails are
+ *	sent again.
+ *
+ *	Released under MIT license.
+ *
+ */
+#pragma once
+#ifndef __PostJournal_h__
+#define __PostJournal_h__
+
+#include "SIM900.h"
+
+/** \brief Persistent storage of a PostJournal
+ */
+class JournalStorage
+{
+public:
+	/** \brief Size of the storage in bytes
+	 */
+	virtual uint32_t Size() = 0;
+
+	/** \brief Reads bytes of the storage
+	 *
+	 *	@param	IN	address of the first byte
+	 *	@param	OUT	buffer for the bytes
+	 *	@param	IN	number of bytes
+	 *
+	 *	@return	true if they are read
+	 */
+	virtual bool Read(	const uint32_t & address,
+						void * buffer,
+						const uint16_t & length ) = 0;
+
+	/** \brief Writes bytes in the storage
+	 *
+	 *	@param	IN	address of the first byte
+	 *	@param	IN	bytes to write
+	 *	@param	IN	number of bytes
+	 *
+	 *	@return	true if they are written
+	 */
+	virtual bool Write(	const uint32_t & address,
+						const void * data,
+						const uint16_t & length ) = 0;
+};
+
+
+/** \brief Statistics of a PostJournal
+ */
+struct JournalStats
+{
+	uint16_t depth;			// requests waiting
+	uint16_t maxDepth;		// max requests waited at the same time
+	uint16_t recovered;		// requests found in the storage by Begin()
+	uint16_t queued;		// requests added
+	uint16_t dropped;		// requests refused because the journal was full or the storage failed
+	uint16_t delivered;		// requests sent
+	uint16_t posts;			// Post petitions made. Less than delivered when requests are batched
+	uint32_t drainTime;		// ms spent in Drain()
+};
+
+
+/** \brief Journal of Post petitions. ConnectionType is a BasicConnection, see DefaultConnectionPolicy.
+ */
+template <class ConnectionType = Connection>
+class PostJournal
+{
+public:
+	enum
+	{
+		// Bytes of a slot of the storage. A record takes one or more slots.
+		SLOT_SIZE = 32,
+
+		// Max size of host, path and url together, with their NULs
+		TARGET_SIZE = 96
+	};
+
+	/** \brief Constructuor
+	 *
+	 *	@param	IN	connection used to send the requests
+	 *	@param	IN	storage of the journal. All of it is used.
+	 */
+	PostJournal(	ConnectionType & connection,
+					JournalStorage & storage );
+
+	/** \brief Reads the storage and finds the requests not delivered yet. Call it once
+	 *		before the other methods.
+	 *
+	 *	@return	number of requests waiting
+	 */
+	uint16_t Begin();
+
+	/** \brief Joins the data of consecutive requests to the same host/path/url in one Post.
+	 *		e.g. "[", ",", "]" sends a JSON array. A request alone is sent between open and
+	 *		close too, so the server always gets the same format. Use NULL to disable it (default).
+	 *
+	 *	@param	IN	text before the first request
+	 *	@param	IN	text between requests
+	 *	@param	IN	text after the last request
+	 *	@param	IN	max size of a joined Post
+	 */
+	void SetBatchFormat(	const char * open,
+							const char * separator,
+							const char * close,
+							const uint16_t & maxBatchSize = 512 );
+
+	/** \brief Saves a Post petition in the journal. The strings are copied.
+	 *
+	 *	@param	IN	Server domain or public IP. e.g. www.example.com OR 216.58.210.164
+	 *	@param	IN	Server path eg: api
+	 *	@param	IN	Server url eg: europe/madrid/time
+	 *	@param	IN	data to send.	eg: {"hour":10,"minutes":21,"seconds":13}
+	 *
+	 *	@return	false if the journal is full
+	 */
+	bool Add(	const char * host,
+				const char * path,
+				const char * url,
+				const char * data );
+
+	/** \brief Makes a Post petition, or saves it in the journal if it fails.
+	 *		While there are requests waiting it is saved after them, to keep the order.
+	 *
+	 *	@param	IN	Server domain or public IP. e.g. www.example.com OR 216.58.210.164
+	 *	@param	IN	Server path eg: api
+	 *	@param	IN	Server url eg: europe/madrid/time
+	 *	@param	IN	data to send.	eg: {"hour":10,"minutes":21,"seconds":13}
+	 *	@param	OUT	Http Reply of the request: e.g. 200, 404, etc. 0 if it is saved
+	 *
+	 *	@return	true if it is sent or saved
+	 */
+	bool Post(	const char * host,
+				const char * path,
+				const char * url,
+				const char * data,
+				uint16_t & headerHttpReply );
+
+	/** \brief Sends the saved requests, in order, over one HTTP session. A session opened
+	 *		by the caller with BeginSession() is used and left open.
+	 *		It stops at the first failed request, which is kept in the journal.
+	 *
+	 *	@return	number of requests sent
+	 */
+	uint16_t Drain();
+
+	/** \brief Number of requests waiting
+	 */
+	uint16_t Size();
+
+	/** \brief Journal statistics
+	 */
+	const JournalStats & GetStats();
+
+protected:
+	enum RecordType
+	{
+		RECORD_DATA = 1,		// host, path, url, with their NULs, and data
+		RECORD_COMMIT = 2		// sequence of the last request delivered
+	};
+
+	enum
+	{
+		RECORD_MAGIC = 0x4A
+	};
+
+	/** \brief Start of a record. The checksum covers the header, with crc 0, and the payload.
+	 */
+	struct RecordHeader
+	{
+		uint8_t magic;
+		uint8_t type;
+		uint16_t length;		// of the payload
+		uint32_t sequence;
+		uint16_t crc;
+	};
+
+	/** \brief Reads or writes bytes of the ring, from an offset of a slot.
+	 *		The bytes after the last slot go on the first one.
+	 */
+	bool ReadRing(	const uint16_t & slot,
+					const uint16_t & offset,
+					void * buffer,
+					const uint16_t & length );
+
+	bool WriteRing(	const uint16_t & slot,
+					const uint16_t & offset,
+					const void * data,
+					const uint16_t & length );
+
+	/** \brief Reads the header of the record at a slot
+	 *
+	 *	@return	true if the slot starts a valid record
+	 */
+	bool ReadRecord(	const uint16_t & slot,
+						RecordHeader & header );
+
+	/** \brief Appends a record after the last one. The header is written last, so the
+	 *		record isn't valid until it is complete.
+	 *
+	 *	@param	IN	type of record
+	 *	@param	IN	pieces of the payload, written one after the other
+	 *	@param	IN	size of every piece
+	 *	@param	IN	number of pieces
+	 *
+	 *	@return	true if written
+	 */
+	bool Append(	const RecordType & type,
+					const void * const * pieces,
+					const uint16_t * lengths,
+					const uint8_t & count );
+
+	/** \brief Writes a commit record for the requests until sequence and removes them
+	 */
+	bool Commit(	const uint32_t & sequence,
+					const uint16_t & count );
+
+	/** \brief Finds the first request waiting from a slot on
+	 *
+	 *	@param	IN/OUT	slot where the search starts. The slot of the request.
+	 *	@param	OUT	header of the request
+	 *
+	 *	@return	false if there are no more requests
+	 */
+	bool NextRequest(	uint16_t & slot,
+						RecordHeader & header );
+
+	/** \brief Slots taken by a record
+	 */
+	static uint16_t RecordSlots( const uint16_t & length );
+
+	/** \brief Slots from the oldest request waiting to the end of the last record
+	 */
+	uint16_t UsedSlots();
+
+	/** \brief CRC-16/CCITT of some bytes
+	 */
+	static uint16_t Crc16(	uint16_t crc,
+							const void * data,
+							const uint16_t & length );
+
+	/** \brief Reads host, path and url of a request into _target
+	 *
+	 *	@return	size of the three strings, with their NULs. 0 if they don't fit.
+	 */
+	uint16_t ReadTarget(	const uint16_t & slot,
+							const RecordHeader & header );
+
+	/** \brief Counts the requests that can go in the next Post and the size of their data
+	 *
+	 *	@param	OUT	size of the data of the Post
+	 *	@param	OUT	sequence of the last request of the batch
+	 *
+	 *	@return	number of requests
+	 */
+	uint16_t NextBatch(	uint32_t & dataLength,
+						uint32_t & lastSequence );
+
+	/** \brief DataProducer that writes the batch of requests from the storage. context is the journal.
+	 */
+	static uint16_t ReadBatch(	char * buffer,
+								uint16_t size,
+								void * context );
+
+	/** \brief Moves to the next piece of the batch: open, data, separator ... close
+	 */
+	void NextPiece();
+
+private:
+	ConnectionType & _connection;
+	JournalStorage & _storage;
+
+	uint16_t _slots;
+	uint16_t _head;				// slot of the next record
+	uint16_t _tail;				// slot of the oldest request waiting, _head if none
+	uint16_t _count;
+	uint32_t _sequence;			// of the next record
+	uint32_t _committed;		// last request delivered
+
+	const char * _batchOpen;
+	const char * _batchSeparator;
+	const char * _batchClose;
+	uint16_t _maxBatchSize;
+
+	// host, path and url of the request being sent
+	char _target[TARGET_SIZE];
+	uint16_t _targetLength;
+
+	// Batch being sent: the pieces are strings in memory or the data of a request in the storage
+	uint16_t _batchCount;
+	uint16_t _batchPosition;
+	uint16_t _batchSlot;
+	const char * _piece;
+	uint16_t _pieceSlot;
+	uint16_t _pieceOffset;
+	uint16_t _pieceLength;
+
+	JournalStats _stats;
+};
+
+
+template <class ConnectionType>
+PostJournal<ConnectionType>::PostJournal(	ConnectionType & connection,
+											JournalStorage & storage ):
+	_connection( connection ),
+	_storage( storage ),
+	_slots( 0 ),
+	_head( 0 ),
+	_tail( 0 ),
+	_count( 0 ),
+	_sequence( 1 ),
+	_committed( 0 ),
+	_batchOpen( NULL ),
+	_batchSeparator( NULL ),
+	_batchClose( NULL ),
+	_maxBatchSize( 0 ),
+	_targetLength( 0 ),
+	_batchCount( 0 ),
+	_batchPosition( 0 ),
+	_batchSlot( 0 ),
+	_piece( NULL ),
+	_pieceSlot( 0 ),
+	_pieceOffset( 0 ),
+	_pieceLength( 0 )
+{
+	memset( &_stats, 0, sizeof( _stats ) );
+}
+
+
+template <class ConnectionType>
+uint16_t PostJournal<ConnectionType>::Begin()
+{
+	RecordHeader header;
+	uint32_t lastSequence = 0;
+	uint32_t firstWaiting = 0;
+
+	uint32_t slots = _storage.Size() / SLOT_SIZE;
+	_slots = slots > 0xFFFF ? 0xFFFF : slots;
+	_head = 0;
+	_count = 0;
+	_committed = 0;
+
+	// The newest record ends where the next one goes, and the newest commit tells what was delivered
+	for ( uint16_t slot = 0; slot < _slots; slot++ )
+	{
+		if ( !ReadRecord( slot, header ) )
+			continue;
+
+		if ( header.sequence > lastSequence )
+		{
+			lastSequence = header.sequence;
+			_head = ( (uint32_t) slot + RecordSlots( header.length ) ) % _slots;
+		}
+
+		if ( header.type == RECORD_COMMIT )
+		{
+			uint32_t committed;
+
+			if ( ReadRing( slot, sizeof( header ), &committed, sizeof( committed ) ) && committed > _committed )
+				_committed = committed;
+		}
+
+		slot += RecordSlots( header.length ) - 1;
+	}
+
+	_sequence = lastSequence + 1;
+	_tail = _head;
+
+	// Requests not delivered: the oldest one is the tail
+	for ( uint16_t slot = 0; slot < _slots; slot++ )
+	{
+		if ( !ReadRecord( slot, header ) )
+			continue;
+
+		if ( header.type == RECORD_DATA && header.sequence > _committed )
+		{
+			if ( !_count || header.sequence < firstWaiting )
+			{
+				firstWaiting = header.sequence;
+				_tail = slot;
+			}
+			_count++;
+		}
+
+		slot += RecordSlots( header.length ) - 1;
+	}
+
+	_stats.recovered = _count;
+	_stats.depth = _count;
+	_stats.maxDepth = _count;
+
+	return _count;
+}
+
+
+template <class ConnectionType>
+void PostJournal<ConnectionType>::SetBatchFormat(	const char * open,
+													const char * separator,
+													const char * close,
+													const uint16_t & maxBatchSize )
+{
+	_batchOpen = open ? open : "";
+	_batchSeparator = separator;
+	_batchClose = close ? close : "";
+	_maxBatchSize = maxBatchSize;
+}
+
+
+template <class ConnectionType>
+bool PostJournal<ConnectionType>::Add(	const char * host,
+										const char * path,
+										const char * url,
+										const char * data )
+{
+	const void * pieces[] = { host, path, url, data };
+	uint16_t lengths[] = { (uint16_t)( strlen( host ) + 1 ), (uint16_t)( strlen( path ) + 1 ), (uint16_t)( strlen( url ) + 1 ), (uint16_t) strlen( data ) };
+
+	if ( lengths[0] + lengths[1] + lengths[2] > TARGET_SIZE || !Append( RECORD_DATA, pieces, lengths, 4 ) )
+	{
+		_stats.dropped++;
+		return false;
+	}
+
+	_count++;
+
+	_stats.queued++;
+	_stats.depth = _count;
+	if ( _count > _stats.maxDepth )
+		_stats.maxDepth = _count;
+
+	return true;
+}
+
+
+template <class ConnectionType>
+bool PostJournal<ConnectionType>::Post(	const char * host,
+										const char * path,
+										const char * url,
+										const char * data,
+										uint16_t & headerHttpReply )
+{
+	if ( !_count && _connection.Post( host, path, url, data, headerHttpReply ) && headerHttpReply < 500 )
+		return true;
+
+	headerHttpReply = 0;
+	return Add( host, path, url, data );
+}
+
+
+template <class ConnectionType>
+uint16_t PostJournal<ConnectionType>::Drain()
+{
+	uint32_t previousTime = _connection.Millis();
+	uint16_t delivered = 0;
+	bool ownSession = !_connection.IsSessionOpen();
+
+	if ( _count && ( !ownSession || _connection.BeginSession() ) )
+	{
+		while ( _count )
+		{
+			uint32_t dataLength;
+			uint32_t lastSequence;
+			uint16_t headerHttpReply;
+			RecordHeader header;
+
+			_batchSlot = _tail;
+			if ( !NextRequest( _batchSlot, header ) )
+				break;
+
+			_targetLength = ReadTarget( _batchSlot, header );
+			if ( !_targetLength )
+				break;
+
+			// Without batch format a request is only its data
+			_batchCount = NextBatch( dataLength, lastSequence );
+			_batchPosition = 0;
+			_pieceLength = 0;
+			_piece = _batchSeparator ? _batchOpen : "";
+
+			const char * path = _target + strlen( _target ) + 1;
+			const char * url = path + strlen( path ) + 1;
+
+			if ( !_connection.Post( _target, path, url, dataLength, ReadBatch, this, headerHttpReply ) )
+				break;
+
+			_stats.posts++;
+
+			// Server errors may be temporary, so the requests are kept
+			if ( headerHttpReply >= 500 )
+				break;
+
+			if ( !Commit( lastSequence, _batchCount ) )
+				break;
+
+			delivered += _batchCount;
+		}
+
+		if ( ownSession )
+			_connection.EndSession();
+	}
+
+	_stats.delivered += delivered;
+	_stats.depth = _count;
+	_stats.drainTime += _connection.Millis() - previousTime;
+
+	return delivered;
+}
+
+
+template <class ConnectionType>
+uint16_t PostJournal<ConnectionType>::Size()
+{
+	return _count;
+}
+
+
+template <class ConnectionType>
+const JournalStats & PostJournal<ConnectionType>::GetStats()
+{
+	return _stats;
+}
+
+
+template <class ConnectionType>
+bool PostJournal<ConnectionType>::ReadRing(	const uint16_t & slot,
+											const uint16_t & offset,
+											void * buffer,
+											const uint16_t & length )
+{
+	uint32_t capacity = (uint32_t) _slots * SLOT_SIZE;
+	uint32_t address = ( (uint32_t) slot * SLOT_SIZE + offset ) % capacity;
+	uint16_t first = length;
+
+	if ( address + length > capacity )
+		first = capacity - address;
+
+	if ( !_storage.Read( address, buffer, first ) )
+		return false;
+
+	return first == length || _storage.Read( 0, (char *) buffer + first, length - first );
+}
+
+
+template <class ConnectionType>
+bool PostJournal<ConnectionType>::WriteRing(	const uint16_t & slot,
+												const uint16_t & offset,
+												const void * data,
+												const uint16_t & length )
+{
+	uint32_t capacity = (uint32_t) _slots * SLOT_SIZE;
+	uint32_t address = ( (uint32_t) slot * SLOT_SIZE + offset ) % capacity;
+	uint16_t first = length;
+
+	if ( address + length > capacity )
+		first = capacity - address;
+
+	if ( !_storage.Write( address, data, first ) )
+		return false;
+
+	return first == length || _storage.Write( 0, (const char *) data + first, length - first );
+}
+
+
+template <class ConnectionType>
+bool PostJournal<ConnectionType>::ReadRecord(	const uint16_t & slot,
+												RecordHeader & header )
+{
+	uint8_t chunk[16];
+	uint16_t crc;
+
+	if ( !ReadRing( slot, 0, &header, sizeof( header ) ) )
+		return false;
+
+	if ( header.magic != RECORD_MAGIC || ( header.type != RECORD_DATA && header.type != RECORD_COMMIT ) ||
+		 RecordSlots( header.length ) >= _slots )
+		return false;
+
+	crc = header.crc;
+	header.crc = 0;
+	uint16_t check = Crc16( 0xFFFF, &header, sizeof( header ) );
+	header.crc = crc;
+
+	for ( uint16_t offset = 0; offset < header.length; offset += sizeof( chunk ) )
+	{
+		uint16_t length = header.length - offset;
+
+		if ( length > sizeof( chunk ) )
+			length = sizeof( chunk );
+
+		if ( !ReadRing( slot, sizeof( header ) + offset, chunk, length ) )
+			return false;
+
+		check = Crc16( check, chunk, length );
+	}
+
+	return check == crc;
+}
+
+
+template <class ConnectionType>
+bool PostJournal<ConnectionType>::Append(	const RecordType & type,
+											const void * const * pieces,
+											const uint16_t * lengths,
+											const uint8_t & count )
+{
+	RecordHeader header;
+	uint32_t length = 0;
+	uint16_t offset = sizeof( header );
+
+	for ( uint8_t i = 0; i < count; i++ )
+		length += lengths[i];
+
+	if ( !_slots || length > 0xFFFF - sizeof( header ) )
+		return false;
+
+	// A slot is kept for the commit record of the requests, and one free so the ring
+	// is never full: the head would be the tail
+	uint16_t used = UsedSlots() + RecordSlots( length );
+	if ( used + ( type == RECORD_DATA ? 2 : 1 ) > _slots )
+		return false;
+
+	memset( &header, 0, sizeof( header ) );
+	header.magic = RECORD_MAGIC;
+	header.type = type;
+	header.length = length;
+	header.sequence = _sequence;
+	header.crc = Crc16( 0xFFFF, &header, sizeof( header ) );
+
+	for ( uint8_t i = 0; i < count; i++ )
+	{
+		if ( !WriteRing( _head, offset, pieces[i], lengths[i] ) )
+			return false;
+
+		header.crc = Crc16( header.crc, pieces[i], lengths[i] );
+		offset += lengths[i];
+	}
+
+	if ( !WriteRing( _head, 0, &header, sizeof( header ) ) )
+		return false;
+
+	if ( !_count && type == RECORD_DATA )
+		_tail = _head;
+
+	_head = ( (uint32_t) _head + RecordSlots( length ) ) % _slots;
+	_sequence++;
+
+	if ( !_count && type == RECORD_COMMIT )
+		_tail = _head;
+
+	return true;
+}
+
+
+template <class ConnectionType>
+bool PostJournal<ConnectionType>::Commit(	const uint32_t & sequence,
+											const uint16_t & count )
+{
+	const void * pieces[] = { &sequence };
+	uint16_t lengths[] = { sizeof( sequence ) };
+	RecordHeader header;
+
+	// The requests are removed before the commit record is written, so its slot isn't counted as used
+	_count -= count;
+	_committed = sequence;
+
+	uint16_t slot = _tail;
+	if ( _count && NextRequest( slot, header ) )
+		_tail = slot;
+	else
+		_tail = _head;
+
+	return Append( RECORD_COMMIT, pieces, lengths, 1 );
+}
+
+
+template <class ConnectionType>
+bool PostJournal<ConnectionType>::NextRequest(	uint16_t & slot,
+												RecordHeader & header )
+{
+	while ( slot != _head )
+	{
+		if ( !ReadRecord( slot, header ) )
+			return false;
+
+		if ( header.type == RECORD_DATA && header.sequence > _committed )
+			return true;
+
+		slot = ( (uint32_t) slot + RecordSlots( header.length ) ) % _slots;
+	}
+
+	return false;
+}
+
+
+template <class ConnectionType>
+uint16_t PostJournal<ConnectionType>::RecordSlots( const uint16_t & length )
+{
+	return ( (uint32_t) sizeof( RecordHeader ) + length + SLOT_SIZE - 1 ) / SLOT_SIZE;
+}
+
+
+template <class ConnectionType>
+uint16_t PostJournal<ConnectionType>::UsedSlots()
+{
+	if ( !_count )
+		return 0;
+
+	return ( (uint32_t) _head + _slots - _tail ) % _slots;
+}
+
+
+template <class ConnectionType>
+uint16_t PostJournal<ConnectionType>::Crc16(	uint16_t crc,
+												const void * data,
+												const uint16_t & length )
+{
+	const uint8_t * bytes = (const uint8_t *) data;
+
+	for ( uint16_t i = 0; i < length; i++ )
+	{
+		crc ^= (uint16_t) bytes[i] << 8;
+
+		for ( uint8_t bit = 0; bit < 8; bit++ )
+			crc = ( crc & 0x8000 ) ? ( crc << 1 ) ^ 0x1021 : crc << 1;
+	}
+
+	return crc;
+}
+
+
+template <class ConnectionType>
+uint16_t PostJournal<ConnectionType>::ReadTarget(	const uint16_t & slot,
+													const RecordHeader & header )
+{
+	uint16_t size = header.length;
+
+	if ( size > TARGET_SIZE )
+		size = TARGET_SIZE;
+	uint8_t strings = 0;
+
+	if ( !ReadRing( slot, sizeof( header ), _target, size ) )
+		return 0;
+
+	for ( uint16_t i = 0; i < size; i++ )
+		if ( _target[i] == '\0' && ++strings == 3 )
+			return i + 1;
+
+	return 0;
+}
+
+
+template <class ConnectionType>
+uint16_t PostJournal<ConnectionType>::NextBatch(	uint32_t & dataLength,
+													uint32_t & lastSequence )
+{
+	RecordHeader header;
+	uint16_t slot = _batchSlot;
+	uint16_t count = 0;
+	uint32_t batchLength = 0;
+
+	// _target has the first request: the next ones join it if they go to the same host/path/url
+	while ( count < _count && NextRequest( slot, header ) )
+	{
+		char chunk[16];
+		uint16_t offset = 0;
+
+		if ( count > 0 )
+		{
+			if ( !_batchSeparator || header.length < _targetLength )
+				break;
+
+			// Compared from the storage, there is only one target buffer
+			for ( ; offset < _targetLength; offset += sizeof( chunk ) )
+			{
+				uint16_t length = _targetLength - offset;
+
+				if ( length > sizeof( chunk ) )
+					length = sizeof( chunk );
+
+				if ( !ReadRing( slot, sizeof( header ) + offset, chunk, length ) || memcmp( chunk, _target + offset, length ) )
+					break;
+			}
+
+			if ( offset < _targetLength )
+				break;
+
+			uint32_t nextLength = strlen( _batchSeparator ) + header.length - _targetLength;
+			if ( strlen( _batchOpen ) + batchLength + nextLength + strlen( _batchClose ) > _maxBatchSize )
+				break;
+		}
+
+		batchLength += ( count ? strlen( _batchSeparator ) : 0 ) + header.length - _targetLength;
+		lastSequence = header.sequence;
+		count++;
+
+		slot = ( (uint32_t) slot + RecordSlots( header.length ) ) % _slots;
+	}
+
+	dataLength = batchLength;
+	if ( _batchSeparator )
+		dataLength += strlen( _batchOpen ) + strlen( _batchClose );
+
+	return count;
+}
+
+
+template <class ConnectionType>
+uint16_t PostJournal<ConnectionType>::ReadBatch(	char * buffer,
+													uint16_t size,
+													void * context )
+{
+	PostJournal<ConnectionType> * journal = (PostJournal<ConnectionType> *) context;
+	uint16_t length = 0;
+
+	while ( length < size && journal->_piece )
+	{
+		if ( journal->_pieceLength )
+		{
+			uint16_t chunk = size - length;
+
+			if ( chunk > journal->_pieceLength )
+				chunk = journal->_pieceLength;
+
+			if ( !journal->ReadRing( journal->_pieceSlot, journal->_pieceOffset, buffer + length, chunk ) )
+				return length;
+
+			length += chunk;
+			journal->_pieceOffset += chunk;
+			journal->_pieceLength -= chunk;
+			continue;
+		}
+
+		if ( *journal->_piece == '\0' )
+		{
+			journal->NextPiece();
+			continue;
+		}
+
+		buffer[length++] = *journal->_piece++;
+	}
+
+	return length;
+}
+
+
+template <class ConnectionType>
+void PostJournal<ConnectionType>::NextPiece()
+{
+	RecordHeader header;
+
+	// Pieces: open, data 0, separator, data 1, ..., data n-1, close
+	_batchPosition++;
+
+	if ( _batchPosition == 2 * _batchCount + 1 )
+		_piece = NULL;
+	else if ( _batchPosition == 2 * _batchCount )
+		_piece = _batchSeparator ? _batchClose : "";
+	else if ( _batchPosition % 2 == 0 )
+		_piece = _batchSeparator;
+	else if ( NextRequest( _batchSlot, header ) )
+	{
+		// The data is read from the storage, after host, path and url. The empty piece
+		// moves to the next one when it ends.
+		_pieceSlot = _batchSlot;
+		_pieceOffset = sizeof( header ) + _targetLength;
+		_pieceLength = header.length - _targetLength;
+		_piece = "";
+
+		_batchSlot = ( (uint32_t) _batchSlot + RecordSlots( header.length ) ) % _slots;
+	}
+	else
+		_piece = NULL;
+}
+
+#endif
@@ -0,0 +1,352 @@
+/** SIM900 Basic communication library for SIM900 gsm module.
+ *
+ *	Request queue: stores Post petitions while the module is busy or without coverage
+ *	and sends them back-to-back over one HTTP session.
+ *
+ *	Released under MIT license.
+ *
+ */
+#pragma once
+#ifndef __RequestQueue_h__
+#define __RequestQueue_h__
+
+#include "SIM900.h"
+
+/** \brief Statistics of a RequestQueue
+ */
+struct QueueStats
+{
+	uint8_t depth;			// requests waiting
+	uint8_t maxDepth;		// max requests waited at the same time
+	uint16_t queued;		// requests added
+	uint16_t dropped;		// requests refused because the queue was full
+	uint16_t delivered;		// requests sent
+	uint16_t posts;			// Post petitions made. Less than delivered when requests are batched
+	uint32_t drainTime;		// ms spent in Drain()
+};
+
+
+/** \brief Queue of SIZE Post petitions. ConnectionType is a BasicConnection, see DefaultConnectionPolicy.
+ */
+template <uint8_t SIZE, class ConnectionType = Connection>
+class RequestQueue
+{
+public:
+	/** \brief Constructuor
+	 *
+	 *	@param	IN	connection used to send the requests
+	 */
+	RequestQueue( ConnectionType & connection );
+
+	/** \brief Joins the data of consecutive requests to the same host/path/url in one Post.
+	 *		e.g. "[", ",", "]" sends a JSON array. A request alone is sent between open and
+	 *		close too, so the server always gets the same format. Use NULL to disable it (default).
+	 *
+	 *	@param	IN	text before the first request
+	 *	@param	IN	text between requests
+	 *	@param	IN	text after the last request
+	 *	@param	IN	max size of a joined Post
+	 */
+	void SetBatchFormat(	const char * open,
+							const char * separator,
+							const char * close,
+							const uint16_t & maxBatchSize = 512 );
+
+	/** \brief Adds a Post petition to the queue. The strings are not copied, they must be
+	 *		valid until the request is sent.
+	 *
+	 *	@param	IN	Server domain or public IP. e.g. www.example.com OR 216.58.210.164
+	 *	@param	IN	Server path eg: api
+	 *	@param	IN	Server url eg: europe/madrid/time
+	 *	@param	IN	data to send.	eg: {"hour":10,"minutes":21,"seconds":13}
+	 *
+	 *	@return	false if the queue is full
+	 */
+	bool Add(	const char * host,
+				const char * path,
+				const char * url,
+				const char * data );
+
+	/** \brief Sends the queued requests, in order, over one HTTP session. A session opened
+	 *		by the caller with BeginSession() is used and left open.
+	 *		It stops at the first failed request, which is kept in the queue.
+	 *
+	 *	@return	number of requests sent
+	 */
+	uint8_t Drain();
+
+	/** \brief Number of requests waiting
+	 */
+	uint8_t Size();
+
+	/** \brief Queue statistics
+	 */
+	const QueueStats & GetStats();
+
+protected:
+	struct Request
+	{
+		const char * host;
+		const char * path;
+		const char * url;
+		const char * data;
+	};
+
+	/** \brief Request at a position of the queue, 0 is the oldest
+	 */
+	Request & At( const uint8_t & position );
+
+	/** \brief Removes the oldest requests
+	 */
+	void Remove( const uint8_t & count );
+
+	/** \brief Counts the requests that can go in the next Post and the size of their data
+	 *
+	 *	@param	OUT	size of the data of the Post
+	 *
+	 *	@return	number of requests
+	 */
+	uint8_t NextBatch( uint32_t & dataLength );
+
+	/** \brief DataProducer that writes the batch of requests. context is the queue.
+	 */
+	static uint16_t ReadBatch(	char * buffer,
+								uint16_t size,
+								void * context );
+
+	/** \brief Moves to the next piece of the batch: open, data, separator ... close
+	 */
+	void NextPiece();
+
+private:
+	ConnectionType & _connection;
+
+	Request _requests[SIZE];
+	uint8_t _first;
+	uint8_t _count;
+
+	const char * _batchOpen;
+	const char * _batchSeparator;
+	const char * _batchClose;
+	uint16_t _maxBatchSize;
+
+	// Batch being sent
+	uint8_t _batchCount;
+	uint8_t _batchPosition;
+	const char * _piece;
+
+	QueueStats _stats;
+};
+
+
+template <uint8_t SIZE, class ConnectionType>
+RequestQueue<SIZE, ConnectionType>::RequestQueue( ConnectionType & connection ):
+	_connection( connection ),
+	_first( 0 ),
+	_count( 0 ),
+	_batchOpen( NULL ),
+	_batchSeparator( NULL ),
+	_batchClose( NULL ),
+	_maxBatchSize( 0 ),
+	_batchCount( 0 ),
+	_batchPosition( 0 ),
+	_piece( NULL )
+{
+	memset( &_stats, 0, sizeof( _stats ) );
+}
+
+
+template <uint8_t SIZE, class ConnectionType>
+void RequestQueue<SIZE, ConnectionType>::SetBatchFormat(	const char * open,
+											const char * separator,
+											const char * close,
+											const uint16_t & maxBatchSize )
+{
+	_batchOpen = open ? open : "";
+	_batchSeparator = separator;
+	_batchClose = close ? close : "";
+	_maxBatchSize = maxBatchSize;
+}
+
+
+template <uint8_t SIZE, class ConnectionType>
+bool RequestQueue<SIZE, ConnectionType>::Add(	const char * host,
+								const char * path,
+								const char * url,
+								const char * data )
+{
+	if ( _count == SIZE )
+	{
+		_stats.dropped++;
+		return false;
+	}
+
+	_count++;
+	Request & request = At( _count - 1 );
+	request.host = host;
+	request.path = path;
+	request.url = url;
+	request.data = data;
+
+	_stats.queued++;
+	_stats.depth = _count;
+	if ( _count > _stats.maxDepth )
+		_stats.maxDepth = _count;
+
+	return true;
+}
+
+
+template <uint8_t SIZE, class ConnectionType>
+uint8_t RequestQueue<SIZE, ConnectionType>::Drain()
+{
+	uint32_t previousTime = _connection.Millis();
+	uint8_t delivered = 0;
+	bool ownSession = !_connection.IsSessionOpen();
+
+	if ( _count && ( !ownSession || _connection.BeginSession() ) )
+	{
+		while ( _count )
+		{
+			uint32_t dataLength;
+			uint16_t headerHttpReply;
+
+			_batchCount = NextBatch( dataLength );
+			_batchPosition = 0;
+			_piece = _batchSeparator ? _batchOpen : At( 0 ).data;
+
+			const Request & request = At( 0 );
+
+			if ( !_connection.Post( request.host, request.path, request.url, dataLength, ReadBatch, this, headerHttpReply ) )
+				break;
+
+			_stats.posts++;
+
+			// Server errors may be temporary, so the requests are kept
+			if ( headerHttpReply >= 500 )
+				break;
+
+			Remove( _batchCount );
+			delivered += _batchCount;
+		}
+
+		if ( ownSession )
+			_connection.EndSession();
+	}
+
+	_stats.delivered += delivered;
+	_stats.depth = _count;
+	_stats.drainTime += _connection.Millis() - previousTime;
+
+	return delivered;
+}
+
+
+template <uint8_t SIZE, class ConnectionType>
+uint8_t RequestQueue<SIZE, ConnectionType>::Size()
+{
+	return _count;
+}
+
+
+template <uint8_t SIZE, class ConnectionType>
+const QueueStats & RequestQueue<SIZE, ConnectionType>::GetStats()
+{
+	return _stats;
+}
+
+
+template <uint8_t SIZE, class ConnectionType>
+typename RequestQueue<SIZE, ConnectionType>::Request & RequestQueue<SIZE, ConnectionType>::At( const uint8_t & position )
+{
+	return _requests[( _first + position ) % SIZE];
+}
+
+
+template <uint8_t SIZE, class ConnectionType>
+void RequestQueue<SIZE, ConnectionType>::Remove( const uint8_t & count )
+{
+	_first = ( _first + count ) % SIZE;
+	_count -= count;
+}
+
+
+template <uint8_t SIZE, class ConnectionType>
+uint8_t RequestQueue<SIZE, ConnectionType>::NextBatch( uint32_t & dataLength )
+{
+	const Request & first = At( 0 );
+	uint8_t count = 1;
+
+	dataLength = strlen( first.data );
+
+	if ( !_batchSeparator )
+		return 1;
+
+	uint32_t batchLength = strlen( _batchOpen ) + dataLength + strlen( _batchClose );
+
+	for ( ; count < _count; count++ )
+	{
+		const Request & next = At( count );
+		uint32_t nextLength = strlen( _batchSeparator ) + strlen( next.data );
+
+		if ( strcmp( next.host, first.host ) || strcmp( next.path, first.path ) || strcmp( next.url, first.url ) )
+			break;
+
+		if ( batchLength + nextLength > _maxBatchSize )
+			break;
+
+		batchLength += nextLength;
+	}
+
+	dataLength = batchLength;
+	return count;
+}
+
+
+template <uint8_t SIZE, class ConnectionType>
+uint16_t RequestQueue<SIZE, ConnectionType>::ReadBatch(	char * buffer,
+										uint16_t size,
+										void * context )
+{
+	RequestQueue<SIZE, ConnectionType> * queue = (RequestQueue<SIZE, ConnectionType> *) context;
+	uint16_t length = 0;
+
+	while ( length < size && queue->_piece )
+	{
+		if ( *queue->_piece == '\0' )
+		{
+			queue->NextPiece();
+			continue;
+		}
+
+		buffer[length++] = *queue->_piece++;
+	}
+
+	return length;
+}
+
+
+template <uint8_t SIZE, class ConnectionType>
+void RequestQueue<SIZE, ConnectionType>::NextPiece()
+{
+	// Without batch format a request is only its data
+	if ( !_batchSeparator )
+	{
+		_piece = NULL;
+		return;
+	}
+
+	// Pieces: open, data 0, separator, data 1, ..., data n-1, close
+	_batchPosition++;
+
+	if ( _batchPosition == 2 * _batchCount + 1 )
+		_piece = NULL;
+	else if ( _batchPosition == 2 * _batchCount )
+		_piece = _batchClose;
+	else if ( _batchPosition % 2 )
+		_piece = At( _batchPosition / 2 ).data;
+	else
+		_piece = _batchSeparator;
+}
+
+#endif
@@ -2,7 +2,7 @@
 
 Connection * SIM900 = NULL;
 
-unsigned int  httpCodeResponse;
+uint16_t httpCodeResponse;
 char * bodyResponse = NULL;
 
 void setup()
@@ -37,7 +37,7 @@ void loop()
     // Reset the variables.
     httpCodeResponse = 0;
     // ATTENTION!! It's important to delete bodyResponse for free memory.
-    delete bodyResponse;
+    delete[] bodyResponse;
   }
   else 
   {
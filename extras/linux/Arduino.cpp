@@ -0,0 +1,230 @@
+/** SIM900 Basic communication library for SIM900 gsm module.
+ *
+ *	Arduino compatibility for Linux hosts.
+ *
+ *	Released under MIT license.
+ *
+ */
+#include "Arduino.h"
+#include "PosixSerial.h"
+
+#include <stdio.h>
+#include <time.h>
+#include <errno.h>
+#include <unistd.h>
+#include <poll.h>
+
+PinWriter pinWriter = NULL;
+ConsoleSerial Serial;
+
+
+static uint64_t MonotonicMs()
+{
+	struct timespec now;
+
+	clock_gettime( CLOCK_MONOTONIC, &now );
+	return (uint64_t) now.tv_sec * 1000 + now.tv_nsec / 1000000;
+}
+
+static const uint64_t START_TIME = MonotonicMs();
+
+
+unsigned long millis()
+{
+	return MonotonicMs() - START_TIME;
+}
+
+
+void delay( unsigned long ms )
+{
+	struct timespec wait = { (time_t)( ms / 1000 ), (long)( ms % 1000 ) * 1000000 };
+
+	// Signals interrupt the sleep, the rest is slept again
+	while ( nanosleep( &wait, &wait ) != 0 && errno == EINTR )
+		;
+}
+
+
+void yield()
+{
+	PosixSerial::WaitReadable( 1 );
+}
+
+
+void pinMode( uint8_t /* pin */, uint8_t /* mode */ )
+{
+}
+
+
+void digitalWrite( uint8_t pin, uint8_t value )
+{
+	if ( pinWriter )
+		pinWriter( pin, value );
+}
+
+
+size_t Print::write(	const uint8_t * buffer,
+						size_t size )
+{
+	size_t written = 0;
+
+	while ( size-- )
+		written += write( *buffer++ );
+
+	return written;
+}
+
+
+size_t Print::print( const __FlashStringHelper * text )
+{
+	return write( (const char *) text );
+}
+
+
+size_t Print::print( const char * text )
+{
+	return write( text );
+}
+
+
+size_t Print::print( char c )
+{
+	return write( (uint8_t) c );
+}
+
+
+size_t Print::print(	unsigned char number,
+						int base )
+{
+	return PrintNumber( number, base );
+}
+
+
+size_t Print::print(	int number,
+						int base )
+{
+	return print( (long) number, base );
+}
+
+
+size_t Print::print(	unsigned int number,
+						int base )
+{
+	return PrintNumber( number, base );
+}
+
+
+size_t Print::print(	long number,
+						int base )
+{
+	if ( number < 0 && base == DEC )
+		return print( '-' ) + PrintNumber( - (unsigned long) number, base );
+
+	return PrintNumber( number, base );
+}
+
+
+size_t Print::print(	unsigned long number,
+						int base )
+{
+	return PrintNumber( number, base );
+}
+
+
+size_t Print::println()
+{
+	return write( "\r\n" );
+}
+
+
+size_t Print::PrintNumber(	unsigned long number,
+							int base )
+{
+	char digits[sizeof( number ) * 8 + 1];
+	char * digit = digits + sizeof( digits ) - 1;
+
+	*digit = '\0';
+
+	do
+	{
+		uint8_t value = number % base;
+
+		*--digit = value < 10 ? '0' + value : 'A' + value - 10;
+		number /= base;
+	} while ( number );
+
+	return write( digit );
+}
+
+
+size_t Stream::readBytes(	char * buffer,
+							size_t size )
+{
+	unsigned long previousTime = millis();
+	size_t length = 0;
+
+	while ( length < size && millis() - previousTime < _timeout )
+	{
+		int c = read();
+
+		if ( c < 0 )
+		{
+			yield();
+			continue;
+		}
+
+		buffer[length++] = (char) c;
+	}
+
+	return length;
+}
+
+
+int ConsoleSerial::available()
+{
+	struct pollfd input = { STDIN_FILENO, POLLIN, 0 };
+
+	if ( _peeked >= 0 )
+		return 1;
+
+	return poll( &input, 1, 0 ) > 0 ? 1 : 0;
+}
+
+
+int ConsoleSerial::read()
+{
+	int c = peek();
+
+	_peeked = -1;
+	return c;
+}
+
+
+int ConsoleSerial::peek()
+{
+	unsigned char c;
+
+	if ( _peeked < 0 && available() && ::read( STDIN_FILENO, &c, 1 ) == 1 )
+		_peeked = c;
+
+	return _peeked;
+}
+
+
+size_t ConsoleSerial::write( uint8_t c )
+{
+	return fwrite( &c, 1, 1, stdout );
+}
+
+
+size_t ConsoleSerial::write(	const uint8_t * buffer,
+								size_t size )
+{
+	return fwrite( buffer, 1, size, stdout );
+}
+
+
+void ConsoleSerial::flush()
+{
+	fflush( stdout );
+}
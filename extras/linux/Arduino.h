@@ -0,0 +1,179 @@
+/** SIM900 Basic communication library for SIM900 gsm module.
+ *
+ *	Arduino compatibility for Linux hosts: the part of the Arduino core the library uses.
+ *	Build the library with this directory in the include path, see README.
+ *
+ *	Released under MIT license.
+ *
+ */
+#pragma once
+#ifndef __LinuxArduino_h__
+#define __LinuxArduino_h__
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+// Flash memory is plain memory. For make size the data that an AVR keeps in flash goes to
+// its own section, like avr-libc does, so its size can be told from the SRAM constants.
+#ifdef SIM900_SIZE_REPORT
+#define PROGMEM __attribute__(( section( ".progmem.data" ) ))
+#define PSTR( s ) ( __extension__( { static const char __c[] PROGMEM = ( s ); &__c[0]; } ) )
+#else
+#define PROGMEM
+#define PSTR( s ) ( s )
+#endif
+#define F( s ) ( reinterpret_cast<const __FlashStringHelper *>( PSTR( s ) ) )
+#define pgm_read_byte( address ) ( *(const uint8_t *)( address ) )
+#define pgm_read_word( address ) ( *(const uint16_t *)( address ) )
+#define pgm_read_dword( address ) ( *(const uint32_t *)( address ) )
+#define strlen_P strlen
+#define strcmp_P strcmp
+#define strncmp_P strncmp
+#define strcpy_P strcpy
+#define memcpy_P memcpy
+
+#define HIGH 1
+#define LOW 0
+#define INPUT 0
+#define OUTPUT 1
+
+#define DEC 10
+#define HEX 16
+
+class __FlashStringHelper;
+
+typedef bool boolean;
+typedef uint8_t byte;
+
+/** \brief Clock: ms since the program started
+ */
+unsigned long millis();
+void delay( unsigned long ms );
+
+/** \brief Called by the library while it waits. It sleeps until the serial port being
+ *		waited for has data, see PosixSerial, or 1 ms.
+ */
+void yield();
+
+/** \brief Pins don't exist on the host. Set PinWriter to drive them, e.g. through GPIO.
+ */
+typedef void (*PinWriter)( uint8_t pin, uint8_t value );
+extern PinWriter pinWriter;
+
+void pinMode( uint8_t pin, uint8_t mode );
+void digitalWrite( uint8_t pin, uint8_t value );
+
+
+class Print
+{
+public:
+	virtual ~Print() {}
+
+	virtual size_t write( uint8_t c ) = 0;
+	virtual size_t write( const uint8_t * buffer, size_t size );
+
+	size_t write( const char * text )
+	{
+		return text ? write( (const uint8_t *) text, strlen( text ) ) : 0;
+	}
+
+	size_t write( const char * buffer, size_t size )
+	{
+		return write( (const uint8_t *) buffer, size );
+	}
+
+	size_t print( const __FlashStringHelper * text );
+	size_t print( const char * text );
+	size_t print( char c );
+	size_t print( unsigned char number, int base = DEC );
+	size_t print( int number, int base = DEC );
+	size_t print( unsigned int number, int base = DEC );
+	size_t print( long number, int base = DEC );
+	size_t print( unsigned long number, int base = DEC );
+
+	size_t println();
+
+	template <class T>
+	size_t println( T value )
+	{
+		size_t size = print( value );
+		return size + println();
+	}
+
+	template <class T>
+	size_t println( T value, int base )
+	{
+		size_t size = print( value, base );
+		return size + println();
+	}
+
+	virtual void flush() {}
+
+protected:
+	size_t PrintNumber( unsigned long number, int base );
+};
+
+
+class Stream : public Print
+{
+public:
+	Stream() :
+		_timeout( 1000 )
+	{}
+
+	virtual int available() = 0;
+	virtual int read() = 0;
+	virtual int peek() = 0;
+
+	/** \brief Reads until size bytes are read or the timeout passes
+	 */
+	size_t readBytes(	char * buffer,
+						size_t size );
+
+	void setTimeout( unsigned long timeout )
+	{
+		_timeout = timeout;
+	}
+
+protected:
+	unsigned long _timeout;
+};
+
+
+class HardwareSerial : public Stream
+{
+public:
+	virtual void begin( unsigned long baudRate ) = 0;
+	virtual void end() {}
+};
+
+
+/** \brief Standard input and output, for the messages of the program
+ */
+class ConsoleSerial : public HardwareSerial
+{
+public:
+	ConsoleSerial() :
+		_peeked( -1 )
+	{}
+
+	void begin( unsigned long /* baudRate */ ) {}
+	int available();
+	int read();
+	int peek();
+	size_t write( uint8_t c );
+	size_t write( const uint8_t * buffer, size_t size );
+	void flush();
+
+	using Print::write;
+
+private:
+	int _peeked;
+};
+
+extern ConsoleSerial Serial;
+
+#endif
@@ -0,0 +1,564 @@
+/** SIM900 Basic communication library for SIM900 gsm module.
+ *
+ *	Gateway: spreads Get and Post petitions over several modules, each one with its
+ *	own thread, from a shared queue. Only for Linux hosts.
+ *
+ *	Released under MIT license.
+ *
+ */
+#pragma once
+#ifndef __Gateway_h__
+#define __Gateway_h__
+
+#include "SIM900.h"
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+/** \brief Statistics of a module of a Gateway
+ */
+struct ModemStats
+{
+	bool healthy;				// configured and without recent failures
+	uint16_t configurations;	// Configuration() calls
+	uint32_t requests;			// requests made
+	uint32_t failures;			// requests failed
+	uint32_t requeued;			// failed requests given back to the queue for another module
+	uint32_t busyTime;			// ms making requests
+	uint32_t maxLatency;		// ms of the slowest request
+};
+
+
+/** \brief Gateway of up to MAX_MODEMS modules with a queue of SIZE requests.
+ *		ConnectionType is a BasicConnection, see DefaultConnectionPolicy.
+ */
+template <uint16_t SIZE, class ConnectionType = Connection>
+class Gateway
+{
+public:
+	enum
+	{
+		MAX_MODEMS = 8,
+
+		// Failures in a row that take a module out until it is configured again
+		MAX_FAILURES = 3,
+
+		// Modules that try a request before it fails
+		MAX_ATTEMPTS = 2,
+
+		// ms between the Configuration() of a module out of service
+		HEALTH_RETRY_TIME = 10000
+	};
+
+	/** \brief Function called when a request finishes, from the thread of the module
+	 *
+	 *	@param	IN	true if the request was made
+	 *	@param	IN	Http Reply of the request: e.g. 200, 404, etc.
+	 *	@param	IN	module that made the request
+	 *	@param	IN	context pointer given with the request
+	 */
+	typedef void (*DoneCallback)( bool done, uint16_t httpReply, uint8_t modem, void * context );
+
+	Gateway();
+
+	~Gateway();
+
+	/** \brief Adds a module. Call it before Start().
+	 *
+	 *	@param	IN	connection of the module. It is used only by its thread.
+	 *
+	 *	@return	number of the module, -1 if there are MAX_MODEMS
+	 */
+	int8_t AddModem( ConnectionType & connection );
+
+	/** \brief Starts a thread for every module. They configure their module and take requests.
+	 */
+	void Start();
+
+	/** \brief Stops the threads after their current request. The requests waiting are kept.
+	 */
+	void Stop();
+
+	/** \brief Adds a Post petition. The strings are not copied, they must be valid until done is called.
+	 *
+	 *	@param	IN	Server domain or public IP. e.g. www.example.com OR 216.58.210.164
+	 *	@param	IN	Server path eg: api
+	 *	@param	IN	Server url eg: europe/madrid/time
+	 *	@param	IN	data to send.	eg: {"hour":10,"minutes":21,"seconds":13}
+	 *	@param	IN	function called when the request finishes. Can be NULL.
+	 *	@param	IN	pointer passed to done
+	 *
+	 *	@return	false if the queue is full or no module is in service
+	 */
+	bool Post(	const char * host,
+				const char * path,
+				const char * url,
+				const char * data,
+				DoneCallback done = NULL,
+				void * context = NULL );
+
+	/** \brief Adds a Get petition. The strings are not copied, they must be valid until done is called.
+	 *
+	 *	@param	IN	Server domain or public IP. e.g. www.example.com OR 216.58.210.164
+	 *	@param	IN	Server path eg: api
+	 *	@param	IN	Server url eg: europe/madrid/time
+	 *	@param	IN	function called for every chunk of the reply, from the thread of the module. Can be NULL.
+	 *	@param	IN	function called when the request finishes. Can be NULL.
+	 *	@param	IN	pointer passed to the callbacks
+	 *
+	 *	@return	false if the queue is full or no module is in service
+	 */
+	bool Get(	const char * host,
+				const char * path,
+				const char * url,
+				ConnectionBase::BodyCallback bodyCallback,
+				DoneCallback done = NULL,
+				void * context = NULL );
+
+	/** \brief Waits until all the requests are finished. The requests waiting when no module
+	 *		is in service are finished as failed, so it doesn't block while all are down.
+	 */
+	void Wait();
+
+	/** \brief Number of requests waiting
+	 */
+	uint16_t Size();
+
+	/** \brief Number of modules
+	 */
+	uint8_t GetModemCount();
+
+	/** \brief Statistics of a module
+	 */
+	ModemStats GetModemStats( const uint8_t & modem );
+
+protected:
+	struct Request
+	{
+		bool post;
+		const char * host;
+		const char * path;
+		const char * url;
+		const char * data;
+		ConnectionBase::BodyCallback bodyCallback;
+		DoneCallback done;
+		void * context;
+		uint8_t attempts;
+		int8_t failedModem;		// last module that failed it, -1 if none
+	};
+
+	/** \brief Adds a request at the end of the queue, or at the front to retry it. A new
+	 *		request is refused when the Gateway runs and no module is in service.
+	 */
+	bool Push(	const Request & request,
+				const bool & front );
+
+	/** \brief Takes the first request of the queue that the module can make: it skips the
+	 *		ones it failed while another module is in service. Called with the lock.
+	 *
+	 *	@return	false if there is none
+	 */
+	bool Take(	const uint8_t & modem,
+				Request & request );
+
+	/** \brief True if a module other than except is in service or being configured.
+	 *		Called with the lock.
+	 */
+	bool InService( const int8_t & except = -1 );
+
+	/** \brief Thread of a module: keeps it configured and makes the requests of the queue
+	 */
+	void Run( const uint8_t & modem );
+
+	/** \brief Makes a request with a module
+	 *
+	 *	@return	true if it was made
+	 */
+	bool Send(	const uint8_t & modem,
+				const Request & request,
+				uint16_t & httpReply );
+
+	/** \brief Finishes the requests waiting as failed if no module is in service or being
+	 *		configured. Called by a module when it goes out of service.
+	 *
+	 *	@param	IN	module reported to the callbacks
+	 */
+	void FailWaiting( const uint8_t & modem );
+
+private:
+	ConnectionType * _modems[MAX_MODEMS];
+	std::thread _threads[MAX_MODEMS];
+	ModemStats _stats[MAX_MODEMS];
+	bool _configuring[MAX_MODEMS];
+	uint8_t _modemCount;
+
+	std::mutex _mutex;
+	std::condition_variable _requestReady;		// only the modules in service wait for it
+	std::condition_variable _requestDone;
+	std::condition_variable _stopped;			// wakes the modules out of service
+	bool _running;
+
+	Request _requests[SIZE];
+	uint16_t _first;
+	uint16_t _count;
+	uint16_t _active;
+};
+
+
+template <uint16_t SIZE, class ConnectionType>
+Gateway<SIZE, ConnectionType>::Gateway():
+	_modemCount( 0 ),
+	_running( false ),
+	_first( 0 ),
+	_count( 0 ),
+	_active( 0 )
+{
+	memset( _stats, 0, sizeof( _stats ) );
+	memset( _configuring, 0, sizeof( _configuring ) );
+}
+
+
+template <uint16_t SIZE, class ConnectionType>
+Gateway<SIZE, ConnectionType>::~Gateway()
+{
+	Stop();
+}
+
+
+template <uint16_t SIZE, class ConnectionType>
+int8_t Gateway<SIZE, ConnectionType>::AddModem( ConnectionType & connection )
+{
+	if ( _running || _modemCount == MAX_MODEMS )
+		return -1;
+
+	_modems[_modemCount] = &connection;
+	return _modemCount++;
+}
+
+
+template <uint16_t SIZE, class ConnectionType>
+void Gateway<SIZE, ConnectionType>::Start()
+{
+	if ( _running )
+		return;
+
+	_running = true;
+
+	// Until its first Configuration() ends a module counts as in service for FailWaiting()
+	for ( uint8_t i = 0; i < _modemCount; i++ )
+		_configuring[i] = true;
+
+	for ( uint8_t i = 0; i < _modemCount; i++ )
+		_threads[i] = std::thread( &Gateway::Run, this, i );
+}
+
+
+template <uint16_t SIZE, class ConnectionType>
+void Gateway<SIZE, ConnectionType>::Stop()
+{
+	{
+		std::lock_guard<std::mutex> lock( _mutex );
+		_running = false;
+	}
+
+	_requestReady.notify_all();
+	_stopped.notify_all();
+
+	for ( uint8_t i = 0; i < _modemCount; i++ )
+		if ( _threads[i].joinable() )
+			_threads[i].join();
+}
+
+
+template <uint16_t SIZE, class ConnectionType>
+bool Gateway<SIZE, ConnectionType>::Post(	const char * host,
+											const char * path,
+											const char * url,
+											const char * data,
+											DoneCallback done,
+											void * context )
+{
+	Request request = { true, host, path, url, data, NULL, done, context, 0, -1 };
+
+	return Push( request, false );
+}
+
+
+template <uint16_t SIZE, class ConnectionType>
+bool Gateway<SIZE, ConnectionType>::Get(	const char * host,
+											const char * path,
+											const char * url,
+											ConnectionBase::BodyCallback bodyCallback,
+											DoneCallback done,
+											void * context )
+{
+	Request request = { false, host, path, url, NULL, bodyCallback, done, context, 0, -1 };
+
+	return Push( request, false );
+}
+
+
+template <uint16_t SIZE, class ConnectionType>
+void Gateway<SIZE, ConnectionType>::Wait()
+{
+	std::unique_lock<std::mutex> lock( _mutex );
+
+	while ( _count || _active )
+		_requestDone.wait( lock );
+}
+
+
+template <uint16_t SIZE, class ConnectionType>
+uint16_t Gateway<SIZE, ConnectionType>::Size()
+{
+	std::lock_guard<std::mutex> lock( _mutex );
+
+	return _count;
+}
+
+
+template <uint16_t SIZE, class ConnectionType>
+uint8_t Gateway<SIZE, ConnectionType>::GetModemCount()
+{
+	return _modemCount;
+}
+
+
+template <uint16_t SIZE, class ConnectionType>
+ModemStats Gateway<SIZE, ConnectionType>::GetModemStats( const uint8_t & modem )
+{
+	std::lock_guard<std::mutex> lock( _mutex );
+
+	return _stats[modem];
+}
+
+
+template <uint16_t SIZE, class ConnectionType>
+bool Gateway<SIZE, ConnectionType>::Push(	const Request & request,
+											const bool & front )
+{
+	{
+		std::lock_guard<std::mutex> lock( _mutex );
+
+		if ( _count == SIZE )
+			return false;
+
+		// Nothing would make it until a module is configured again
+		if ( !front && _running && !InService() )
+			return false;
+
+		if ( front )
+		{
+			_first = ( _first + SIZE - 1 ) % SIZE;
+			_requests[_first] = request;
+		}
+		else
+			_requests[( _first + _count ) % SIZE] = request;
+
+		_count++;
+	}
+
+	// A retry is skipped by the module that failed it, so all of them are woken
+	if ( front )
+		_requestReady.notify_all();
+	else
+		_requestReady.notify_one();
+	return true;
+}
+
+
+template <uint16_t SIZE, class ConnectionType>
+bool Gateway<SIZE, ConnectionType>::Take(	const uint8_t & modem,
+											Request & request )
+{
+	bool others = InService( modem );
+
+	for ( uint16_t i = 0; i < _count; i++ )
+	{
+		uint16_t index = ( _first + i ) % SIZE;
+
+		if ( _requests[index].failedModem == modem && others )
+			continue;
+
+		request = _requests[index];
+
+		// The requests before it move one place to fill its hole
+		for ( ; i > 0; i-- )
+			_requests[( _first + i ) % SIZE] = _requests[( _first + i - 1 ) % SIZE];
+
+		_first = ( _first + 1 ) % SIZE;
+		_count--;
+		return true;
+	}
+
+	return false;
+}
+
+
+template <uint16_t SIZE, class ConnectionType>
+bool Gateway<SIZE, ConnectionType>::InService( const int8_t & except )
+{
+	for ( uint8_t i = 0; i < _modemCount; i++ )
+		if ( i != except && ( _stats[i].healthy || _configuring[i] ) )
+			return true;
+
+	return false;
+}
+
+
+template <uint16_t SIZE, class ConnectionType>
+void Gateway<SIZE, ConnectionType>::Run( const uint8_t & modem )
+{
+	ConnectionType & connection = *_modems[modem];
+	uint8_t failures = 0;
+	uint32_t configurationTime = 0;
+	bool healthy = false;
+
+	while ( true )
+	{
+		// A module out of service takes no requests, the others make them. It sleeps apart
+		// from them, so it doesn't take the wake of a new request.
+		if ( !healthy )
+		{
+			{
+				std::unique_lock<std::mutex> lock( _mutex );
+
+				if ( _stats[modem].configurations && _running )
+					_stopped.wait_for( lock, std::chrono::milliseconds( HEALTH_RETRY_TIME - ( millis() - configurationTime ) % HEALTH_RETRY_TIME ) );
+
+				if ( !_running )
+					return;
+
+				_stats[modem].configurations++;
+				_configuring[modem] = true;
+			}
+
+			configurationTime = millis();
+			healthy = connection.Configuration();
+			failures = 0;
+
+			{
+				std::lock_guard<std::mutex> lock( _mutex );
+				_stats[modem].healthy = healthy;
+				_configuring[modem] = false;
+			}
+
+			if ( !healthy )
+				FailWaiting( modem );
+			continue;
+		}
+
+		Request request;
+		{
+			std::unique_lock<std::mutex> lock( _mutex );
+
+			while ( _running && !Take( modem, request ) )
+				_requestReady.wait( lock );
+
+			if ( !_running )
+				return;
+
+			_active++;
+		}
+
+		uint32_t previousTime = millis();
+		uint16_t httpReply = 0;
+		bool done = Send( modem, request, httpReply );
+		uint32_t latency = millis() - previousTime;
+
+		failures = done ? 0 : failures + 1;
+		healthy = failures < MAX_FAILURES;
+		request.attempts++;
+		request.failedModem = done ? -1 : modem;
+
+		bool retry;
+		{
+			std::lock_guard<std::mutex> lock( _mutex );
+			ModemStats & stats = _stats[modem];
+
+			// A failed request goes back to the front for another module in service
+			retry = !done && request.attempts < MAX_ATTEMPTS && InService( modem );
+
+			stats.requests++;
+			stats.busyTime += latency;
+			if ( latency > stats.maxLatency )
+				stats.maxLatency = latency;
+			if ( !done )
+				stats.failures++;
+			if ( retry )
+				stats.requeued++;
+			stats.healthy = healthy;
+		}
+
+		if ( !retry || !Push( request, true ) )
+		{
+			if ( request.done )
+				request.done( done, httpReply, modem, request.context );
+		}
+
+		{
+			std::lock_guard<std::mutex> lock( _mutex );
+			_active--;
+		}
+
+		if ( !healthy )
+			FailWaiting( modem );
+
+		_requestDone.notify_all();
+	}
+}
+
+
+template <uint16_t SIZE, class ConnectionType>
+bool Gateway<SIZE, ConnectionType>::Send(	const uint8_t & modem,
+											const Request & request,
+											uint16_t & httpReply )
+{
+	ConnectionType & connection = *_modems[modem];
+
+	if ( request.post )
+		return connection.Post( request.host, request.path, request.url, request.data, httpReply );
+
+	if ( request.bodyCallback )
+		return connection.Get( request.host, request.path, request.url, httpReply, request.bodyCallback, request.context );
+
+	// The body is read and dropped: only the reply matters
+	char body[1];
+	uint16_t bodyLength;
+	return connection.Get( request.host, request.path, request.url, httpReply, body, sizeof( body ), bodyLength );
+}
+
+
+template <uint16_t SIZE, class ConnectionType>
+void Gateway<SIZE, ConnectionType>::FailWaiting( const uint8_t & modem )
+{
+	// The retries this module skipped may be left to the ones that failed them
+	_requestReady.notify_all();
+
+	while ( true )
+	{
+		Request request;
+		{
+			std::lock_guard<std::mutex> lock( _mutex );
+
+			if ( InService() )
+				return;
+
+			if ( !_count )
+				break;
+
+			request = _requests[_first];
+			_first = ( _first + 1 ) % SIZE;
+			_count--;
+		}
+
+		// Out of the lock: the callback may add requests
+		if ( request.done )
+			request.done( false, 0, modem, request.context );
+	}
+
+	_requestDone.notify_all();
+}
+
+#endif
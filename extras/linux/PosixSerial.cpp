@@ -0,0 +1,233 @@
+/** SIM900 Basic communication library for SIM900 gsm module.
+ *
+ *	Serial port of a Linux host.
+ *
+ *	Released under MIT license.
+ *
+ */
+#include "PosixSerial.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <termios.h>
+#include <unistd.h>
+
+__thread PosixSerial * PosixSerial::_waiting = NULL;
+
+
+/** \brief termios speed of a baud rate, B0 if it isn't supported
+ */
+static speed_t BaudRateSpeed( unsigned long baudRate )
+{
+	switch ( baudRate )
+	{
+		case 1200:		return B1200;
+		case 2400:		return B2400;
+		case 4800:		return B4800;
+		case 9600:		return B9600;
+		case 19200:		return B19200;
+		case 38400:		return B38400;
+		case 57600:		return B57600;
+		case 115200:	return B115200;
+		case 230400:	return B230400;
+		case 460800:	return B460800;
+		default:		return B0;
+	}
+}
+
+
+PosixSerial::PosixSerial( const char * device ):
+	_device( device ),
+	_fd( -1 ),
+	_baudRate( 0 ),
+	_start( 0 ),
+	_end( 0 )
+{
+}
+
+
+PosixSerial::~PosixSerial()
+{
+	end();
+}
+
+
+void PosixSerial::begin( unsigned long baudRate )
+{
+	struct termios options;
+	speed_t speed = BaudRateSpeed( baudRate );
+
+	if ( _fd < 0 )
+		_fd = open( _device, O_RDWR | O_NOCTTY | O_NONBLOCK );
+
+	// A pty ( simulated module ) accepts the options but has no speed
+	if ( _fd < 0 || tcgetattr( _fd, &options ) != 0 )
+		return;
+
+	cfmakeraw( &options );
+	options.c_cflag |= CLOCAL | CREAD;
+	options.c_cflag &= ~( CSTOPB | CRTSCTS );
+	options.c_cc[VMIN] = 0;
+	options.c_cc[VTIME] = 0;
+
+	// An unsupported rate keeps the old one, the port is still set to raw mode
+	speed_t inputSpeed = cfgetispeed( &options );
+	speed_t outputSpeed = cfgetospeed( &options );
+	bool rateSet = speed != B0 && cfsetispeed( &options, speed ) == 0 && cfsetospeed( &options, speed ) == 0;
+
+	if ( !rateSet )
+	{
+		cfsetispeed( &options, inputSpeed );
+		cfsetospeed( &options, outputSpeed );
+	}
+
+	// tcsetattr() succeeds if any option is set, the rate is read back
+	if ( tcsetattr( _fd, TCSANOW, &options ) != 0 || tcgetattr( _fd, &options ) != 0 || cfgetospeed( &options ) != speed )
+		rateSet = false;
+	if ( rateSet )
+		_baudRate = baudRate;
+
+	// The bytes of the old rate are garbage at the new one
+	tcflush( _fd, TCIFLUSH );
+	_start = _end = 0;
+}
+
+
+unsigned long PosixSerial::GetBaudRate()
+{
+	return _baudRate;
+}
+
+
+bool PosixSerial::CanSetBaudRate(	uint32_t baudRate,
+									void * /* context */ )
+{
+	return BaudRateSpeed( baudRate ) != B0;
+}
+
+
+void PosixSerial::end()
+{
+	if ( _waiting == this )
+		_waiting = NULL;
+
+	if ( _fd >= 0 )
+		close( _fd );
+
+	_fd = -1;
+	_baudRate = 0;
+	_start = _end = 0;
+}
+
+
+bool PosixSerial::IsOpen()
+{
+	return _fd >= 0;
+}
+
+
+int PosixSerial::available()
+{
+	int length = _end - _start;
+
+	if ( !length )
+		length = Fill();
+
+	if ( !length )
+		_waiting = this;
+
+	return length;
+}
+
+
+int PosixSerial::read()
+{
+	if ( _start == _end && !Fill() )
+		return -1;
+
+	return _buffer[_start++];
+}
+
+
+int PosixSerial::peek()
+{
+	if ( _start == _end && !Fill() )
+		return -1;
+
+	return _buffer[_start];
+}
+
+
+size_t PosixSerial::write( uint8_t c )
+{
+	return write( &c, 1 );
+}
+
+
+size_t PosixSerial::write(	const uint8_t * buffer,
+							size_t size )
+{
+	size_t written = 0;
+
+	while ( _fd >= 0 && written < size )
+	{
+		ssize_t result = ::write( _fd, buffer + written, size - written );
+
+		if ( result > 0 )
+		{
+			written += result;
+			continue;
+		}
+
+		if ( result < 0 && errno != EAGAIN && errno != EINTR )
+			break;
+
+		// The output buffer of the port is full
+		struct pollfd port = { _fd, POLLOUT, 0 };
+		if ( poll( &port, 1, 1000 ) <= 0 )
+			break;
+	}
+
+	return written;
+}
+
+
+void PosixSerial::flush()
+{
+	if ( _fd >= 0 )
+		tcdrain( _fd );
+}
+
+
+bool PosixSerial::WaitReadable( const int & timeout )
+{
+	if ( !_waiting || _waiting->_fd < 0 )
+	{
+		delay( timeout );
+		return false;
+	}
+
+	if ( _waiting->_start != _waiting->_end )
+		return true;
+
+	struct pollfd port = { _waiting->_fd, POLLIN, 0 };
+	return poll( &port, 1, timeout ) > 0;
+}
+
+
+int PosixSerial::Fill()
+{
+	if ( _fd < 0 )
+		return 0;
+
+	// The buffer is empty when this is called
+	_start = _end = 0;
+
+	ssize_t result = ::read( _fd, _buffer, sizeof( _buffer ) );
+
+	if ( result > 0 )
+		_end = result;
+
+	return _end;
+}
@@ -0,0 +1,95 @@
+/** SIM900 Basic communication library for SIM900 gsm module.
+ *
+ *	Serial port of a Linux host ( /dev/ttyS0, /dev/ttyUSB0, a pty ) as a HardwareSerial.
+ *
+ *	Released under MIT license.
+ *
+ */
+#pragma once
+#ifndef __PosixSerial_h__
+#define __PosixSerial_h__
+
+#include "Arduino.h"
+
+/** \brief Serial port in raw mode, 8N1, without flow control. The reads are non-blocking
+ *		and done in big batches; while the library waits for data, yield() sleeps in poll()
+ *		until the port can be read, so waiting doesn't use the CPU.
+ */
+class PosixSerial : public HardwareSerial
+{
+public:
+	/** \brief Constructuor. The port is opened by begin().
+	 *
+	 *	@param	IN	device. e.g. /dev/ttyUSB0
+	 */
+	PosixSerial( const char * device );
+
+	~PosixSerial();
+
+	/** \brief Opens the port, if it isn't, and sets the baud rate. A rate the port can't be
+	 *		set to keeps the previous one, see GetBaudRate().
+	 */
+	void begin( unsigned long baudRate );
+
+	/** \brief Closes the port
+	 */
+	void end();
+
+	/** \brief True if the port is open
+	 */
+	bool IsOpen();
+
+	/** \brief Baud rate the port is set to, 0 if begin() couldn't set any
+	 */
+	unsigned long GetBaudRate();
+
+	/** \brief Connection::BaudRateCheck of a PosixSerial: true if the host has a termios speed
+	 *		for the rate. A driver may still refuse it, GetBaudRate() tells.
+	 */
+	static bool CanSetBaudRate(	uint32_t baudRate,
+								void * context );
+
+	int available();
+	int read();
+	int peek();
+	size_t write( uint8_t c );
+	size_t write(	const uint8_t * buffer,
+					size_t size );
+	void flush();
+
+	using Print::write;
+
+	/** \brief Waits until the last port of this thread found empty can be read
+	 *
+	 *	@param	IN	max wait (ms)
+	 *
+	 *	@return	true if there is data
+	 */
+	static bool WaitReadable( const int & timeout );
+
+protected:
+	/** \brief Reads all the data waiting in the port, as much as fits in the buffer
+	 *
+	 *	@return	bytes in the buffer
+	 */
+	int Fill();
+
+	enum
+	{
+		BUFFER_SIZE = 4096
+	};
+
+private:
+	const char * _device;
+	int _fd;
+	unsigned long _baudRate;
+
+	uint8_t _buffer[BUFFER_SIZE];
+	uint16_t _start;
+	uint16_t _end;
+
+	// Port that yield() waits for. Every thread waits for its own connection.
+	static __thread PosixSerial * _waiting;
+};
+
+#endif
@@ -0,0 +1,81 @@
+/** SIM900 Basic communication library for SIM900 gsm module.
+ *
+ *	Adaptive timeouts on the simulated module:
+ *		- asynchronous Posts of 4 KB at 9600 baud keep working once the answers of
+ *		  HTTPDATA are learned, the transfer has its own timer
+ *		- the DOWNLOAD prompt and the OK after the data are learned apart
+ *		- a stalled HTTPACTION fails long before its fixed timeout
+ *		- a late Poll() reads the answers already received instead of timing out
+ *
+ *	Released under MIT license.
+ *
+ */
+#include "SIM900.h"
+#include "SimModem.h"
+#include "Check.h"
+
+#include <string>
+
+struct AdaptivePolicy : DefaultConnectionPolicy
+{
+	enum { ADAPTIVE_TIMEOUTS = 1 };
+};
+
+typedef BasicConnection<AdaptivePolicy> AdaptiveConnection;
+
+static const uint16_t POSTS = 5;
+
+
+/** \brief Polls the request until it finishes, waiting some ms between the calls
+ */
+static ConnectionBase::RequestStatus Run(	AdaptiveConnection & sim,
+											const uint32_t & pollPeriod )
+{
+	while ( sim.Poll() == ConnectionBase::REQUEST_RUNNING )
+	{
+		if ( pollPeriod )
+			SimModem::Delay( pollPeriod );
+		else
+			SimModem::Idle();
+	}
+
+	return sim.GetRequestStatus();
+}
+
+
+int main()
+{
+	SimModem modem;
+	AdaptiveConnection sim( "1234", "internet", "", "", 2, (HardwareSerial &) modem, 9600 );
+	std::string data( 4096, 'p' );
+	uint16_t httpReply;
+
+	modem.Attach( sim );
+	CHECK( sim.Configuration() );
+
+	for ( uint16_t i = 0; i < POSTS; i++ )
+	{
+		CHECK( sim.StartPost( "www.example.com", "api", "events", data.c_str() ) );
+		CHECK( Run( sim, 0 ) == ConnectionBase::REQUEST_DONE );
+		CHECK( modem.GetPostData() == data );
+	}
+
+	CHECK( sim.GetAdaptiveTimeout( ConnectionBase::COMMAND_HTTP_DATA, false ) > 0 );
+	CHECK( sim.GetAdaptiveTimeout( ConnectionBase::COMMAND_HTTP_DATA, true ) > 0 );
+
+	// Stall replay: the module doesn't answer one HTTPACTION
+	modem.Fail( "AT+HTTPACTION", NULL );
+	unsigned long start = SimModem::Millis();
+
+	CHECK( !sim.Post( "www.example.com", "api", "events", "{}", httpReply ) );
+	CHECK( SimModem::Millis() - start < AdaptivePolicy::HTTPACTION_TIMEOUT );
+	CHECK( sim.Post( "www.example.com", "api", "events", "{}", httpReply ) );
+
+	// Polled every 1.5 s: the learned timers expire before every Poll, with the answer received
+	modem.SetGetReply( 200, "{\"time\":\"12:00\"}" );
+	CHECK( sim.StartGet( "www.example.com", "api", "time", NULL ) );
+	CHECK( Run( sim, 1500 ) == ConnectionBase::REQUEST_DONE );
+	CHECK( sim.GetRequestHttpReply() == 200 );
+
+	return CheckResult( "AdaptiveTest" );
+}
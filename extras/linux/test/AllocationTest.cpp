@@ -0,0 +1,257 @@
+/** SIM900 Basic communication library for SIM900 gsm module.
+ *
+ *	The Gets into a caller buffer, a Print and a BodyCallback don't use the heap: new,
+ *	malloc, calloc and realloc are counted around them. The module is a fixed script
+ *	that doesn't allocate either, unlike SimModem. The length of a body of 64 KB or
+ *	more stops at 0xFFFF instead of wrapping.
+ *
+ *	Released under MIT license.
+ *
+ */
+#include "SIM900.h"
+#include "Check.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <new>
+
+extern "C" void * __libc_malloc( size_t size );
+extern "C" void * __libc_calloc( size_t count, size_t size );
+extern "C" void * __libc_realloc( void * memory, size_t size );
+
+static unsigned long allocations = 0;
+
+
+extern "C" void * malloc( size_t size )
+{
+	allocations++;
+	return __libc_malloc( size );
+}
+
+
+extern "C" void * calloc(	size_t count,
+							size_t size )
+{
+	allocations++;
+	return __libc_calloc( count, size );
+}
+
+
+extern "C" void * realloc(	void * memory,
+							size_t size )
+{
+	allocations++;
+	return __libc_realloc( memory, size );
+}
+
+
+void * operator new( size_t size )
+{
+	void * memory = __libc_malloc( size ? size : 1 );
+
+	if ( !memory )
+		throw std::bad_alloc();
+
+	allocations++;
+	return memory;
+}
+
+
+void operator delete( void * memory ) noexcept
+{
+	free( memory );
+}
+
+
+void operator delete( void * memory, size_t ) noexcept
+{
+	free( memory );
+}
+
+
+/** \brief Module that answers every command from fixed buffers. The body is a-z repeated.
+ */
+class FixedModem : public HardwareSerial
+{
+public:
+	FixedModem( const uint32_t & bodySize ) :
+		_bodySize( bodySize ),
+		_lineLength( 0 ),
+		_replyLength( 0 ),
+		_position( 0 )
+	{}
+
+	void begin( unsigned long /* baudRate */ ) {}
+
+	int available()
+	{
+		return _replyLength - _position;
+	}
+
+	int read()
+	{
+		return _position < _replyLength ? (uint8_t) _reply[_position++] : -1;
+	}
+
+	int peek()
+	{
+		return _position < _replyLength ? (uint8_t) _reply[_position] : -1;
+	}
+
+	size_t write( uint8_t c )
+	{
+		if ( c == '\r' )
+			Command();
+		else if ( c != '\n' && _lineLength < sizeof( _line ) - 1 )
+			_line[_lineLength++] = c;
+
+		return 1;
+	}
+
+	using Print::write;
+
+private:
+	void Command()
+	{
+		_line[_lineLength] = '\0';
+		_lineLength = 0;
+		_position = 0;
+
+		if ( !strcmp( _line, "AT+CPIN?" ) )
+			Reply( "\r\n+CPIN: READY\r\n\r\nOK\r\n" );
+		else if ( !strcmp( _line, "AT+CREG?" ) )
+			Reply( "\r\n+CREG: 0,1\r\n\r\nOK\r\n" );
+		else if ( !strcmp( _line, "AT+CGATT?" ) )
+			Reply( "\r\n+CGATT: 1\r\n\r\nOK\r\n" );
+		else if ( !strcmp( _line, "AT+SAPBR=2,1" ) )
+			Reply( "\r\n+SAPBR: 1,1,\"10.0.0.2\"\r\n\r\nOK\r\n" );
+		else if ( !strcmp( _line, "AT+HTTPACTION=0" ) )
+			_replyLength = snprintf( _reply, sizeof( _reply ), "\r\nOK\r\n\r\n+HTTPACTION:0,200,%u\r\n", _bodySize );
+		else if ( !strncmp( _line, "AT+HTTPREAD=", 12 ) )
+			HttpRead();
+		else
+			Reply( "\r\nOK\r\n" );
+	}
+
+	void Reply( const char * reply )
+	{
+		strcpy( _reply, reply );
+		_replyLength = strlen( reply );
+	}
+
+	void HttpRead()
+	{
+		char * separator;
+		uint32_t start = strtoul( _line + 12, &separator, 10 );
+		uint32_t size = strtoul( separator + 1, NULL, 10 );
+
+		if ( start > _bodySize )
+			start = _bodySize;
+		if ( size > _bodySize - start )
+			size = _bodySize - start;
+		if ( size > sizeof( _reply ) - 32 )
+			size = sizeof( _reply ) - 32;
+
+		_replyLength = snprintf( _reply, sizeof( _reply ), "\r\n+HTTPREAD:%u\r\n", size );
+		for ( uint32_t i = 0; i < size; i++ )
+			_reply[_replyLength++] = 'a' + ( start + i ) % 26;
+		_replyLength += snprintf( _reply + _replyLength, sizeof( _reply ) - _replyLength, "\r\nOK\r\n" );
+	}
+
+	uint32_t _bodySize;
+	char _line[128];
+	uint8_t _lineLength;
+	char _reply[1100];
+	int _replyLength;
+	int _position;
+};
+
+
+/** \brief Print that only counts
+ */
+class NullPrint : public Print
+{
+public:
+	NullPrint() :
+		bytes( 0 )
+	{}
+
+	size_t write( uint8_t /* c */ )
+	{
+		bytes++;
+		return 1;
+	}
+
+	size_t write(	const uint8_t * /* buffer */,
+					size_t size )
+	{
+		bytes += size;
+		return size;
+	}
+
+	uint32_t bytes;
+};
+
+
+static bool CountBody(	const char * /* chunk */,
+						uint16_t length,
+						void * context )
+{
+	*(uint32_t *) context += length;
+	return true;
+}
+
+
+int main()
+{
+	FixedModem modem( 1000 );
+	Connection sim( "1234", "internet", "", "", 2, (HardwareSerial &) modem, 115200 );
+	char body[64];
+	uint16_t bodyLength;
+	uint16_t httpReply;
+	NullPrint print;
+	uint32_t received = 0;
+	char * allocated;
+
+	sim.SetReadWindow( 1024 );
+	CHECK( sim.Configuration() );
+
+	allocations = 0;
+	CHECK( sim.Get( "www.example.com", "api", "file", httpReply, body, sizeof( body ), bodyLength ) );
+	CHECK( bodyLength == 1000 && strlen( body ) == sizeof( body ) - 1 );
+	CHECK( allocations == 0 );
+	printf( "AllocationTest: buffer %lu", allocations );
+
+	allocations = 0;
+	CHECK( sim.Get( "www.example.com", "api", "file", httpReply, print ) );
+	CHECK( print.bytes == 1000 );
+	CHECK( allocations == 0 );
+	printf( ", Print %lu", allocations );
+
+	allocations = 0;
+	CHECK( sim.Get( "www.example.com", "api", "file", httpReply, CountBody, &received ) );
+	CHECK( received == 1000 );
+	CHECK( allocations == 0 );
+	printf( ", callback %lu", allocations );
+
+	// The counter sees the heap: the allocating Get uses it
+	allocations = 0;
+	CHECK( sim.Get( "www.example.com", "api", "file", httpReply, allocated ) );
+	CHECK( allocated && strlen( allocated ) == 1000 );
+	CHECK( allocations == 1 );
+	printf( ", allocating Get %lu\n", allocations );
+	delete [] allocated;
+
+	// 64 KB and more: the length stops at 0xFFFF
+	FixedModem large( 70000 );
+	Connection largeSim( "1234", "internet", "", "", 2, (HardwareSerial &) large, 115200 );
+
+	largeSim.SetReadWindow( 1024 );
+	CHECK( largeSim.Configuration() );
+	CHECK( largeSim.Get( "www.example.com", "api", "file", httpReply, body, sizeof( body ), bodyLength ) );
+	CHECK( bodyLength == 0xFFFF );
+	CHECK( strlen( body ) == sizeof( body ) - 1 );
+
+	return CheckResult( "AllocationTest" );
+}
@@ -0,0 +1,95 @@
+/** SIM900 Basic communication library for SIM900 gsm module.
+ *
+ *	Asynchronous requests that move more data than their command timeouts allow: a Post
+ *	and a Get of 4 KB at 9600 baud take more than 4 s each. The data steps have their own
+ *	timer, renewed by every chunk, so they finish while bytes are moving.
+ *
+ *	Released under MIT license.
+ *
+ */
+#include "SIM900.h"
+#include "SimModem.h"
+#include "Check.h"
+
+#include <string>
+
+struct ShortTimeoutsPolicy : DefaultConnectionPolicy
+{
+	enum
+	{
+		DOWNLOAD_TIMEOUT = 1000,
+		DATA_TIMEOUT = 500,
+		HTTPREAD_TIMEOUT = 1000,
+		BODY_TIMEOUT = 500
+	};
+};
+
+typedef BasicConnection<ShortTimeoutsPolicy> ShortTimeoutsConnection;
+
+static const size_t BODY_SIZE = 4096;
+
+
+static bool CountBody(	const char * /* chunk */,
+						uint16_t length,
+						void * context )
+{
+	*(size_t *) context += length;
+	return true;
+}
+
+
+/** \brief Polls the request until it finishes
+ *
+ *	@return	the longest Poll call (ms)
+ */
+static unsigned long Run( ShortTimeoutsConnection & sim )
+{
+	unsigned long longest = 0;
+
+	while ( true )
+	{
+		unsigned long start = SimModem::Millis();
+		ConnectionBase::RequestStatus status = sim.Poll();
+
+		if ( SimModem::Millis() - start > longest )
+			longest = SimModem::Millis() - start;
+
+		if ( status != ConnectionBase::REQUEST_RUNNING )
+			return longest;
+
+		SimModem::Idle();
+	}
+}
+
+
+int main()
+{
+	SimModem modem;
+	ShortTimeoutsConnection sim( "1234", "internet", "", "", 2, (HardwareSerial &) modem, 9600 );
+	std::string data( BODY_SIZE, 'p' );
+	size_t received = 0;
+
+	modem.Attach( sim );
+	modem.SetGetReply( 200, std::string( BODY_SIZE, 'g' ) );
+	CHECK( sim.Configuration() );
+
+	unsigned long start = SimModem::Millis();
+
+	CHECK( sim.StartPost( "www.example.com", "api", "events", data.c_str() ) );
+	CHECK( Run( sim ) < ShortTimeoutsPolicy::DATA_TIMEOUT );
+	CHECK( sim.GetRequestStatus() == ConnectionBase::REQUEST_DONE );
+	CHECK( modem.GetPostData() == data );
+	CHECK( SimModem::Millis() - start > ShortTimeoutsPolicy::DOWNLOAD_TIMEOUT );
+
+	// The whole body in one window of HTTPREAD
+	sim.SetReadWindow( BODY_SIZE );
+	start = SimModem::Millis();
+
+	CHECK( sim.StartGet( "www.example.com", "api", "file", CountBody, NULL, &received ) );
+	CHECK( Run( sim ) < ShortTimeoutsPolicy::BODY_TIMEOUT );
+	CHECK( sim.GetRequestStatus() == ConnectionBase::REQUEST_DONE );
+	CHECK( received == BODY_SIZE );
+	CHECK( SimModem::Millis() - start > ShortTimeoutsPolicy::HTTPREAD_TIMEOUT );
+
+	return CheckResult( "AsyncTest" );
+}
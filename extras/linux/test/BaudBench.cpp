@@ -0,0 +1,77 @@
+/** SIM900 Basic communication library for SIM900 gsm module.
+ *
+ *	Time of NegotiateBaudRate() and throughput of a Get of 8 KB after it, for every limit
+ *	of the rate, against the simulated module. The module is at 9600 baud and the host
+ *	starts at 115200, so the rate is probed first. The Get is read in windows of 512
+ *	bytes with a fast server, so the time of the Get is mostly the one of the serial port.
+ *
+ *	Released under MIT license.
+ *
+ */
+#include "SIM900.h"
+#include "SimModem.h"
+
+#include <stdio.h>
+#include <string>
+
+static const uint32_t BODY_SIZE = 8192;
+static const uint32_t MODULE_BAUD_RATE = 9600;
+static const SimModem::Latency LATENCY = { 20, 50, 50, 300 };
+
+
+static bool CountBody(	const char * /* chunk */,
+						uint16_t length,
+						void * context )
+{
+	*(uint32_t *) context += length;
+	return true;
+}
+
+
+/** \brief Negotiates a rate up to maxBaudRate and makes a Get
+ *
+ *	@return	false if the rate isn't maxBaudRate or the body isn't complete
+ */
+static bool Measure( const uint32_t & maxBaudRate )
+{
+	SimModem modem;
+	Connection sim( "1234", "internet", "", "", 2, (HardwareSerial &) modem, 115200 );
+	uint32_t received = 0;
+	uint16_t httpReply;
+
+	modem.Attach( sim );
+	modem.SetLatency( LATENCY );
+	modem.SetBaudRate( MODULE_BAUD_RATE );
+	modem.SetGetReply( 200, std::string( BODY_SIZE, 'x' ) );
+
+	uint64_t start = SimModem::Micros();
+	uint32_t baudRate = sim.NegotiateBaudRate( maxBaudRate );
+	double negotiation = ( SimModem::Micros() - start ) / 1000.0;
+
+	sim.Configuration();
+	sim.SetReadWindow( 512 );
+
+	start = SimModem::Micros();
+	sim.Get( "www.example.com", "api", "file", httpReply, CountBody, &received );
+
+	double seconds = ( SimModem::Micros() - start ) / 1e6;
+
+	printf( "up to %6u baud: %6u baud in %7.1f ms, Get %8.0f bytes/s, line %6u bytes/s\n", maxBaudRate,
+			baudRate, negotiation, received / seconds, baudRate / 10 );
+
+	return baudRate == maxBaudRate && received == BODY_SIZE;
+}
+
+
+int main()
+{
+	const uint32_t rates[] = { 9600, 19200, 38400, 57600, 115200 };
+	bool ok = true;
+
+	printf( "BaudBench: module at %u baud, Get of %u B\n", MODULE_BAUD_RATE, BODY_SIZE );
+
+	for ( uint8_t i = 0; i < sizeof( rates ) / sizeof( rates[0] ); i++ )
+		ok &= Measure( rates[i] );
+
+	return ok ? 0 : 1;
+}
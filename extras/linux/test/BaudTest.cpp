@@ -0,0 +1,48 @@
+/** SIM900 Basic communication library for SIM900 gsm module.
+ *
+ *	NegotiateBaudRate() against the simulated module at 9600 baud, with a host that can't
+ *	set the two fastest rates: they are skipped without AT+IPR and the next one is kept.
+ *	Without the check the fastest rate is used.
+ *
+ *	Released under MIT license.
+ *
+ */
+#include "SIM900.h"
+#include "SimModem.h"
+#include "Check.h"
+
+static const uint32_t HOST_MAX_BAUD_RATE = 38400;
+
+
+static bool HostBaudRate(	uint32_t baudRate,
+							void * context )
+{
+	( *(uint16_t *) context )++;
+	return baudRate <= HOST_MAX_BAUD_RATE;
+}
+
+
+int main()
+{
+	SimModem modem;
+	Connection sim( "1234", "internet", "", "", 2, (HardwareSerial &) modem, 9600 );
+	uint16_t checks = 0;
+
+	modem.Attach( sim );
+	modem.SetBaudRate( 9600 );
+	sim.SetBaudRateCheck( HostBaudRate, &checks );
+
+	CHECK( sim.NegotiateBaudRate( 115200 ) == HOST_MAX_BAUD_RATE );
+	CHECK( checks >= 3 );
+	CHECK( modem.Commands( "AT+IPR=115200" ) == 0 );
+	CHECK( modem.Commands( "AT+IPR=57600" ) == 0 );
+	CHECK( modem.Commands( "AT+IPR=38400" ) == 1 );
+	CHECK( sim.Configuration() );
+
+	// Every rate allowed again
+	sim.SetBaudRateCheck( NULL );
+	CHECK( sim.NegotiateBaudRate( 115200 ) == 115200 );
+	CHECK( sim.Configuration() );
+
+	return CheckResult( "BaudTest" );
+}
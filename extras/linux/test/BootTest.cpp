@@ -0,0 +1,107 @@
+/** SIM900 Basic communication library for SIM900 gsm module.
+ *
+ *	PowerOn() against the simulated module, wired to the power pin:
+ *		- at a fixed rate the module sends +CPIN: READY and Call Ready when it boots
+ *		- with autobaud it is silent and answers the AT probes once it booted
+ *		- a SIM that asks for its PIN is ready, Configuration() enters the PIN
+ *		- a module that never answers: PowerOn() fails after BOOT_TIMEOUT
+ *	GetBootTime() is the power pulse plus the boot time of the module.
+ *
+ *	Released under MIT license.
+ *
+ */
+#include "SIM900.h"
+#include "SimModem.h"
+#include "Check.h"
+
+#include <stdio.h>
+
+static const uint8_t ENABLE_PIN = 2;
+static const uint32_t BOOT_TIME = 3000;
+
+static SimModem * wiredModem = NULL;
+
+
+/** \brief The enable pin of the Arduino is wired to the power key of the module
+ */
+static void WritePin(	uint8_t pin,
+						uint8_t value )
+{
+	if ( pin == ENABLE_PIN && wiredModem )
+		wiredModem->SetPowerKey( value == HIGH );
+}
+
+
+/** \brief Turns on a module that is off
+ *
+ *	@param	IN	rate of the module, 0 for autobaud
+ *	@param	IN	state of the SIM
+ *	@param	IN	false if the power key isn't wired: the module never answers
+ *	@param	OUT	boot time of the connection
+ *
+ *	@return	PowerOn() result
+ */
+static bool Boot(	const uint32_t & baudRate,
+					const char * simState,
+					const bool & wired,
+					uint32_t & bootTime )
+{
+	SimModem modem;
+	Connection sim( "1234", "internet", "", "", ENABLE_PIN, (HardwareSerial &) modem, 115200 );
+
+	modem.Attach( sim );
+	modem.SetPowered( false );
+	modem.SetBaudRate( baudRate );
+	modem.SetBootTime( BOOT_TIME );
+	modem.SetSimState( simState );
+	wiredModem = wired ? &modem : NULL;
+
+	bool ready = sim.PowerOn();
+
+	bootTime = sim.GetBootTime();
+
+	// The SIM is unlocked and the bearer opened after the boot
+	if ( ready )
+	{
+		CHECK( sim.Configuration() );
+		CHECK( modem.Commands( "AT+CPIN=\"1234\"" ) == ( simState[0] == 'S' ? 1u : 0u ) );
+	}
+
+	wiredModem = NULL;
+	return ready;
+}
+
+
+int main()
+{
+	const uint32_t pulse = DefaultConnectionPolicy::POWER_PULSE_TIME;
+	uint32_t bootTime;
+
+	pinWriter = WritePin;
+
+	// Fixed rate: ready when +CPIN arrives
+	CHECK( Boot( 115200, "READY", true, bootTime ) );
+	CHECK( bootTime >= pulse + BOOT_TIME && bootTime < pulse + BOOT_TIME + 20 );
+	printf( "BootTest: fixed rate %u ms", bootTime );
+
+	// Autobaud: ready at the first AT probe after the boot
+	CHECK( Boot( 0, "READY", true, bootTime ) );
+	CHECK( bootTime >= pulse + BOOT_TIME );
+	CHECK( bootTime < pulse + BOOT_TIME + DefaultConnectionPolicy::BOOT_PROBE_INTERVAL + 50 );
+	printf( ", autobaud %u ms", bootTime );
+
+	// The SIM asks for its PIN
+	CHECK( Boot( 115200, "SIM PIN", true, bootTime ) );
+	CHECK( bootTime >= pulse + BOOT_TIME && bootTime < pulse + BOOT_TIME + 20 );
+	printf( ", SIM PIN %u ms", bootTime );
+
+	// The module never answers
+	unsigned long start = SimModem::Millis();
+
+	CHECK( !Boot( 115200, "READY", false, bootTime ) );
+	CHECK( bootTime == 0 );
+	CHECK( SimModem::Millis() - start >= pulse + DefaultConnectionPolicy::BOOT_TIMEOUT );
+	printf( ", no answer after %lu ms\n", SimModem::Millis() - start );
+
+	return CheckResult( "BootTest" );
+}
@@ -0,0 +1,172 @@
+/** SIM900 Basic communication library for SIM900 gsm module.
+ *
+ *	Response cache against the simulated module:
+ *		- a reply with ETag is saved, the next Get sends If-None-Match with the quotes
+ *		  of the ETag escaped and a 304 is served from the cache as a 200, in chunks
+ *		- the same with Last-Modified and If-Modified-Since
+ *		- the oldest entry is dropped when the cache is full
+ *		- a body cut by a failed read isn't saved
+ *
+ *	Released under MIT license.
+ *
+ */
+#include "SIM900.h"
+#include "SIM900Cache.h"
+#include "SimModem.h"
+#include "Check.h"
+
+#include <stdio.h>
+#include <string>
+
+static const char ETAG[] = "\"5d8c72a5\"";
+static const char DATE[] = "Wed, 21 Oct 2015 07:28:00 GMT";
+
+
+/** \brief Body of a Get and the chunks it came in
+ */
+struct Sink
+{
+	std::string body;
+	uint16_t chunks;
+	uint16_t largestChunk;
+};
+
+
+static bool Collect(	const char * chunk,
+						uint16_t length,
+						void * context )
+{
+	Sink * sink = (Sink *) context;
+
+	sink->body.append( chunk, length );
+	sink->chunks++;
+	if ( length > sink->largestChunk )
+		sink->largestChunk = length;
+
+	return true;
+}
+
+
+/** \brief Get of a url into a sink
+ *
+ *	@return	http reply, 0 if the Get fails
+ */
+static uint16_t Get(	Connection & sim,
+						const char * url,
+						Sink & sink )
+{
+	uint16_t httpReply;
+
+	sink.body.clear();
+	sink.chunks = 0;
+	sink.largestChunk = 0;
+
+	if ( !sim.Get( "www.example.com", "api", url, httpReply, Collect, &sink ) )
+		return 0;
+
+	return httpReply;
+}
+
+
+static std::string Body(	const char fill,
+							const size_t & size )
+{
+	std::string body;
+
+	for ( size_t i = 0; i < size; i++ )
+		body += (char) ( fill + i % 10 );
+
+	return body;
+}
+
+
+int main()
+{
+	SimModem modem;
+	Connection sim( "1234", "internet", "", "", 2, (HardwareSerial &) modem, 115200 );
+	ResponseCache<256> cache;
+	std::string body = Body( 'a', 100 );
+	Sink sink;
+
+	modem.Attach( sim );
+	sim.SetResponseCache( &cache );
+	CHECK( sim.Configuration() );
+
+	// ETag: the first Get saves the body, the second one is revalidated
+	modem.SetGetReply( 200, body, std::string( "HTTP/1.1 200 OK\r\nETag: " ) + ETAG + "\r\n" );
+	CHECK( Get( sim, "etag", sink ) == 200 );
+	CHECK( sink.body == body );
+	CHECK( !sim.IsCachedReply() );
+	CHECK( cache.Find( ResponseCacheBase::Key( "www.example.com", "api", "etag" ) ) );
+
+	modem.SetGetReply( 304, "" );
+	CHECK( Get( sim, "etag", sink ) == 200 );
+	CHECK( modem.GetUserData() == std::string( "If-None-Match: " ) + ETAG );
+	CHECK( sim.IsCachedReply() );
+	CHECK( sink.body == body );
+	CHECK( sink.largestChunk == DefaultConnectionPolicy::BODY_CHUNK_SIZE );
+	CHECK( sink.chunks == ( body.size() + DefaultConnectionPolicy::BODY_CHUNK_SIZE - 1 ) / DefaultConnectionPolicy::BODY_CHUNK_SIZE );
+	CHECK( cache.GetHits() == 1 );
+
+	// Last-Modified
+	std::string dated = Body( 'A', 40 );
+
+	modem.SetGetReply( 200, dated, std::string( "HTTP/1.1 200 OK\r\nLast-Modified: " ) + DATE + "\r\n" );
+	CHECK( Get( sim, "date", sink ) == 200 );
+	CHECK( !sim.IsCachedReply() );
+
+	modem.SetGetReply( 304, "" );
+	CHECK( Get( sim, "date", sink ) == 200 );
+	CHECK( modem.GetUserData() == std::string( "If-Modified-Since: " ) + DATE );
+	CHECK( sim.IsCachedReply() );
+	CHECK( sink.body == dated );
+	CHECK( cache.GetHits() == 2 );
+
+	// A changed body replaces the saved one
+	std::string changed = Body( '0', 100 );
+
+	modem.SetGetReply( 200, changed, "ETag: \"6e9d83b6\"\r\n" );
+	CHECK( Get( sim, "etag", sink ) == 200 );
+	CHECK( !sim.IsCachedReply() );
+	CHECK( sink.body == changed );
+
+	modem.SetGetReply( 304, "" );
+	CHECK( Get( sim, "etag", sink ) == 200 );
+	CHECK( modem.GetUserData() == "If-None-Match: \"6e9d83b6\"" );
+	CHECK( sink.body == changed );
+
+	// Eviction: room for two entries of 32 bytes, the third drops the oldest
+	ResponseCache<100> small;
+	const char * urls[] = { "first", "second", "third" };
+
+	sim.SetResponseCache( &small );
+	for ( uint8_t i = 0; i < 3; i++ )
+	{
+		modem.SetGetReply( 200, Body( 'a', 32 ), "ETag: \"a1\"\r\n" );
+		CHECK( Get( sim, urls[i], sink ) == 200 );
+	}
+
+	CHECK( !small.Find( ResponseCacheBase::Key( "www.example.com", "api", "first" ) ) );
+	CHECK( small.Find( ResponseCacheBase::Key( "www.example.com", "api", "second" ) ) );
+	CHECK( small.Find( ResponseCacheBase::Key( "www.example.com", "api", "third" ) ) );
+
+	modem.SetGetReply( 304, "" );
+	CHECK( Get( sim, "third", sink ) == 200 );
+	CHECK( sim.IsCachedReply() );
+
+	// Truncated body: the second window fails, nothing is saved and the old entry is gone
+	sim.SetResponseCache( &cache );
+	sim.SetReadWindow( 32 );
+	modem.SetGetReply( 200, Body( 'x', 100 ), "ETag: \"7fae94c7\"\r\n" );
+	modem.Fail( "AT+HTTPREAD=32,", "ERROR" );
+	CHECK( Get( sim, "etag", sink ) == 0 );
+	CHECK( sink.body.size() < 100 );
+	CHECK( !cache.Find( ResponseCacheBase::Key( "www.example.com", "api", "etag" ) ) );
+
+	modem.SetGetReply( 200, Body( 'x', 100 ), "ETag: \"7fae94c7\"\r\n" );
+	CHECK( Get( sim, "etag", sink ) == 200 );
+	CHECK( !sim.IsCachedReply() );
+	CHECK( sink.body == Body( 'x', 100 ) );
+
+	return CheckResult( "CacheTest" );
+}
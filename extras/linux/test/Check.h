@@ -0,0 +1,34 @@
+/** SIM900 Basic communication library for SIM900 gsm module.
+ *
+ *	Checks of the host tests: a failed one is printed and the test returns 1.
+ *
+ *	Released under MIT license.
+ *
+ */
+#pragma once
+#ifndef __Check_h__
+#define __Check_h__
+
+#include <stdio.h>
+
+static int checkFailures = 0;
+
+#define CHECK( condition ) \
+	do \
+	{ \
+		if ( !( condition ) ) \
+		{ \
+			printf( "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition ); \
+			checkFailures++; \
+		} \
+	} while ( 0 )
+
+/** \brief Result of the test for main()
+ */
+inline int CheckResult( const char * test )
+{
+	printf( "%s: %s\n", test, checkFailures ? "FAILED" : "ok" );
+	return checkFailures ? 1 : 0;
+}
+
+#endif
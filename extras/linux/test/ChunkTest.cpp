@@ -0,0 +1,97 @@
+/** SIM900 Basic communication library for SIM900 gsm module.
+ *
+ *	A BODY_CHUNK_SIZE over 255: the blocking and asynchronous Gets and the data of a
+ *	socket arrive whole, in chunks of that size.
+ *
+ *	Released under MIT license.
+ *
+ */
+#include "SIM900.h"
+#include "SimModem.h"
+#include "Check.h"
+
+#include <string>
+
+struct LargeChunkPolicy : DefaultConnectionPolicy
+{
+	enum { BODY_CHUNK_SIZE = 300 };
+};
+
+typedef BasicConnection<LargeChunkPolicy> LargeChunkConnection;
+
+
+struct Received
+{
+	std::string data;
+	uint16_t largestChunk;
+};
+
+
+static bool AddChunk(	const char * chunk,
+						uint16_t length,
+						void * context )
+{
+	Received & received = *(Received *) context;
+
+	received.data.append( chunk, length );
+	if ( length > received.largestChunk )
+		received.largestChunk = length;
+	return true;
+}
+
+
+static void AddSocketChunk(	uint8_t /* link */,
+							const char * chunk,
+							uint16_t length,
+							void * context )
+{
+	AddChunk( chunk, length, context );
+}
+
+
+int main()
+{
+	SimModem modem;
+	LargeChunkConnection sim( "1234", "internet", "", "", 2, (HardwareSerial &) modem, 115200 );
+	std::string body;
+	uint16_t httpReply;
+
+	for ( uint16_t i = 0; i < 1000; i++ )
+		body += (char) ( 'a' + i % 26 );
+
+	modem.Attach( sim );
+	modem.SetGetReply( 200, body );
+	sim.SetReadWindow( 1000 );
+	CHECK( sim.Configuration() );
+
+	Received blocking = { "", 0 };
+
+	CHECK( sim.Get( "www.example.com", "api", "file", httpReply, AddChunk, &blocking ) );
+	CHECK( blocking.data == body );
+	CHECK( blocking.largestChunk == LargeChunkPolicy::BODY_CHUNK_SIZE );
+
+	Received async = { "", 0 };
+
+	CHECK( sim.StartGet( "www.example.com", "api", "file", AddChunk, NULL, &async ) );
+	while ( sim.Poll() == ConnectionBase::REQUEST_RUNNING )
+		SimModem::Idle();
+
+	CHECK( sim.GetRequestStatus() == ConnectionBase::REQUEST_DONE );
+	CHECK( async.data == body );
+	CHECK( async.largestChunk == LargeChunkPolicy::BODY_CHUNK_SIZE );
+
+	Received socket = { "", 0 };
+	int8_t link;
+
+	sim.SetSocketCallback( AddSocketChunk, &socket );
+	link = sim.SocketOpen( ConnectionBase::SOCKET_TCP, "www.example.com", 80 );
+	CHECK( link == 0 );
+
+	modem.SendRaw( "\r\n+RECEIVE,0,1000:\r\n" + body + "\r\n" );
+	SimModem::Delay( 200 );
+	sim.ProcessUrcs();
+	CHECK( socket.data == body );
+	CHECK( socket.largestChunk == LargeChunkPolicy::BODY_CHUNK_SIZE );
+
+	return CheckResult( "ChunkTest" );
+}
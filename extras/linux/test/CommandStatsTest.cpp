@@ -0,0 +1,61 @@
+/** SIM900 Basic communication library for SIM900 gsm module.
+ *
+ *	Statistics per class of command: the bytes of the data of a Post go to HTTPDATA and
+ *	the command line after them to its own class.
+ *
+ *	Released under MIT license.
+ *
+ */
+#include "SIM900.h"
+#include "SimModem.h"
+#include "Check.h"
+
+#include <string>
+
+struct StatsPolicy : DefaultConnectionPolicy
+{
+	enum { COMMAND_STATS = 1 };
+};
+
+typedef BasicConnection<StatsPolicy> StatsConnection;
+
+static const char DATA[] = "{\"temperature\":21}";
+static const char HTTPDATA_LINE[] = "AT+HTTPDATA=18,20000\r\n";
+
+
+static void CheckPost(	StatsConnection & sim,
+						const uint16_t & posts )
+{
+	const ConnectionBase::CommandStats & data = sim.GetCommandStats( ConnectionBase::COMMAND_HTTP_DATA );
+	const ConnectionBase::CommandStats & para = sim.GetCommandStats( ConnectionBase::COMMAND_HTTP_PARA );
+
+	// AT+HTTPPARA="CID",1 and AT+HTTPPARA="URL",... every Post
+	CHECK( data.calls == posts );
+	CHECK( data.bytesOut == posts * ( strlen( HTTPDATA_LINE ) + strlen( DATA ) ) );
+	CHECK( para.calls == 2 * posts );
+}
+
+
+int main()
+{
+	SimModem modem;
+	StatsConnection sim( "1234", "internet", "", "", 2, (HardwareSerial &) modem, 115200 );
+	uint16_t httpReply;
+
+	modem.Attach( sim );
+	CHECK( sim.Configuration() );
+
+	sim.ResetCommandStats();
+	CHECK( sim.Post( "www.example.com", "api", "events", DATA, httpReply ) );
+	CheckPost( sim, 1 );
+
+	// The same with the asynchronous Post
+	CHECK( sim.StartPost( "www.example.com", "api", "events", DATA ) );
+	while ( sim.Poll() == ConnectionBase::REQUEST_RUNNING )
+		SimModem::Idle();
+
+	CHECK( sim.GetRequestStatus() == ConnectionBase::REQUEST_DONE );
+	CheckPost( sim, 2 );
+
+	return CheckResult( "CommandStatsTest" );
+}
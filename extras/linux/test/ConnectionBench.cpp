@@ -0,0 +1,109 @@
+/** SIM900 Basic communication library for SIM900 gsm module.
+ *
+ *	Latency and throughput of Configuration, Get and Post against the simulated module
+ *	at 115200 baud. The times of the module are set in SimModem::Latency; the ms are of
+ *	the virtual clock, the CPU time is what the library spends on the host.
+ *
+ *	Released under MIT license.
+ *
+ */
+#include "SIM900.h"
+#include "SimModem.h"
+
+#include <stdio.h>
+#include <time.h>
+#include <string>
+
+static const uint16_t ROUNDS = 20;
+static const SimModem::Latency LATENCY = { 20, 500, 50, 300 };
+
+
+static double CpuMicros()
+{
+	struct timespec now;
+
+	clock_gettime( CLOCK_PROCESS_CPUTIME_ID, &now );
+	return now.tv_sec * 1e6 + now.tv_nsec / 1e3;
+}
+
+
+static void Report(	const char * operation,
+					const uint32_t & bytes,
+					const uint64_t & micros,
+					const double & cpuMicros,
+					const uint32_t & commands )
+{
+	double ms = micros / 1000.0 / ROUNDS;
+
+	printf( "%-22s %8.1f ms %9.0f B/s %8.1f us cpu %6.1f commands\n", operation, ms,
+			bytes ? bytes * 1000.0 / ms : 0.0, cpuMicros / ROUNDS, (double) commands / ROUNDS );
+}
+
+
+int main()
+{
+	SimModem modem;
+	Connection sim( "1234", "internet", "", "", 2, (HardwareSerial &) modem, 115200 );
+	uint16_t httpReply;
+	static char body[8192];
+	uint16_t bodyLength;
+	const uint16_t sizes[] = { 100, 1024, 4096 };
+
+	modem.Attach( sim );
+	modem.SetLatency( LATENCY );
+	printf( "ConnectionBench: %u rounds, module latency command %u ms, action %u ms\n", ROUNDS, LATENCY.command, LATENCY.action );
+
+	uint64_t start = SimModem::Micros();
+	double cpu = CpuMicros();
+
+	// A module just powered on every round
+	uint32_t commands = 0;
+
+	for ( uint16_t i = 0; i < ROUNDS; i++ )
+	{
+		SimModem booted;
+		Connection configured( "1234", "internet", "", "", 2, (HardwareSerial &) booted, 115200 );
+
+		booted.Attach( configured );
+		booted.SetLatency( LATENCY );
+		configured.Configuration();
+		commands += booted.Commands();
+	}
+	Report( "Configuration", 0, SimModem::Micros() - start, CpuMicros() - cpu, commands );
+
+	sim.Configuration();
+
+	for ( uint8_t s = 0; s < sizeof( sizes ) / sizeof( sizes[0] ); s++ )
+	{
+		char name[32];
+
+		modem.SetGetReply( 200, std::string( sizes[s], 'x' ) );
+		modem.ClearTranscript();
+		start = SimModem::Micros();
+		cpu = CpuMicros();
+
+		for ( uint16_t i = 0; i < ROUNDS; i++ )
+			sim.Get( "www.example.com", "api", "file", httpReply, body, sizeof( body ), bodyLength );
+
+		snprintf( name, sizeof( name ), "Get %u B", sizes[s] );
+		Report( name, sizes[s], SimModem::Micros() - start, CpuMicros() - cpu, modem.Commands() );
+	}
+
+	for ( uint8_t s = 0; s < sizeof( sizes ) / sizeof( sizes[0] ); s++ )
+	{
+		std::string data( sizes[s], 'y' );
+		char name[32];
+
+		modem.ClearTranscript();
+		start = SimModem::Micros();
+		cpu = CpuMicros();
+
+		for ( uint16_t i = 0; i < ROUNDS; i++ )
+			sim.Post( "www.example.com", "api", "events", data.c_str(), httpReply );
+
+		snprintf( name, sizeof( name ), "Post %u B", sizes[s] );
+		Report( name, sizes[s], SimModem::Micros() - start, CpuMicros() - cpu, modem.Commands() );
+	}
+
+	return 0;
+}
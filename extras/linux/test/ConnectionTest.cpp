@@ -0,0 +1,95 @@
+/** SIM900 Basic communication library for SIM900 gsm module.
+ *
+ *	Configuration, Get and Post against the simulated module.
+ *
+ *	Released under MIT license.
+ *
+ */
+#include "SIM900.h"
+#include "SimModem.h"
+#include "Check.h"
+
+#include <string>
+
+
+/** \brief Access to the AT commands of the connection
+ */
+struct CommandConnection : Connection
+{
+	using Connection::Connection;
+	using Connection::SendATcommand;
+};
+
+
+int main()
+{
+	SimModem modem;
+	CommandConnection sim( "1234", "internet", "", "", 2, (HardwareSerial &) modem, 115200 );
+	uint16_t httpReply;
+	char body[64];
+	uint16_t bodyLength;
+
+	modem.Attach( sim );
+
+	CHECK( sim.Configuration() );
+	CHECK( std::string( sim.GetIpAddress() ) == "10.0.0.2" );
+
+	// Get into a buffer, the body is cut to the buffer
+	modem.SetGetReply( 200, "{\"hour\":10,\"minutes\":21}" );
+	CHECK( sim.Get( "www.example.com", "api", "time", httpReply, body, sizeof( body ), bodyLength ) );
+	CHECK( httpReply == 200 );
+	CHECK( std::string( body ) == "{\"hour\":10,\"minutes\":21}" );
+
+	modem.SetGetReply( 200, std::string( 100, 'x' ) );
+	CHECK( sim.Get( "www.example.com", "api", "time", httpReply, body, sizeof( body ), bodyLength ) );
+	CHECK( bodyLength == 100 );
+	CHECK( std::string( body ) == std::string( sizeof( body ) - 1, 'x' ) );
+
+	modem.SetGetReply( 404, "" );
+	CHECK( sim.Get( "www.example.com", "api", "time", httpReply, body, sizeof( body ), bodyLength ) );
+	CHECK( httpReply == 404 );
+	CHECK( bodyLength == 0 );
+
+	// Get that allocates the body: bounded by BODY_ALLOCATION_MAX, false if it isn't read whole
+	char * reply = NULL;
+
+	modem.SetGetReply( 200, "{\"hour\":10,\"minutes\":21}" );
+	CHECK( sim.Get( "www.example.com", "api", "time", httpReply, reply ) );
+	CHECK( reply && std::string( reply ) == "{\"hour\":10,\"minutes\":21}" );
+	delete[] reply;
+
+	modem.SetGetReply( 200, std::string( DefaultConnectionPolicy::BODY_ALLOCATION_MAX + 1, 'x' ) );
+	CHECK( !sim.Get( "www.example.com", "api", "time", httpReply, reply ) );
+	CHECK( reply == NULL );
+
+	modem.SetGetReply( 200, std::string( 100, 'x' ) );
+	modem.Fail( "AT+HTTPREAD", NULL );
+	CHECK( !sim.Get( "www.example.com", "api", "time", httpReply, reply ) );
+	delete[] reply;
+
+	// Post
+	modem.SetPostReply( 201 );
+	CHECK( sim.Post( "www.example.com", "api", "events", "{\"temperature\":21}", httpReply ) );
+	CHECK( httpReply == 201 );
+	CHECK( modem.GetPostData() == "{\"temperature\":21}" );
+
+	// Every request closes the HTTP service
+	CHECK( modem.Commands( "AT+HTTPINIT" ) == modem.Commands( "AT+HTTPTERM" ) );
+
+	// A module that doesn't answer fails the request instead of blocking it
+	modem.Fail( "AT+HTTPACTION", NULL );
+	CHECK( !sim.Post( "www.example.com", "api", "events", "{}", httpReply ) );
+
+	// More than MAX_ANSWERS expected answers fail instead of dropping the last ones
+	const char * answers[] = { "1", "2", "3", "4", "5", "OK" };
+
+	CHECK( sim.SendATcommand( "AT", answers, 5, 100 ) == 0 );
+	CHECK( sim.SendATcommand( "AT", answers + 1, 5, 100 ) == 5 );
+
+	unsigned long start = SimModem::Millis();
+
+	CHECK( sim.SendATcommand( "AT", answers, 6, 100 ) == 0 );
+	CHECK( SimModem::Millis() - start < 100 );
+
+	return CheckResult( "ConnectionTest" );
+}
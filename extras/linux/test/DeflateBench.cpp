@@ -0,0 +1,374 @@
+/** SIM900 Basic communication library for SIM900 gsm module.
+ *
+ *	Compression of Post bodies with Deflate: bytes saved and CPU time per KB of the host
+ *	for several windows, over telemetry payloads, and the time of Post and PostCompressed
+ *	against the simulated module at 9600 baud with the default window. Every output is
+ *	inflated back and must equal the payload: the inflater here only knows the stored and
+ *	fixed Huffman blocks, the ones Deflate writes.
+ *
+ *	Released under MIT license.
+ *
+ */
+#include "SIM900.h"
+#include "SIM900Deflate.h"
+#include "SimModem.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <string>
+#include <vector>
+
+static const uint16_t ROUNDS = 50;
+static const SimModem::Latency LATENCY = { 20, 500, 50, 300 };
+
+
+struct Payload
+{
+	const char * name;
+	std::string data;
+};
+
+
+static double CpuMicros()
+{
+	struct timespec now;
+
+	clock_gettime( CLOCK_PROCESS_CPUTIME_ID, &now );
+	return now.tv_sec * 1e6 + now.tv_nsec / 1e3;
+}
+
+
+/** \brief Bits of a zlib stream, the least significant bit of every byte first
+ */
+class BitReader
+{
+public:
+	BitReader( const std::string & data ) :
+		_data( data ),
+		_position( 0 ),
+		_bit( 0 ),
+		_overrun( false )
+	{}
+
+	uint32_t Bits( const uint8_t & count )
+	{
+		uint32_t bits = 0;
+
+		for ( uint8_t i = 0; i < count; i++ )
+			bits |= Bit() << i;
+
+		return bits;
+	}
+
+	/** \brief Huffman code of a number of bits, the most significant bit first
+	 */
+	uint32_t Code(	uint32_t code,
+					const uint8_t & count )
+	{
+		for ( uint8_t i = 0; i < count; i++ )
+			code = code << 1 | Bit();
+
+		return code;
+	}
+
+	uint8_t Byte()
+	{
+		_bit = 0;
+		if ( _position >= _data.size() )
+		{
+			_overrun = true;
+			return 0;
+		}
+
+		return _data[_position++];
+	}
+
+	void AlignToByte()
+	{
+		if ( _bit )
+		{
+			_bit = 0;
+			_position++;
+		}
+	}
+
+	bool Overrun() const
+	{
+		return _overrun;
+	}
+
+private:
+	uint32_t Bit()
+	{
+		if ( _position >= _data.size() )
+		{
+			_overrun = true;
+			return 0;
+		}
+
+		uint32_t bit = ( (uint8_t) _data[_position] >> _bit ) & 1;
+
+		if ( ++_bit == 8 )
+		{
+			_bit = 0;
+			_position++;
+		}
+
+		return bit;
+	}
+
+	const std::string & _data;
+	size_t _position;
+	uint8_t _bit;
+	bool _overrun;
+};
+
+
+/** \brief Literal/length symbol of the fixed Huffman codes
+ */
+static uint16_t FixedSymbol( BitReader & reader )
+{
+	uint32_t code = reader.Code( 0, 7 );
+
+	if ( code <= 0x17 )
+		return 256 + code;
+
+	code = reader.Code( code, 1 );
+	if ( code >= 0x30 && code <= 0xBF )
+		return code - 0x30;
+	if ( code >= 0xC0 && code <= 0xC7 )
+		return 280 + code - 0xC0;
+
+	return 144 + reader.Code( code, 1 ) - 0x190;
+}
+
+
+/** \brief Inflates a zlib stream of stored and fixed Huffman blocks
+ *
+ *	@param	IN	compressed stream
+ *	@param	OUT	inflated data
+ *
+ *	@return	false if the stream is invalid, uses other blocks or its Adler-32 is wrong
+ */
+static bool Inflate(	const std::string & compressed,
+						std::string & data )
+{
+	static const uint16_t lengthBase[] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+										35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+	static const uint8_t lengthBits[] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+										3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+	static const uint16_t distanceBase[] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+										257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+	BitReader reader( compressed );
+	bool last = false;
+
+	data.clear();
+
+	uint8_t method = reader.Byte();
+	uint8_t flags = reader.Byte();
+
+	if ( ( method & 0x0F ) != 8 || ( method * 256 + flags ) % 31 != 0 || ( flags & 0x20 ) )
+		return false;
+
+	while ( !last && !reader.Overrun() )
+	{
+		last = reader.Bits( 1 );
+
+		uint32_t type = reader.Bits( 2 );
+
+		if ( type == 0 )
+		{
+			reader.AlignToByte();
+
+			uint16_t length = reader.Byte() | reader.Byte() << 8;
+			uint16_t complement = reader.Byte() | reader.Byte() << 8;
+
+			if ( (uint16_t) ~complement != length )
+				return false;
+			for ( uint16_t i = 0; i < length; i++ )
+				data += (char) reader.Byte();
+			continue;
+		}
+
+		if ( type != 1 )
+			return false;
+
+		while ( !reader.Overrun() )
+		{
+			uint16_t symbol = FixedSymbol( reader );
+
+			if ( symbol < 256 )
+			{
+				data += (char) symbol;
+				continue;
+			}
+			if ( symbol == 256 )
+				break;
+			if ( symbol > 285 )
+				return false;
+
+			uint16_t length = lengthBase[symbol - 257] + reader.Bits( lengthBits[symbol - 257] );
+			uint32_t code = reader.Code( 0, 5 );
+
+			if ( code >= 30 )
+				return false;
+
+			uint32_t distance = distanceBase[code] + reader.Bits( code < 4 ? 0 : code / 2 - 1 );
+
+			if ( distance > data.size() )
+				return false;
+			for ( uint16_t i = 0; i < length; i++ )
+				data += data[data.size() - distance];
+		}
+	}
+
+	reader.AlignToByte();
+
+	uint32_t checksum = 0;
+
+	for ( uint8_t i = 0; i < 4; i++ )
+		checksum = checksum << 8 | reader.Byte();
+
+	uint32_t a = 1;
+	uint32_t b = 0;
+
+	for ( size_t i = 0; i < data.size(); i++ )
+	{
+		a = ( a + (uint8_t) data[i] ) % 65521;
+		b = ( b + a ) % 65521;
+	}
+
+	return !reader.Overrun() && checksum == ( b << 16 | a );
+}
+
+
+/** \brief Telemetry of a device: one reading, a batch of readings, a configuration and
+ *		random bytes that don't compress
+ */
+static std::vector<Payload> Payloads()
+{
+	std::vector<Payload> payloads;
+	Payload reading = { "reading", "{\"device\":\"sim900-0042\",\"temperature\":21.5,\"humidity\":48,\"battery\":3.91}" };
+	Payload batch = { "batch of 20", "[" };
+	Payload config = { "configuration", "{" };
+	Payload noise = { "random", "" };
+	char text[160];
+
+	srand( 1 );
+
+	for ( int i = 0; i < 20; i++ )
+	{
+		snprintf( text, sizeof( text ), "%s{\"device\":\"sim900-0042\",\"time\":%d,\"temperature\":%d.%d,\"humidity\":%d,\"battery\":3.%02d}",
+				i ? "," : "", 1760000000 + i * 60, 18 + rand() % 6, rand() % 10, 40 + rand() % 20, 80 + rand() % 20 );
+		batch.data += text;
+	}
+	batch.data += "]";
+
+	for ( int i = 0; i < 40; i++ )
+	{
+		snprintf( text, sizeof( text ), "%s\"sensor%02d\":{\"enabled\":%s,\"interval\":%d,\"threshold\":%d,\"unit\":\"celsius\"}",
+				i ? "," : "", i, rand() % 2 ? "true" : "false", 60 * ( 1 + rand() % 10 ), rand() % 100 );
+		config.data += text;
+	}
+	config.data += "}";
+
+	for ( int i = 0; i < 1024; i++ )
+		noise.data += (char) ( ' ' + rand() % 95 );
+
+	payloads.push_back( reading );
+	payloads.push_back( batch );
+	payloads.push_back( config );
+	payloads.push_back( noise );
+	return payloads;
+}
+
+
+/** \brief Compresses a payload with a window
+ *
+ *	@param	IN	payload
+ *	@param	IN	window of Deflate
+ *	@param	OUT	compressed payload
+ *	@param	OUT	us per KB of the payload
+ */
+static void Compress(	const std::string & data,
+						const uint16_t & window,
+						std::string & compressed,
+						double & microsPerKb )
+{
+	char buffer[64];
+	double start = CpuMicros();
+
+	for ( uint16_t i = 0; i < ROUNDS; i++ )
+	{
+		Deflate deflate( data.c_str(), data.size(), window );
+
+		compressed.clear();
+		while ( uint16_t length = deflate.Read( buffer, sizeof( buffer ) ) )
+			compressed.append( buffer, length );
+	}
+
+	microsPerKb = ( CpuMicros() - start ) / ROUNDS / ( data.size() / 1024.0 );
+}
+
+
+/** \brief ms of the Post of a payload, compressed or not, at 9600 baud
+ */
+static double PostTime(	const std::string & data,
+						const bool & compressed )
+{
+	SimModem modem;
+	Connection sim( "1234", "internet", "", "", 2, (HardwareSerial &) modem, 9600 );
+	uint16_t httpReply;
+
+	modem.Attach( sim );
+	modem.SetLatency( LATENCY );
+	sim.Configuration();
+
+	uint64_t start = SimModem::Micros();
+
+	if ( compressed )
+		sim.PostCompressed( "www.example.com", "api", "events", data.c_str(), "application/json", httpReply );
+	else
+		sim.Post( "www.example.com", "api", "events", data.c_str(), httpReply );
+
+	return ( SimModem::Micros() - start ) / 1000.0;
+}
+
+
+int main()
+{
+	const uint16_t windows[] = { 64, 256, 1024, 4096 };
+	std::vector<Payload> payloads = Payloads();
+	bool inflated = true;
+
+	printf( "DeflateBench: %u rounds, compressed size and us per KB of the host by window\n", ROUNDS );
+
+	for ( size_t p = 0; p < payloads.size(); p++ )
+	{
+		const std::string & data = payloads[p].data;
+
+		for ( uint8_t w = 0; w < sizeof( windows ) / sizeof( windows[0] ); w++ )
+		{
+			double microsPerKb;
+			std::string compressed;
+			std::string inflatedData;
+
+			Compress( data, windows[w], compressed, microsPerKb );
+
+			printf( "%-14s %5u B window %4u: %5u B %4.0f%% saved %6.1f us/KB\n", payloads[p].name, (unsigned) data.size(),
+					windows[w], (unsigned) compressed.size(), 100.0 - 100.0 * compressed.size() / data.size(), microsPerKb );
+
+			if ( !Inflate( compressed, inflatedData ) || inflatedData != data )
+			{
+				printf( "%s window %u: the inflated data differs\n", payloads[p].name, windows[w] );
+				inflated = false;
+			}
+		}
+
+		printf( "%-14s %5u B Post at 9600 baud %7.1f ms, compressed %7.1f ms\n", payloads[p].name, (unsigned) data.size(),
+				PostTime( data, false ), PostTime( data, true ) );
+	}
+
+	return inflated ? 0 : 1;
+}
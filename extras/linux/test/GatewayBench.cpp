@@ -0,0 +1,89 @@
+/** SIM900 Basic communication library for SIM900 gsm module.
+ *
+ *	Throughput of a Gateway with 1 to 4 modules, each one a simulated module behind a
+ *	pty on the real clock at 115200 baud. The time of a Post is mostly the HTTPACTION of
+ *	the module, so the requests per second should grow with the modules.
+ *
+ *	Released under MIT license.
+ *
+ */
+#include "SIM900.h"
+#include "Gateway.h"
+#include "PosixSerial.h"
+#include "PtyModem.h"
+
+#include <stdio.h>
+#include <memory>
+#include <vector>
+
+static const uint16_t REQUESTS = 40;
+static const SimModem::Latency LATENCY = { 5, 200, 10, 10 };
+
+typedef Gateway<REQUESTS> BenchGateway;
+
+
+static bool Measure( const uint8_t & modems )
+{
+	std::vector< std::unique_ptr<PtyModem> > ptys;
+	std::vector< std::unique_ptr<PosixSerial> > ports;
+	std::vector< std::unique_ptr<Connection> > connections;
+	BenchGateway gateway;
+	bool healthy = true;
+
+	for ( uint8_t i = 0; i < modems; i++ )
+	{
+		ptys.push_back( std::unique_ptr<PtyModem>( new PtyModem() ) );
+		ptys[i]->GetModem().SetLatency( LATENCY );
+		ptys[i]->Start();
+
+		ports.push_back( std::unique_ptr<PosixSerial>( new PosixSerial( ptys[i]->GetDevice() ) ) );
+		connections.push_back( std::unique_ptr<Connection>( new Connection( "1234", "internet", "", "", 2, (HardwareSerial &) *ports[i], 115200 ) ) );
+		gateway.AddModem( *connections[i] );
+	}
+
+	// The modules are configured before the requests are timed
+	gateway.Start();
+	for ( uint8_t i = 0; i < modems; i++ )
+		while ( !gateway.GetModemStats( i ).configurations || !gateway.GetModemStats( i ).healthy )
+			delay( 10 );
+
+	unsigned long start = millis();
+
+	for ( uint16_t i = 0; i < REQUESTS; i++ )
+		gateway.Post( "www.example.com", "api", "events", "{\"temperature\":21}" );
+
+	gateway.Wait();
+
+	double seconds = ( millis() - start ) / 1000.0;
+	uint32_t failures = 0;
+
+	printf( "%u modules %8.0f ms %7.2f requests/s  requests per module:", modems, seconds * 1000, REQUESTS / seconds );
+	for ( uint8_t i = 0; i < modems; i++ )
+	{
+		ModemStats stats = gateway.GetModemStats( i );
+
+		printf( " %u", (unsigned) stats.requests );
+		failures += stats.failures;
+		healthy &= stats.healthy;
+	}
+	printf( ", %u failures\n", failures );
+
+	gateway.Stop();
+	for ( uint8_t i = 0; i < modems; i++ )
+		ptys[i]->Stop();
+
+	return healthy && failures == 0;
+}
+
+
+int main()
+{
+	bool ok = true;
+
+	printf( "GatewayBench: %u Posts, module action %u ms\n", REQUESTS, LATENCY.action );
+
+	for ( uint8_t modems = 1; modems <= 4; modems++ )
+		ok &= Measure( modems );
+
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,169 @@
+/** SIM900 Basic communication library for SIM900 gsm module.
+ *
+ *	Gateway over pty modules on the real clock:
+ *		- with a module out of service, the requests are made by the other one without
+ *		  waiting for the retry of the module out of service
+ *		- a request failed by a module is retried by the other one, not by the same
+ *		- with all the modules out of service, Wait() returns and the requests fail, and
+ *		  new requests are refused at once
+ *
+ *	Released under MIT license.
+ *
+ */
+#include "SIM900.h"
+#include "Gateway.h"
+#include "PosixSerial.h"
+#include "PtyModem.h"
+#include "Check.h"
+
+#include <atomic>
+
+static const SimModem::Latency LATENCY = { 5, 50, 10, 10 };
+static const SimModem::Latency SLOW_SERVER = { 5, 200, 10, 10 };
+
+static std::atomic<int> doneCount( 0 );
+static std::atomic<int> failedCount( 0 );
+
+
+static void OnDone(	bool done,
+					uint16_t /* httpReply */,
+					uint8_t /* modem */,
+					void * /* context */ )
+{
+	doneCount++;
+	if ( !done )
+		failedCount++;
+}
+
+
+/** \brief A module whose SIM doesn't answer: Configuration() fails
+ */
+static void Break( PtyModem & pty )
+{
+	pty.GetModem().Fail( "AT+CPIN?", "ERROR", 1000 );
+}
+
+
+int main()
+{
+	PtyModem down;
+	PtyModem up;
+
+	Break( down );
+	up.GetModem().SetLatency( LATENCY );
+	down.Start();
+	up.Start();
+
+	{
+		PosixSerial downPort( down.GetDevice() );
+		PosixSerial upPort( up.GetDevice() );
+		Connection downSim( "1234", "internet", "", "", 2, (HardwareSerial &) downPort, 115200 );
+		Connection upSim( "1234", "internet", "", "", 2, (HardwareSerial &) upPort, 115200 );
+		Gateway<8> gateway;
+
+		gateway.AddModem( downSim );
+		gateway.AddModem( upSim );
+		gateway.Start();
+
+		// Every request is made well before the module out of service retries
+		for ( int i = 0; i < 5; i++ )
+		{
+			unsigned long start = millis();
+
+			CHECK( gateway.Post( "www.example.com", "api", "events", "{}", OnDone ) );
+			gateway.Wait();
+			CHECK( millis() - start < Gateway<8>::HEALTH_RETRY_TIME / 2 );
+		}
+
+		CHECK( doneCount == 5 );
+		CHECK( failedCount == 0 );
+		CHECK( !gateway.GetModemStats( 0 ).healthy );
+		CHECK( gateway.GetModemStats( 1 ).requests == 5 );
+		gateway.Stop();
+	}
+
+	down.Stop();
+	up.Stop();
+
+	// A module that configures but fails every request: its requests end in the other one
+	PtyModem failing;
+	PtyModem healthy;
+
+	failing.GetModem().Fail( "AT+HTTPACTION", "ERROR", 1000 );
+	healthy.GetModem().SetLatency( SLOW_SERVER );
+	failing.Start();
+	healthy.Start();
+
+	{
+		PosixSerial failingPort( failing.GetDevice() );
+		PosixSerial healthyPort( healthy.GetDevice() );
+		Connection failingSim( "1234", "internet", "", "", 2, (HardwareSerial &) failingPort, 115200 );
+		Connection healthySim( "1234", "internet", "", "", 2, (HardwareSerial &) healthyPort, 115200 );
+		Gateway<8> gateway;
+
+		doneCount = 0;
+		failedCount = 0;
+		gateway.AddModem( failingSim );
+		gateway.AddModem( healthySim );
+		for ( int i = 0; i < 4; i++ )
+			CHECK( gateway.Post( "www.example.com", "api", "events", "{}", OnDone ) );
+		gateway.Start();
+		gateway.Wait();
+
+		ModemStats failingStats = gateway.GetModemStats( 0 );
+
+		CHECK( doneCount == 4 );
+		CHECK( failedCount == 0 );
+		CHECK( failingStats.failures >= 1 );
+		CHECK( failingStats.requeued == failingStats.failures );
+		CHECK( failingStats.requests == failingStats.failures );
+		CHECK( gateway.GetModemStats( 1 ).requests == 4 );
+		gateway.Stop();
+	}
+
+	failing.Stop();
+	healthy.Stop();
+
+	// No module in service
+	PtyModem first;
+	PtyModem second;
+
+	Break( first );
+	Break( second );
+	first.Start();
+	second.Start();
+
+	{
+		PosixSerial firstPort( first.GetDevice() );
+		PosixSerial secondPort( second.GetDevice() );
+		Connection firstSim( "1234", "internet", "", "", 2, (HardwareSerial &) firstPort, 115200 );
+		Connection secondSim( "1234", "internet", "", "", 2, (HardwareSerial &) secondPort, 115200 );
+		Gateway<8> gateway;
+		unsigned long start = millis();
+
+		doneCount = 0;
+		failedCount = 0;
+		gateway.AddModem( firstSim );
+		gateway.AddModem( secondSim );
+		CHECK( gateway.Post( "www.example.com", "api", "events", "{}", OnDone ) );
+		CHECK( gateway.Post( "www.example.com", "api", "events", "{}", OnDone ) );
+		gateway.Start();
+		gateway.Wait();
+
+		CHECK( doneCount == 2 );
+		CHECK( failedCount == 2 );
+		CHECK( gateway.Size() == 0 );
+		CHECK( millis() - start < Gateway<8>::HEALTH_RETRY_TIME );
+
+		// Refused without waiting in the queue
+		CHECK( !gateway.Post( "www.example.com", "api", "events", "{}", OnDone ) );
+		CHECK( gateway.Size() == 0 );
+		CHECK( doneCount == 2 );
+		gateway.Stop();
+	}
+
+	first.Stop();
+	second.Stop();
+
+	return CheckResult( "GatewayTest" );
+}
@@ -0,0 +1,108 @@
+/** SIM900 Basic communication library for SIM900 gsm module.
+ *
+ *	End to end latency of a Get of 100 bytes against the simulated module at 115200 baud,
+ *	with the receive path of the library and with the fixed sleeps of the first version
+ *	of it: 100 ms after every command before the answer is read and 1000 ms before
+ *	AT+HTTPREAD. The sleeps are added by the module side of the port, on the virtual
+ *	clock, so both columns run the same library code. With an instant module the time
+ *	left is the one of the serial port.
+ *
+ *	Released under MIT license.
+ *
+ */
+#include "SIM900.h"
+#include "SimModem.h"
+
+#include <stdio.h>
+#include <string>
+
+static const uint16_t ROUNDS = 20;
+static const uint32_t COMMAND_SLEEP = 100;
+static const uint32_t HTTPREAD_SLEEP = 1000;
+
+
+/** \brief Module that sleeps the virtual clock like the host did with the fixed sleeps
+ */
+class FixedSleepModem : public SimModem
+{
+public:
+	FixedSleepModem( const bool & sleeps ):
+		_sleeps( sleeps )
+	{
+	}
+
+	size_t write( uint8_t c )
+	{
+		if ( c == 0x0D && _sleeps && _line.compare( 0, 11, "AT+HTTPREAD" ) == 0 )
+			Delay( HTTPREAD_SLEEP );
+
+		size_t written = SimModem::write( c );
+
+		if ( c == 0x0D || c == 0x0A )
+		{
+			if ( c == 0x0D && _sleeps && _line.compare( 0, 2, "AT" ) == 0 )
+				Delay( COMMAND_SLEEP );
+			_line.clear();
+		}
+		else
+			_line += (char) c;
+
+		return written;
+	}
+
+	using SimModem::write;
+
+private:
+	bool _sleeps;
+	std::string _line;
+};
+
+
+/** \brief ms of a Get and commands sent, with the bearer open
+ */
+static double Measure(	const SimModem::Latency & latency,
+						const bool & sleeps,
+						uint32_t & commands )
+{
+	FixedSleepModem modem( sleeps );
+	Connection sim( "1234", "internet", "", "", 2, (HardwareSerial &) modem, 115200 );
+	uint16_t httpReply;
+	char body[128];
+	uint16_t bodyLength;
+
+	modem.Attach( sim );
+	modem.SetLatency( latency );
+	modem.SetGetReply( 200, std::string( 100, 'x' ) );
+	sim.Configuration();
+	modem.ClearTranscript();
+
+	uint64_t start = SimModem::Micros();
+
+	for ( uint16_t i = 0; i < ROUNDS; i++ )
+		sim.Get( "www.example.com", "api", "file", httpReply, body, sizeof( body ), bodyLength );
+
+	commands = modem.Commands() / ROUNDS;
+	return ( SimModem::Micros() - start ) / 1000.0 / ROUNDS;
+}
+
+
+int main()
+{
+	const SimModem::Latency latencies[] = { { 0, 0, 0, 0 }, { 20, 500, 50, 300 } };
+	bool faster = true;
+
+	printf( "GetLatencyBench: %u Gets of 100 B, ms per Get\n", ROUNDS );
+
+	for ( uint8_t i = 0; i < sizeof( latencies ) / sizeof( latencies[0] ); i++ )
+	{
+		uint32_t commands;
+		double now = Measure( latencies[i], false, commands );
+		double before = Measure( latencies[i], true, commands );
+
+		printf( "module command %3u ms action %3u ms: %8.1f ms, %8.1f ms with fixed sleeps, %u commands\n",
+				latencies[i].command, latencies[i].action, now, before, commands );
+		faster &= now < before;
+	}
+
+	return faster ? 0 : 1;
+}
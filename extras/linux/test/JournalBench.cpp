@@ -0,0 +1,90 @@
+/** SIM900 Basic communication library for SIM900 gsm module.
+ *
+ *	Drain of a PostJournal after a simulated outage: the first Post fails, the next ones
+ *	are saved in a FileStorage, and Drain() sends them when the link returns. The journal
+ *	is opened again before the drain, like after a reset. Reported with and without a
+ *	batch format, in ms of the virtual clock of the simulated module at 115200 baud.
+ *
+ *	Released under MIT license.
+ *
+ */
+#include "SIM900.h"
+#include "SIM900FileStorage.h"
+#include "SimModem.h"
+
+#include <stdio.h>
+#include <string>
+
+static const char STORAGE_FILE[] = "build/JournalBench.journal";
+static const uint32_t STORAGE_SIZE = 16384;
+
+
+static bool Measure(	const uint16_t & requests,
+						const bool & batched )
+{
+	SimModem modem;
+	Connection sim( "1234", "internet", "", "", 2, (HardwareSerial &) modem, 115200 );
+	uint32_t payload = 0;
+	uint16_t httpReply;
+	char data[48];
+
+	modem.Attach( sim );
+	sim.Configuration();
+	remove( STORAGE_FILE );
+
+	// The outage: the server can't be reached, every request is saved
+	{
+		FileStorage storage( STORAGE_FILE, STORAGE_SIZE );
+		PostJournal<> journal( sim, storage );
+
+		journal.Begin();
+		modem.Fail( "AT+HTTPACTION", "ERROR" );
+
+		for ( uint16_t i = 0; i < requests; i++ )
+		{
+			snprintf( data, sizeof( data ), "{\"sample\":%u,\"temperature\":21.5}", i );
+			payload += strlen( data );
+			if ( !journal.Post( "www.example.com", "api", "events", data, httpReply ) )
+				return false;
+		}
+	}
+
+	// The link returns after a reset
+	FileStorage storage( STORAGE_FILE, STORAGE_SIZE );
+	PostJournal<> journal( sim, storage );
+
+	if ( journal.Begin() != requests )
+		return false;
+
+	if ( batched )
+		journal.SetBatchFormat( "[", ",", "]", 512 );
+
+	uint32_t commands = modem.Commands();
+	uint16_t delivered = journal.Drain();
+	const JournalStats & stats = journal.GetStats();
+	double seconds = stats.drainTime / 1000.0;
+
+	printf( "%4u requests %-9s %8u ms %7.1f requests/s %8.0f B/s %4u posts %5u commands\n", requests,
+			batched ? "batched" : "one each", stats.drainTime, delivered / seconds, payload / seconds,
+			stats.posts, modem.Commands() - commands );
+
+	remove( STORAGE_FILE );
+	return delivered == requests && journal.Size() == 0;
+}
+
+
+int main()
+{
+	const uint16_t requests[] = { 10, 50, 100 };
+	bool drained = true;
+
+	printf( "JournalBench: drain after an outage\n" );
+
+	for ( uint8_t i = 0; i < sizeof( requests ) / sizeof( requests[0] ); i++ )
+	{
+		drained &= Measure( requests[i], false );
+		drained &= Measure( requests[i], true );
+	}
+
+	return drained ? 0 : 1;
+}
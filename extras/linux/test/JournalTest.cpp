@@ -0,0 +1,67 @@
+/** SIM900 Basic communication library for SIM900 gsm module.
+ *
+ *	PostJournal against the simulated module: the batch format, the session of the
+ *	caller and the time of Drain() on the clock of the connection.
+ *
+ *	Released under MIT license.
+ *
+ */
+#include "SIM900.h"
+#include "SIM900FileStorage.h"
+#include "SimModem.h"
+#include "Check.h"
+
+#include <stdio.h>
+#include <string>
+
+static const char STORAGE_FILE[] = "build/JournalTest.journal";
+
+
+int main()
+{
+	SimModem modem;
+	Connection sim( "1234", "internet", "", "", 2, (HardwareSerial &) modem, 115200 );
+
+	remove( STORAGE_FILE );
+	FileStorage storage( STORAGE_FILE, 4096 );
+	PostJournal<> journal( sim, storage );
+
+	modem.Attach( sim );
+	CHECK( sim.Configuration() );
+	CHECK( journal.Begin() == 0 );
+
+	journal.SetBatchFormat( "[", ",", "]" );
+
+	// A request alone has the batch format too
+	unsigned long start = SimModem::Millis();
+
+	CHECK( journal.Add( "www.example.com", "api", "events", "{\"t\":1}" ) );
+	CHECK( journal.Drain() == 1 );
+	CHECK( modem.GetPostData() == "[{\"t\":1}]" );
+	CHECK( journal.GetStats().drainTime == SimModem::Millis() - start );
+	CHECK( journal.GetStats().drainTime > 0 );
+
+	CHECK( journal.Add( "www.example.com", "api", "events", "{\"t\":2}" ) );
+	CHECK( journal.Add( "www.example.com", "api", "events", "{\"t\":3}" ) );
+	CHECK( journal.Drain() == 2 );
+	CHECK( modem.GetPostData() == "[{\"t\":2},{\"t\":3}]" );
+
+	// Drain() uses the session of the caller and leaves it open
+	CHECK( sim.BeginSession() );
+	uint32_t terms = modem.Commands( "AT+HTTPTERM" );
+
+	CHECK( journal.Add( "www.example.com", "api", "events", "{\"t\":4}" ) );
+	CHECK( journal.Drain() == 1 );
+	CHECK( sim.IsSessionOpen() );
+	CHECK( modem.Commands( "AT+HTTPTERM" ) == terms );
+	sim.EndSession();
+
+	// Without batch format a request is only its data
+	journal.SetBatchFormat( NULL, NULL, NULL );
+	CHECK( journal.Add( "www.example.com", "api", "events", "{\"t\":5}" ) );
+	CHECK( journal.Drain() == 1 );
+	CHECK( modem.GetPostData() == "{\"t\":5}" );
+
+	remove( STORAGE_FILE );
+	return CheckResult( "JournalTest" );
+}
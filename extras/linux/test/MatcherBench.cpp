@@ -0,0 +1,250 @@
+/** SIM900 Basic communication library for SIM900 gsm module.
+ *
+ *	Matching of the expected answers over the transcripts in test/transcripts and over
+ *	sessions of the simulated module, with two matchers:
+ *		strstr		the first one of the library: every char is appended to a buffer of
+ *					MAX_ATRESPONSE chars and every answer is searched in all of it
+ *		rescan		AnswerMatcher, O(m^2) on a mismatch for an answer of m chars
+ *	Both must find the same answer. The buffer of strstr is bounded here, the old code
+ *	wrote past it; answers found past it aren't compared.
+ *	A KMP failure table was tried too: 7.4 to 8.5 ns/char on the transcripts against 5.0
+ *	to 6.2 of the rescan, only the artificial overlapping answer was faster with it.
+ *
+ *	Released under MIT license.
+ *
+ */
+#include "SIM900.h"
+#include "SimModem.h"
+#include "Transcript.h"
+
+#include <stdio.h>
+#include <chrono>
+#include <string>
+#include <vector>
+
+static const uint16_t MAX_ATRESPONSE = 160;
+static const uint16_t ROUNDS = 2000;
+
+
+/** \brief Access to the matchers of the library
+ */
+struct Matchers : ConnectionBase
+{
+	using ConnectionBase::AnswerMatcher;
+	using ConnectionBase::BeginMatch;
+	using ConnectionBase::MatchNextChar;
+	using ConnectionBase::MAX_ANSWERS;
+};
+
+
+/** \brief Answers the library expects after a command
+ */
+static std::vector<const char *> ExpectedAnswers( const std::string & command )
+{
+	static const char * creg[] = { "+CREG: 0,0", "+CREG: 0,2", "+CREG: 0,4", "+CREG: 0,1", "+CREG: 0,5" };
+	static const struct { const char * command; const char * answer1; const char * answer2; } answers[] =
+	{
+		{ "AT+HTTPACTION=0", "+HTTPACTION:0,", NULL },
+		{ "AT+HTTPACTION=1", "+HTTPACTION:1,", NULL },
+		{ "AT+HTTPREAD", "+HTTPREAD:", "ERROR" },
+		{ "AT+HTTPHEAD", "+HTTPHEAD:", "ERROR" },
+		{ "AT+HTTPDATA", "DOWNLOAD", "ERROR" },
+		{ "AT+SAPBR=2,1", "1,1,\"", "1,3" },
+		{ "AT+CGATT?", ": 0", ": 1" },
+		{ "AT+CPIN?", "READY", "SIM PIN" },
+		{ "AT+CIPSHUT", "SHUT OK", "ERROR" },
+		{ "AT+CIPSTART=0", "0, CONNECT OK", "ERROR" },
+		{ "AT+CIPSEND", ">", "ERROR" },
+		{ "AT+CIFSR", ".", "ERROR" },
+		{ "AT+OVERLAP", "00000000000000000001", NULL },
+		{ "AT", "OK", "ERROR" },
+		{ "", "OK", "SEND OK" }
+	};
+
+	if ( command.compare( 0, 8, "AT+CREG?" ) == 0 )
+		return std::vector<const char *>( creg, creg + 5 );
+
+	for ( size_t i = 0; ; i++ )
+	{
+		if ( command.compare( 0, strlen( answers[i].command ), answers[i].command ) )
+			continue;
+
+		std::vector<const char *> expected( 1, answers[i].answer1 );
+		if ( answers[i].answer2 )
+			expected.push_back( answers[i].answer2 );
+
+		return expected;
+	}
+}
+
+
+/** \brief Result of a matcher: number of the answer, 0 if none, and chars read
+ */
+struct Match
+{
+	int answer;
+	size_t length;
+};
+
+
+static Match MatchStrstr(	const std::vector<const char *> & answers,
+							const std::string & reply )
+{
+	char response[MAX_ATRESPONSE];
+	Match match = { 0, 0 };
+
+	memset( response, '\0', sizeof( response ) );
+
+	while ( match.length < reply.size() && match.length < sizeof( response ) - 1 )
+	{
+		response[match.length] = reply[match.length];
+		match.length++;
+
+		for ( size_t i = 0; i < answers.size(); i++ )
+		{
+			if ( strstr( response, answers[i] ) != NULL )
+			{
+				match.answer = i + 1;
+				return match;
+			}
+		}
+	}
+
+	return match;
+}
+
+
+static Match MatchRescan(	const std::vector<const char *> & answers,
+							const std::string & reply )
+{
+	Matchers::AnswerMatcher matchers[Matchers::MAX_ANSWERS];
+	Match match = { 0, 0 };
+
+	for ( size_t i = 0; i < answers.size(); i++ )
+		Matchers::BeginMatch( matchers[i], answers[i], false );
+
+	while ( match.length < reply.size() )
+	{
+		char nextChar = reply[match.length++];
+
+		for ( size_t i = 0; i < answers.size(); i++ )
+		{
+			if ( Matchers::MatchNextChar( matchers[i], nextChar ) )
+			{
+				match.answer = i + 1;
+				return match;
+			}
+		}
+	}
+
+	return match;
+}
+
+
+typedef Match (*Matcher)( const std::vector<const char *> & answers, const std::string & reply );
+
+
+/** \brief ns per char read of a matcher over a session
+ */
+static double Measure(	Matcher matcher,
+						const std::vector<Exchange> & exchanges,
+						const std::vector< std::vector<const char *> > & answers )
+{
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	size_t chars = 0;
+
+	for ( uint16_t round = 0; round < ROUNDS; round++ )
+		for ( size_t i = 0; i < exchanges.size(); i++ )
+			chars += matcher( answers[i], exchanges[i].reply ).length;
+
+	std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+	return chars ? elapsed.count() / chars : 0;
+}
+
+
+/** \brief Matches a session with both matchers
+ *
+ *	@return	false if they don't find the same answers
+ */
+static bool Compare(	const char * name,
+						const Transcript & transcript )
+{
+	const std::vector<Exchange> & exchanges = transcript.GetExchanges();
+	std::vector< std::vector<const char *> > answers;
+	bool same = true;
+
+	for ( size_t i = 0; i < exchanges.size(); i++ )
+	{
+		answers.push_back( ExpectedAnswers( exchanges[i].command ) );
+
+		Match strstrMatch = MatchStrstr( answers[i], exchanges[i].reply );
+		Match rescanMatch = MatchRescan( answers[i], exchanges[i].reply );
+		bool inBuffer = rescanMatch.length < MAX_ATRESPONSE;
+
+		if ( inBuffer && strstrMatch.answer != rescanMatch.answer )
+		{
+			printf( "%s: different answers after %s\n", name, exchanges[i].command.substr( 0, exchanges[i].command.find( '\r' ) ).c_str() );
+			same = false;
+		}
+	}
+
+	printf( "%-24s %6u chars %9.1f ns/char strstr %7.1f ns/char rescan\n", name,
+			(unsigned) transcript.GetReplies().size(), Measure( MatchStrstr, exchanges, answers ),
+			Measure( MatchRescan, exchanges, answers ) );
+
+	return same;
+}
+
+
+/** \brief Session of the simulated module: Configuration, a Get of 4 KB and a Post
+ */
+static Transcript SimulatedSession()
+{
+	SimModem modem;
+	Connection sim( "1234", "internet", "", "", 2, (HardwareSerial &) modem, 115200 );
+	static char body[4096];
+	uint16_t bodyLength;
+	uint16_t httpReply;
+	Transcript transcript;
+
+	modem.Attach( sim );
+	modem.SetGetReply( 200, std::string( sizeof( body ) - 1, 'x' ) );
+	sim.Configuration();
+	sim.Get( "www.example.com", "api", "file", httpReply, body, sizeof( body ), bodyLength );
+	sim.Post( "www.example.com", "api", "events", "{\"temperature\":21}", httpReply );
+
+	transcript.Parse( modem.GetTranscript() );
+	return transcript;
+}
+
+
+int main()
+{
+	const char * files[] = { "configuration-get.txt", "post.txt", "urc.txt", "socket.txt" };
+	bool same = true;
+
+	printf( "MatcherBench: %u rounds\n", ROUNDS );
+
+	for ( size_t i = 0; i < sizeof( files ) / sizeof( files[0] ); i++ )
+	{
+		Transcript transcript;
+
+		if ( !transcript.Load( ( Transcript::Directory() + "/" + files[i] ).c_str() ) )
+		{
+			printf( "%s can't be read\n", files[i] );
+			return 1;
+		}
+
+		same &= Compare( files[i], transcript );
+	}
+
+	same &= Compare( "simulated session", SimulatedSession() );
+
+	// Worst case of the rescan: a self-overlapping answer that fails at its last char, every char
+	Transcript overlapping;
+
+	overlapping.Parse( "> AT+OVERLAP\n< " + std::string( 1000, '0' ) + "1\n" );
+	same &= Compare( "overlapping answers", overlapping );
+
+	return same ? 0 : 1;
+}
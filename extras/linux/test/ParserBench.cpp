@@ -0,0 +1,266 @@
+/** SIM900 Basic communication library for SIM900 gsm module.
+ *
+ *	Speed and allocations of the parsers of the answers of the module, the ones of the
+ *	fuzz targets in test/fuzz. The replies of the transcripts in test/transcripts, of a
+ *	session of the simulated module and some large ones are replayed through the parser
+ *	of the command they answer:
+ *		HttpAction		+HTTPACTION through GetHttpHeader
+ *		HttpRead		+HTTPREAD through ReceiveATReply and GetReceiveDataSize
+ *		AtReply			any other answer through MatchATReply
+ *		SocketReceive	+RECEIVE and its data through ReceiveSocketData
+ *		AsyncGet		the answers of a Get through Poll(), a new connection every time
+ *	The bytes are the ones the parser read. No parser may allocate memory.
+ *
+ *	Released under MIT license.
+ *
+ */
+#include "SIM900.h"
+#include "SimModem.h"
+#include "Transcript.h"
+#include "ReplayStream.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <new>
+#include <string>
+#include <vector>
+
+static const uint16_t ROUNDS = 200;
+
+static unsigned long allocations = 0;
+
+
+void * operator new( size_t size )
+{
+	void * memory = malloc( size ? size : 1 );
+
+	if ( !memory )
+		throw std::bad_alloc();
+
+	allocations++;
+	return memory;
+}
+
+
+void operator delete( void * memory ) noexcept
+{
+	free( memory );
+}
+
+
+void operator delete( void * memory, size_t ) noexcept
+{
+	free( memory );
+}
+
+
+enum Parser
+{
+	HTTP_ACTION,
+	HTTP_READ,
+	AT_REPLY,
+	SOCKET_RECEIVE,
+	ASYNC_GET,
+	PARSERS
+};
+
+static const char * parserNames[PARSERS] = { "HttpAction", "HttpRead", "AtReply", "SocketReceive", "AsyncGet" };
+
+
+struct Input
+{
+	Parser parser;
+	std::string data;
+};
+
+
+/** \brief Inputs of a session: every reply through the parser of its command and every
+ *		+RECEIVE through ReceiveSocketData
+ */
+static void AddSession(	const Transcript & transcript,
+						std::vector<Input> & inputs )
+{
+	const std::vector<Exchange> & exchanges = transcript.GetExchanges();
+
+	for ( size_t i = 0; i < exchanges.size(); i++ )
+	{
+		const std::string & command = exchanges[i].command;
+		const std::string & reply = exchanges[i].reply;
+		Input input = { AT_REPLY, reply };
+
+		if ( command.compare( 0, 15, "AT+HTTPACTION=0" ) == 0 )
+			input.parser = HTTP_ACTION;
+		else if ( command.compare( 0, 11, "AT+HTTPREAD" ) == 0 )
+			input.parser = HTTP_READ;
+
+		if ( !reply.empty() )
+			inputs.push_back( input );
+
+		for ( size_t start = reply.find( "+RECEIVE," ); start != std::string::npos; start = reply.find( "+RECEIVE,", start ) )
+		{
+			start += 9;
+			Input receive = { SOCKET_RECEIVE, reply.substr( start, reply.find( "+RECEIVE,", start ) - start ) };
+
+			inputs.push_back( receive );
+		}
+	}
+}
+
+
+/** \brief Session of the simulated module: Configuration, a Get of 4 KB and a Post
+ */
+static Transcript SimulatedSession()
+{
+	SimModem modem;
+	Connection sim( "1234", "internet", "", "", 2, (HardwareSerial &) modem, 115200 );
+	static char body[4096];
+	uint16_t bodyLength;
+	uint16_t httpReply;
+	Transcript transcript;
+
+	modem.Attach( sim );
+	modem.SetGetReply( 200, std::string( sizeof( body ) - 1, 'x' ) );
+	sim.Configuration();
+	sim.Get( "www.example.com", "api", "file", httpReply, body, sizeof( body ), bodyLength );
+	sim.Post( "www.example.com", "api", "events", "{\"temperature\":21}", httpReply );
+
+	transcript.Parse( modem.GetTranscript() );
+	return transcript;
+}
+
+
+/** \brief Large inputs: a Get of 4 KB read in windows of 100 bytes, the data of a TCP
+ *		segment and an answer after 4 KB of noise
+ */
+static void AddLarge( std::vector<Input> & inputs )
+{
+	Input get = { ASYNC_GET, "\r\nOK\r\n\r\n+HTTPACTION:0,200,4000\r\n" };
+	Input receive = { SOCKET_RECEIVE, "0,1400:\r\n" + std::string( 1400, 'x' ) };
+	Input noise = { AT_REPLY, std::string( 4096, '0' ) + "\r\nOK\r\n" };
+
+	for ( int window = 0; window < 40; window++ )
+		get.data += "\r\n+HTTPREAD:100\r\n" + std::string( 100, 'x' ) + "\r\nOK\r\n";
+	get.data += "\r\nOK\r\n";
+
+	inputs.push_back( get );
+	inputs.push_back( receive );
+	inputs.push_back( noise );
+}
+
+
+/** \brief Replays an input through its parser
+ *
+ *	@return	bytes read by the parser
+ */
+static size_t Parse(	ReplayStream & stream,
+						ReplayConnection & sim,
+						const Input & input )
+{
+	const uint8_t * data = (const uint8_t *) input.data.data();
+	size_t size = input.data.size();
+
+	if ( input.parser == ASYNC_GET )
+	{
+		ReplayStream getStream;
+		ReplayConnection getSim( getStream );
+
+		getSim.AsyncGet( data, size );
+		return size;
+	}
+
+	switch ( input.parser )
+	{
+		case HTTP_ACTION:
+			sim.HttpAction( data, size );
+			break;
+
+		case HTTP_READ:
+			sim.HttpRead( data, size );
+			break;
+
+		case SOCKET_RECEIVE:
+			sim.SocketReceive( data, size );
+			break;
+
+		default:
+			sim.AtReply( data, size );
+			break;
+	}
+
+	return size - stream.Pending();
+}
+
+
+/** \brief Time, bytes read and allocations of a parser over all its inputs
+ *
+ *	@return	false if the parser allocated memory
+ */
+static bool Measure(	const Parser & parser,
+						const std::vector<Input> & inputs )
+{
+	ReplayStream stream;
+	ReplayConnection sim( stream );
+	size_t count = 0;
+	size_t bytes = 0;
+
+	// A first round outside the measure, for the buffers that grow once
+	for ( size_t i = 0; i < inputs.size(); i++ )
+		if ( inputs[i].parser == parser )
+			Parse( stream, sim, inputs[i] );
+
+	unsigned long allocationsBefore = allocations;
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	for ( uint16_t round = 0; round < ROUNDS; round++ )
+	{
+		for ( size_t i = 0; i < inputs.size(); i++ )
+		{
+			if ( inputs[i].parser != parser )
+				continue;
+
+			bytes += Parse( stream, sim, inputs[i] );
+			count++;
+		}
+	}
+
+	std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+	unsigned long parseAllocations = allocations - allocationsBefore;
+
+	printf( "%-14s %5u inputs %8u bytes %8.1f ns/byte %8.1f MB/s %6.2f allocations/parse\n", parserNames[parser],
+			(unsigned) ( count / ROUNDS ), (unsigned) ( bytes / ROUNDS ), bytes ? elapsed.count() / bytes : 0,
+			elapsed.count() ? bytes * 1000.0 / elapsed.count() : 0, count ? (double) parseAllocations / count : 0 );
+
+	return parseAllocations == 0;
+}
+
+
+int main()
+{
+	const char * files[] = { "configuration-get.txt", "post.txt", "urc.txt", "socket.txt" };
+	std::vector<Input> inputs;
+	bool ok = true;
+
+	for ( size_t i = 0; i < sizeof( files ) / sizeof( files[0] ); i++ )
+	{
+		Transcript transcript;
+
+		if ( !transcript.Load( ( Transcript::Directory() + "/" + files[i] ).c_str() ) )
+		{
+			printf( "%s can't be read\n", files[i] );
+			return 1;
+		}
+
+		AddSession( transcript, inputs );
+	}
+
+	AddSession( SimulatedSession(), inputs );
+	AddLarge( inputs );
+
+	printf( "ParserBench: %u rounds\n", ROUNDS );
+
+	for ( int parser = 0; parser < PARSERS; parser++ )
+		ok &= Measure( (Parser) parser, inputs );
+
+	return ok ? 0 : 1;
+}
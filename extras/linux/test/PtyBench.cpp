@@ -0,0 +1,85 @@
+/** SIM900 Basic communication library for SIM900 gsm module.
+ *
+ *	Latency and CPU of the library thread on a Linux host, through PosixSerial and a pty,
+ *	while it waits for a slow module. The default idle, yield(), sleeps in poll(); a busy
+ *	idle callback is the spinning wait it replaces.
+ *
+ *	Released under MIT license.
+ *
+ */
+#include "SIM900.h"
+#include "PosixSerial.h"
+#include "PtyModem.h"
+
+#include <stdio.h>
+#include <sys/resource.h>
+#include <string>
+
+static const uint16_t ROUNDS = 10;
+static const SimModem::Latency LATENCY = { 5, 200, 10, 10 };
+
+
+/** \brief CPU time of the calling thread (ms)
+ */
+static double ThreadCpuMs()
+{
+	struct rusage usage;
+
+	getrusage( RUSAGE_THREAD, &usage );
+	return ( usage.ru_utime.tv_sec + usage.ru_stime.tv_sec ) * 1e3 + ( usage.ru_utime.tv_usec + usage.ru_stime.tv_usec ) / 1e3;
+}
+
+
+static void Spin()
+{
+}
+
+
+static void Measure(	const char * name,
+						ConnectionBase::IdleCallback idle )
+{
+	PtyModem pty;
+	uint16_t httpReply;
+	static char body[2048];
+	uint16_t bodyLength;
+	uint32_t worst = 0;
+
+	pty.GetModem().SetLatency( LATENCY );
+	pty.GetModem().SetGetReply( 200, std::string( 1024, 'x' ) );
+	pty.Start();
+
+	PosixSerial port( pty.GetDevice() );
+	Connection sim( "1234", "internet", "", "", 2, (HardwareSerial &) port, 115200 );
+
+	sim.SetIdleCallback( idle );
+	sim.Configuration();
+
+	unsigned long start = millis();
+	double cpu = ThreadCpuMs();
+
+	for ( uint16_t i = 0; i < ROUNDS; i++ )
+	{
+		unsigned long requestTime = millis();
+
+		sim.Get( "www.example.com", "api", "file", httpReply, body, sizeof( body ), bodyLength );
+		if ( millis() - requestTime > worst )
+			worst = millis() - requestTime;
+	}
+
+	double elapsed = millis() - start;
+	double used = ThreadCpuMs() - cpu;
+
+	printf( "%-14s %8.1f ms/Get %8u ms worst %8.1f ms cpu/Get %6.1f %% cpu\n", name, elapsed / ROUNDS, worst, used / ROUNDS, used * 100 / elapsed );
+	pty.Stop();
+}
+
+
+int main()
+{
+	printf( "PtyBench: %u Gets of 1 KB at 115200 baud, module action %u ms\n", ROUNDS, LATENCY.action );
+
+	Measure( "poll() idle", NULL );
+	Measure( "busy idle", Spin );
+
+	return 0;
+}
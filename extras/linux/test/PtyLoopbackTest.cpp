@@ -0,0 +1,64 @@
+/** SIM900 Basic communication library for SIM900 gsm module.
+ *
+ *	Configuration, Get and Post through PosixSerial and a pty, against the simulated
+ *	module on the real clock. A rate the host doesn't have keeps the one in use.
+ *
+ *	Released under MIT license.
+ *
+ */
+#include "SIM900.h"
+#include "PosixSerial.h"
+#include "PtyModem.h"
+#include "Check.h"
+
+#include <string>
+
+static const SimModem::Latency LATENCY = { 2, 20, 5, 10 };
+
+
+int main()
+{
+	PtyModem pty;
+	SimModem & modem = pty.GetModem();
+	std::string body;
+	uint16_t httpReply;
+	static char reply[2048];
+	uint16_t replyLength;
+
+	CHECK( pty.GetDevice() != NULL );
+	if ( !pty.GetDevice() )
+		return CheckResult( "PtyLoopbackTest" );
+
+	// A body bigger than a read batch of the port
+	for ( uint16_t i = 0; body.size() < 1500; i++ )
+		body += "{\"sample\":" + std::to_string( i ) + "}";
+
+	modem.SetLatency( LATENCY );
+	modem.SetGetReply( 200, body );
+	modem.SetPostReply( 201 );
+	pty.Start();
+
+	PosixSerial port( pty.GetDevice() );
+	Connection sim( "1234", "internet", "", "", 2, (HardwareSerial &) port, 115200 );
+
+	CHECK( port.IsOpen() );
+	CHECK( port.GetBaudRate() == 115200 );
+	CHECK( PosixSerial::CanSetBaudRate( 115200, &port ) );
+	CHECK( !PosixSerial::CanSetBaudRate( 250000, &port ) );
+	port.begin( 250000 );
+	CHECK( port.GetBaudRate() == 115200 );
+	CHECK( sim.Configuration() );
+
+	CHECK( sim.Get( "www.example.com", "api", "samples", httpReply, reply, sizeof( reply ), replyLength ) );
+	CHECK( httpReply == 200 );
+	CHECK( replyLength == body.size() );
+	CHECK( body == reply );
+
+	CHECK( sim.Post( "www.example.com", "api", "events", "{\"temperature\":21}", httpReply ) );
+	CHECK( httpReply == 201 );
+
+	pty.Stop();
+	CHECK( modem.GetPostData() == "{\"temperature\":21}" );
+
+	return CheckResult( "PtyLoopbackTest" );
+}
@@ -0,0 +1,117 @@
+/** SIM900 Basic communication library for SIM900 gsm module.
+ *
+ *	Simulated module behind a pseudo terminal.
+ *
+ *	Released under MIT license.
+ *
+ */
+#include "PtyModem.h"
+
+#include <stdio.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <termios.h>
+#include <unistd.h>
+
+
+PtyModem::PtyModem( const uint32_t & baudRate ):
+	_modem( false ),
+	_master( -1 ),
+	_slave( -1 ),
+	_running( false )
+{
+	struct termios options;
+
+	_device[0] = '\0';
+	_modem.begin( baudRate );
+	_modem.SetBaudRate( baudRate );
+
+	_master = posix_openpt( O_RDWR | O_NOCTTY | O_NONBLOCK );
+	if ( _master < 0 || grantpt( _master ) != 0 || unlockpt( _master ) != 0 )
+		return;
+
+	snprintf( _device, sizeof( _device ), "%s", ptsname( _master ) );
+
+	// The slave is kept open, without it the master reads fail when the library closes its side
+	_slave = open( _device, O_RDWR | O_NOCTTY );
+	if ( _slave >= 0 && tcgetattr( _slave, &options ) == 0 )
+	{
+		cfmakeraw( &options );
+		tcsetattr( _slave, TCSANOW, &options );
+	}
+}
+
+
+PtyModem::~PtyModem()
+{
+	Stop();
+
+	if ( _slave >= 0 )
+		close( _slave );
+	if ( _master >= 0 )
+		close( _master );
+}
+
+
+const char * PtyModem::GetDevice()
+{
+	return _slave >= 0 ? _device : NULL;
+}
+
+
+SimModem & PtyModem::GetModem()
+{
+	return _modem;
+}
+
+
+void PtyModem::Start()
+{
+	if ( _running || _slave < 0 )
+		return;
+
+	_running = true;
+	_thread = std::thread( &PtyModem::Run, this );
+}
+
+
+void PtyModem::Stop()
+{
+	_running = false;
+
+	if ( _thread.joinable() )
+		_thread.join();
+}
+
+
+void PtyModem::Run()
+{
+	uint8_t buffer[256];
+
+	while ( _running )
+	{
+		struct pollfd input = { _master, POLLIN, 0 };
+		std::string output;
+		int c;
+
+		// The answers wait for their time in the module, so the thread wakes up every ms
+		poll( &input, 1, 1 );
+
+		ssize_t length = read( _master, buffer, sizeof( buffer ) );
+		if ( length > 0 )
+			_modem.write( buffer, length );
+
+		while ( ( c = _modem.read() ) >= 0 )
+			output += (char) c;
+
+		for ( size_t written = 0; written < output.size(); )
+		{
+			ssize_t size = write( _master, output.data() + written, output.size() - written );
+
+			if ( size > 0 )
+				written += size;
+			else
+				poll( NULL, 0, 1 );
+		}
+	}
+}
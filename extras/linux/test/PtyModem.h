@@ -0,0 +1,60 @@
+/** SIM900 Basic communication library for SIM900 gsm module.
+ *
+ *	Simulated module behind a pseudo terminal: the library opens its device with
+ *	PosixSerial like a real serial port.
+ *
+ *	Released under MIT license.
+ *
+ */
+#pragma once
+#ifndef __PtyModem_h__
+#define __PtyModem_h__
+
+#include "SimModem.h"
+
+#include <thread>
+
+/** \brief SimModem on the real clock, served by a thread on the master side of a pty.
+ *		Configure the module with GetModem() before Start() and read it after Stop().
+ */
+class PtyModem
+{
+public:
+	/** \brief Constructuor. Opens the pty.
+	 *
+	 *	@param	IN	rate that paces the answers of the module
+	 */
+	PtyModem( const uint32_t & baudRate = 115200 );
+
+	~PtyModem();
+
+	/** \brief Device of the pty for PosixSerial, e.g. /dev/pts/3. NULL if it couldn't be opened.
+	 */
+	const char * GetDevice();
+
+	SimModem & GetModem();
+
+	/** \brief Starts the thread that serves the module
+	 */
+	void Start();
+
+	/** \brief Stops the thread
+	 */
+	void Stop();
+
+protected:
+	/** \brief Thread: passes the bytes of the pty to the module and its answers back
+	 */
+	void Run();
+
+private:
+	SimModem _modem;
+	int _master;
+	int _slave;
+	char _device[32];
+
+	std::thread _thread;
+	volatile bool _running;
+};
+
+#endif
@@ -0,0 +1,64 @@
+/** SIM900 Basic communication library for SIM900 gsm module.
+ *
+ *	RequestQueue against the simulated module: the batch format, the session of the
+ *	caller and the time of Drain() on the clock of the connection.
+ *
+ *	Released under MIT license.
+ *
+ */
+#include "SIM900.h"
+#include "SIM900Queue.h"
+#include "SimModem.h"
+#include "Check.h"
+
+#include <string>
+
+
+int main()
+{
+	SimModem modem;
+	Connection sim( "1234", "internet", "", "", 2, (HardwareSerial &) modem, 115200 );
+	RequestQueue<8> queue( sim );
+
+	modem.Attach( sim );
+	CHECK( sim.Configuration() );
+
+	queue.SetBatchFormat( "[", ",", "]" );
+
+	// A request alone has the batch format too
+	unsigned long start = SimModem::Millis();
+
+	CHECK( queue.Add( "www.example.com", "api", "events", "{\"t\":1}" ) );
+	CHECK( queue.Drain() == 1 );
+	CHECK( modem.GetPostData() == "[{\"t\":1}]" );
+	CHECK( queue.GetStats().drainTime == SimModem::Millis() - start );
+	CHECK( queue.GetStats().drainTime > 0 );
+
+	CHECK( queue.Add( "www.example.com", "api", "events", "{\"t\":2}" ) );
+	CHECK( queue.Add( "www.example.com", "api", "events", "{\"t\":3}" ) );
+	CHECK( queue.Add( "www.example.com", "api", "events", "{\"t\":4}" ) );
+	CHECK( queue.Drain() == 3 );
+	CHECK( modem.GetPostData() == "[{\"t\":2},{\"t\":3},{\"t\":4}]" );
+	CHECK( queue.GetStats().posts == 2 );
+
+	// Drain() uses the session of the caller and leaves it open
+	CHECK( sim.BeginSession() );
+	uint32_t terms = modem.Commands( "AT+HTTPTERM" );
+
+	CHECK( queue.Add( "www.example.com", "api", "events", "{\"t\":5}" ) );
+	CHECK( queue.Drain() == 1 );
+	CHECK( sim.IsSessionOpen() );
+	CHECK( modem.Commands( "AT+HTTPTERM" ) == terms );
+
+	sim.EndSession();
+	CHECK( !sim.IsSessionOpen() );
+	CHECK( modem.Commands( "AT+HTTPTERM" ) == terms + 1 );
+
+	// Without batch format a request is only its data
+	queue.SetBatchFormat( NULL, NULL, NULL );
+	CHECK( queue.Add( "www.example.com", "api", "events", "{\"t\":6}" ) );
+	CHECK( queue.Drain() == 1 );
+	CHECK( modem.GetPostData() == "{\"t\":6}" );
+
+	return CheckResult( "QueueTest" );
+}
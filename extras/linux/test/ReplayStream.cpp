@@ -0,0 +1,218 @@
+/** SIM900 Basic communication library for SIM900 gsm module.
+ *
+ *	Replay of the output of a module.
+ *
+ *	Released under MIT license.
+ *
+ */
+#include "ReplayStream.h"
+
+#include <string.h>
+#include <string>
+
+unsigned long ReplayStream::_now = 0;
+
+
+ReplayStream::ReplayStream():
+	_data( NULL ),
+	_size( 0 ),
+	_position( 0 ),
+	_answer( NULL ),
+	_answerSize( 0 )
+{
+}
+
+
+void ReplayStream::Replay(	const uint8_t * data,
+							size_t size )
+{
+	_data = data;
+	_size = size;
+	_position = 0;
+}
+
+
+void ReplayStream::ReplayAfterCommand(	const uint8_t * data,
+										size_t size )
+{
+	_answer = data;
+	_answerSize = size;
+}
+
+
+size_t ReplayStream::Pending()
+{
+	return _size - _position;
+}
+
+
+int ReplayStream::available()
+{
+	return _size - _position;
+}
+
+
+int ReplayStream::read()
+{
+	return _position < _size ? _data[_position++] : -1;
+}
+
+
+int ReplayStream::peek()
+{
+	return _position < _size ? _data[_position] : -1;
+}
+
+
+size_t ReplayStream::write( uint8_t c )
+{
+	return write( &c, 1 );
+}
+
+
+size_t ReplayStream::write(	const uint8_t * buffer,
+							size_t size )
+{
+	if ( _answer && memchr( buffer, 0x0A, size ) )
+	{
+		Replay( _answer, _answerSize );
+		_answer = NULL;
+	}
+
+	return size;
+}
+
+
+unsigned long ReplayStream::Millis()
+{
+	return _now;
+}
+
+
+void ReplayStream::Delay( unsigned long time )
+{
+	_now += time;
+}
+
+
+void ReplayStream::Idle()
+{
+	_now += 1000;
+}
+
+
+ReplayConnection::ReplayConnection( ReplayStream & stream ):
+	Connection( "1234", "internet", "", "", 2, stream ),
+	_stream( stream ),
+	_socketBytes( 0 )
+{
+	SetClock( ReplayStream::Millis, ReplayStream::Delay );
+	SetIdleCallback( ReplayStream::Idle );
+	SetSocketCallback( CountSocketData, this );
+}
+
+
+bool ReplayConnection::HttpAction(	const uint8_t * data,
+									size_t size )
+{
+	uint16_t httpReply;
+	uint32_t dataLength;
+
+	Begin( data, size );
+	return GetHttpHeader( F("+HTTPACTION:0,"), httpReply, dataLength, DefaultConnectionPolicy::HTTPACTION_TIMEOUT );
+}
+
+
+uint16_t ReplayConnection::HttpRead(	const uint8_t * data,
+										size_t size )
+{
+	Begin( data, size );
+
+	if ( ReceiveATReply( F("+HTTPREAD:"), F("ERROR"), DefaultConnectionPolicy::HTTPREAD_TIMEOUT ) != 1 )
+		return 0;
+
+	return GetReceiveDataSize( DefaultConnectionPolicy::BODY_TIMEOUT );
+}
+
+
+int8_t ReplayConnection::AtReply(	const uint8_t * data,
+									size_t size )
+{
+	const char * answers[] = { "OK", "ERROR", "DOWNLOAD", "+HTTPACTION:1,", "+CREG: 0,1" };
+
+	Begin( data, size );
+	return MatchATReply( answers, sizeof( answers ) / sizeof( answers[0] ), 5000, false );
+}
+
+
+uint32_t ReplayConnection::SocketReceive(	const uint8_t * data,
+											size_t size )
+{
+	char line[DefaultConnectionPolicy::URC_LINE_SIZE] = "+RECEIVE,";
+	size_t length = strlen( line );
+	size_t end = 0;
+
+	while ( end < size && data[end] != 0x0A )
+	{
+		if ( length < sizeof( line ) - 1 )
+			line[length++] = data[end];
+		end++;
+	}
+	line[length] = '\0';
+
+	// The data comes after the LF
+	if ( end < size )
+		end++;
+
+	_socketBytes = 0;
+	Begin( data + end, size - end );
+	ReceiveSocketData( line );
+	return _socketBytes;
+}
+
+
+ConnectionBase::RequestStatus ReplayConnection::AsyncGet(	const uint8_t * data,
+															size_t size )
+{
+	static const char bearer[] = "\r\n+SAPBR: 1,1,\"10.0.0.2\"\r\n\r\nOK\r\n";
+	static const char setup[] = "\r\nOK\r\n\r\nOK\r\n\r\nOK\r\n\r\nOK\r\n";
+
+	// The bearer is probed before the request starts, blocking
+	_stream.ReplayAfterCommand( (const uint8_t *) bearer, sizeof( bearer ) - 1 );
+	if ( !StartGet( "www.example.com", "api", "file", NULL ) )
+		return REQUEST_FAILED;
+
+	// The OKs of HTTPINIT, CID and URL, then the answers after AT+HTTPACTION=0. The OKs
+	// that are left over are skipped while +HTTPACTION is expected. The buffer is kept
+	// between replays, it only allocates when an input is larger than all before.
+	static std::string replies;
+
+	replies.assign( setup );
+	replies.append( (const char *) data, size );
+	_stream.Replay( (const uint8_t *) replies.data(), replies.size() );
+
+	// Every Poll() reads or times out, the limit only guards against a loop
+	for ( size_t polls = 0; polls < 4 * size + 100 && Poll() == REQUEST_RUNNING; polls++ )
+		ReplayStream::Idle();
+
+	_stream.Replay( NULL, 0 );
+	return GetRequestStatus();
+}
+
+
+void ReplayConnection::Begin(	const uint8_t * data,
+								size_t size )
+{
+	_stream.Replay( NULL, 0 );
+	CleanSerialBuffer();
+	_stream.Replay( data, size );
+}
+
+
+void ReplayConnection::CountSocketData(	uint8_t /* link */,
+										const char * /* chunk */,
+										uint16_t length,
+										void * context )
+{
+	( (ReplayConnection *) context )->_socketBytes += length;
+}
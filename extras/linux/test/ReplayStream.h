@@ -0,0 +1,127 @@
+/** SIM900 Basic communication library for SIM900 gsm module.
+ *
+ *	Replay of the output of a module, without timing, for the parser benchmark and the
+ *	fuzz targets. The library reads the bytes given to Replay() as fast as it can; what
+ *	it writes is dropped. The clock only moves when the library waits, so a wait for
+ *	more input ends at once with a timeout.
+ *
+ *	Released under MIT license.
+ *
+ */
+#pragma once
+#ifndef __ReplayStream_h__
+#define __ReplayStream_h__
+
+#include "SIM900.h"
+
+class ReplayStream : public Stream
+{
+public:
+	ReplayStream();
+
+	/** \brief Bytes the library reads next. They aren't copied, keep them until read.
+	 */
+	void Replay(	const uint8_t * data,
+					size_t size );
+
+	/** \brief Bytes the library reads after it sends its next command line, like the answer
+	 *		of a module. The input before it is dropped.
+	 */
+	void ReplayAfterCommand(	const uint8_t * data,
+								size_t size );
+
+	/** \brief Bytes not read yet
+	 */
+	size_t Pending();
+
+	int available();
+	int read();
+	int peek();
+	size_t write( uint8_t c );
+	size_t write(	const uint8_t * buffer,
+					size_t size );
+
+	using Print::write;
+
+	/** \brief Clock of the replay for SetClock(): the idle time jumps a second
+	 */
+	static unsigned long Millis();
+	static void Delay( unsigned long time );
+	static void Idle();
+
+private:
+	const uint8_t * _data;
+	size_t _size;
+	size_t _position;
+
+	const uint8_t * _answer;
+	size_t _answerSize;
+
+	static unsigned long _now;
+};
+
+
+/** \brief Connection over a ReplayStream with the parsers of the library at hand.
+ *		Every method replays some bytes through one parser.
+ */
+class ReplayConnection : public Connection
+{
+public:
+	ReplayConnection( ReplayStream & stream );
+
+	/** \brief The answer to AT+HTTPACTION=0 through GetHttpHeader
+	 *
+	 *	@return	true if it is parsed
+	 */
+	bool HttpAction(	const uint8_t * data,
+						size_t size );
+
+	/** \brief The answer to AT+HTTPREAD through ReceiveATReply and GetReceiveDataSize
+	 *
+	 *	@return	size of the data announced, 0 if it isn't parsed
+	 */
+	uint16_t HttpRead(	const uint8_t * data,
+						size_t size );
+
+	/** \brief Some answer of the module through MatchATReply, with the answers of the commands
+	 *		of a request
+	 *
+	 *	@return	number of the answer found, 0 if none
+	 */
+	int8_t AtReply(	const uint8_t * data,
+					size_t size );
+
+	/** \brief A +RECEIVE line and its data through ReceiveSocketData. The line ends at the
+	 *		first LF and is cut at URC_LINE_SIZE like in ProcessUrcs().
+	 *
+	 *	@return	bytes of data given to the SocketCallback
+	 */
+	uint32_t SocketReceive(	const uint8_t * data,
+							size_t size );
+
+	/** \brief The answers after AT+HTTPACTION=0 of an asynchronous Get: +HTTPACTION, the
+	 *		+HTTPREAD windows and their data, polled until the request ends. Use a new
+	 *		connection for every replay, the state of the bearer changes the commands sent.
+	 *
+	 *	@return	status of the request
+	 */
+	RequestStatus AsyncGet(	const uint8_t * data,
+							size_t size );
+
+private:
+	/** \brief Replays the bytes after the state left by the previous replay is cleared, like
+	 *		before a command
+	 */
+	void Begin(	const uint8_t * data,
+				size_t size );
+
+	static void CountSocketData(	uint8_t link,
+									const char * chunk,
+									uint16_t length,
+									void * context );
+
+	ReplayStream & _stream;
+	uint32_t _socketBytes;
+};
+
+#endif
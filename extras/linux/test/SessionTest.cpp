@@ -0,0 +1,111 @@
+/** SIM900 Basic communication library for SIM900 gsm module.
+ *
+ *	Persistent HTTP session against the simulated module. The commands of every request
+ *	are counted in the transcript of the session:
+ *		- with BeginSession() a Get or a Post doesn't send HTTPINIT, CID or HTTPTERM
+ *		  and sends fewer commands than without it
+ *		- when the module drops the session the next request opens it again and works
+ *
+ *	Released under MIT license.
+ *
+ */
+#include "SIM900.h"
+#include "SimModem.h"
+#include "Transcript.h"
+#include "Check.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <string>
+
+static const uint16_t REQUESTS = 5;
+
+
+/** \brief Commands of the transcript of the module that start with prefix
+ */
+static uint32_t Commands(	SimModem & modem,
+							const char * prefix = "AT" )
+{
+	Transcript transcript;
+	const std::vector<Exchange> & exchanges = transcript.GetExchanges();
+	uint32_t commands = 0;
+
+	transcript.Parse( modem.GetTranscript() );
+
+	for ( size_t i = 0; i < exchanges.size(); i++ )
+		if ( exchanges[i].command.compare( 0, strlen( prefix ), prefix ) == 0 )
+			commands++;
+
+	return commands;
+}
+
+
+/** \brief REQUESTS Posts and Gets
+ *
+ *	@return	false if any fails
+ */
+static bool Requests( Connection & sim )
+{
+	char body[64];
+	uint16_t bodyLength;
+	uint16_t httpReply;
+	bool done = true;
+
+	for ( uint16_t i = 0; i < REQUESTS; i++ )
+	{
+		done &= sim.Post( "www.example.com", "api", "events", "{\"t\":1}", httpReply );
+		done &= sim.Get( "www.example.com", "api", "file", httpReply, body, sizeof( body ), bodyLength );
+	}
+
+	return done;
+}
+
+
+int main()
+{
+	SimModem modem;
+	Connection sim( "1234", "internet", "", "", 2, (HardwareSerial &) modem, 115200 );
+
+	modem.Attach( sim );
+	modem.SetGetReply( 200, "{\"hour\":10}" );
+	CHECK( sim.Configuration() );
+
+	// Without session every request initializes and terminates the HTTP service
+	modem.ClearTranscript();
+	CHECK( Requests( sim ) );
+
+	uint32_t commandsAlone = Commands( modem );
+
+	CHECK( Commands( modem, "AT+HTTPINIT" ) == 2 * REQUESTS );
+	CHECK( Commands( modem, "AT+HTTPPARA=\"CID\"" ) == 2 * REQUESTS );
+	CHECK( Commands( modem, "AT+HTTPTERM" ) == 2 * REQUESTS );
+
+	// With session only the URL and the action of every request
+	CHECK( sim.BeginSession() );
+	modem.ClearTranscript();
+	CHECK( Requests( sim ) );
+
+	uint32_t commandsInSession = Commands( modem );
+
+	CHECK( Commands( modem, "AT+HTTPINIT" ) == 0 );
+	CHECK( Commands( modem, "AT+HTTPPARA=\"CID\"" ) == 0 );
+	CHECK( Commands( modem, "AT+HTTPTERM" ) == 0 );
+	CHECK( commandsInSession + 3 * 2 * REQUESTS <= commandsAlone );
+	printf( "SessionTest: %.1f commands per request, %.1f in a session\n",
+			commandsAlone / ( 2.0 * REQUESTS ), commandsInSession / ( 2.0 * REQUESTS ) );
+
+	// The module drops the session: the next request resets the HTTP service and opens it
+	// again, the ones after it don't
+	modem.DropSession();
+	modem.ClearTranscript();
+	CHECK( Requests( sim ) );
+	CHECK( sim.IsSessionOpen() );
+	CHECK( Commands( modem, "AT+HTTPINIT" ) == 1 );
+	CHECK( Commands( modem, "AT+HTTPTERM" ) == 1 );
+	CHECK( Commands( modem ) <= commandsInSession + 4 );
+
+	sim.EndSession();
+	CHECK( !sim.IsSessionOpen() );
+
+	return CheckResult( "SessionTest" );
+}
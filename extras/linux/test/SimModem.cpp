@@ -0,0 +1,861 @@
+/** SIM900 Basic communication library for SIM900 gsm module.
+ *
+ *	Simulated SIM900 for the host tests and benchmarks.
+ *
+ *	Released under MIT license.
+ *
+ */
+#include "SimModem.h"
+
+#include <stdio.h>
+#include <time.h>
+#include <algorithm>
+
+uint64_t SimModem::_now = 0;
+SimModem * SimModem::_current = NULL;
+
+static const SimModem::Latency DEFAULT_LATENCY = { 20, 500, 50, 300 };
+
+
+/** \brief Compares a byte with a time, to find the first one that didn't arrive yet
+ */
+struct ArrivesAfter
+{
+	template <class Byte>
+	bool operator()(	const uint64_t & time,
+						const Byte & byte ) const
+	{
+		return time < byte.time;
+	}
+};
+
+
+SimModem::SimModem( const bool & virtualClock ):
+	_virtualClock( virtualClock ),
+	_hostBaudRate( 0 ),
+	_baudRate( 0 ),
+	_latency( DEFAULT_LATENCY ),
+	_outputTime( 0 ),
+	_lineEnded( false ),
+	_dataExpected( 0 ),
+	_socketData( false ),
+	_socketLink( 0 ),
+	_socketsOpen( 0 ),
+	_sendFailures( 0 ),
+	_powered( true ),
+	_powerKey( false ),
+	_powerKeyTime( 0 ),
+	_bootTime( 0 ),
+	_readyTime( 0 ),
+	_simState( "READY" ),
+	_sleepMode( 0 ),
+	_dtr( false ),
+	_waking( false ),
+	_inputTime( 0 ),
+	_functionLevel( 1 ),
+	_bearerOpen( false ),
+	_httpInitialized( false ),
+	_echo( false ),
+	_getReply( 200 ),
+	_postReply( 200 )
+{
+	if ( _virtualClock )
+		_current = this;
+}
+
+
+SimModem::~SimModem()
+{
+	if ( _current == this )
+		_current = NULL;
+}
+
+
+void SimModem::begin( unsigned long baudRate )
+{
+	_hostBaudRate = baudRate;
+}
+
+
+int SimModem::available()
+{
+	std::deque<Byte>::iterator arrived = std::upper_bound( _output.begin(), _output.end(), Now(), ArrivesAfter() );
+
+	return arrived - _output.begin();
+}
+
+
+int SimModem::read()
+{
+	int c = peek();
+
+	if ( c >= 0 )
+		_output.pop_front();
+
+	return c;
+}
+
+
+int SimModem::peek()
+{
+	if ( _output.empty() || _output.front().time > Now() )
+		return -1;
+
+	return _output.front().value;
+}
+
+
+size_t SimModem::write( uint8_t c )
+{
+	if ( _virtualClock )
+	{
+		_current = this;
+		_now += ByteTime( _hostBaudRate );
+	}
+
+	if ( !_powered || Now() < _readyTime )
+		return 1;
+
+	// Autobaud takes the rate of the first byte
+	if ( !_baudRate )
+		_baudRate = _hostBaudRate;
+
+	if ( _hostBaudRate && _baudRate != _hostBaudRate )
+		return 1;
+
+	if ( IsAsleep() )
+	{
+		if ( _sleepMode == 1 )
+			return 1;
+		_waking = true;
+	}
+
+	_inputTime = Now();
+
+	if ( _waking )
+	{
+		_waking = c != '\r' && c != '\n';
+		return 1;
+	}
+
+	Receive( c );
+	return 1;
+}
+
+
+size_t SimModem::write(	const uint8_t * buffer,
+						size_t size )
+{
+	for ( size_t i = 0; i < size; i++ )
+		write( buffer[i] );
+
+	return size;
+}
+
+
+void SimModem::SetBaudRate( const uint32_t & baudRate )
+{
+	_baudRate = baudRate;
+}
+
+
+uint32_t SimModem::GetBaudRate()
+{
+	return _baudRate;
+}
+
+
+void SimModem::SetLatency( const Latency & latency )
+{
+	_latency = latency;
+}
+
+
+void SimModem::SetGetReply(	const uint16_t & httpReply,
+							const std::string & body,
+							const std::string & headers )
+{
+	_getReply = httpReply;
+	_getBody = body;
+	_getHeaders = headers;
+}
+
+
+void SimModem::SetPostReply( const uint16_t & httpReply )
+{
+	_postReply = httpReply;
+}
+
+
+void SimModem::Fail(	const char * prefix,
+						const char * answer,
+						const uint16_t & count )
+{
+	Override fail = { prefix, answer ? answer : "", answer == NULL, 0, count };
+
+	_overrides.push_back( fail );
+}
+
+
+void SimModem::Stall(	const char * prefix,
+						const uint32_t & time )
+{
+	Override stall = { prefix, "", false, time, 1 };
+
+	_overrides.push_back( stall );
+}
+
+
+void SimModem::SendUrc(	const char * line,
+						const uint32_t & delay )
+{
+	std::string urc( line );
+
+	// The answers of the module that haven't started when the bearer is lost are never sent
+	if ( urc == "+SAPBR 1: DEACT" || urc == "+PDP: DEACT" )
+		DropOutput( Now() + (uint64_t) delay * 1000 );
+
+	ApplyUrc( urc );
+	Answer( urc, delay );
+}
+
+
+void SimModem::DropOutput( const uint64_t & time )
+{
+	size_t kept = 0;
+
+	// A line that started before the time is sent whole
+	while ( kept < _output.size() && ( _output[kept].time <= time || ( kept > 0 && _output[kept - 1].value != 0x0A ) ) )
+		kept++;
+
+	_output.resize( kept );
+	_outputTime = kept ? _output[kept - 1].time : 0;
+}
+
+
+void SimModem::SendRaw(	const std::string & bytes,
+						const uint32_t & delay )
+{
+	Send( bytes, delay );
+}
+
+
+void SimModem::DropSession()
+{
+	_httpInitialized = false;
+}
+
+
+void SimModem::CloseSocket(	const uint8_t & link,
+							const uint32_t & delay )
+{
+	char line[16];
+
+	snprintf( line, sizeof( line ), "%u, CLOSED", link );
+	_socketsOpen &= ~( 1 << link );
+	Answer( line, delay );
+}
+
+
+void SimModem::FailSend( const uint16_t & count )
+{
+	_sendFailures = count;
+}
+
+
+bool SimModem::IsSocketOpen( const uint8_t & link )
+{
+	return _socketsOpen & ( 1 << link );
+}
+
+
+void SimModem::SetPowered( const bool & powered )
+{
+	_powered = powered;
+
+	if ( !powered )
+	{
+		_bearerOpen = false;
+		_httpInitialized = false;
+		_dataExpected = 0;
+		_line.clear();
+		_socketsOpen = 0;
+		_sleepMode = 0;
+		_waking = false;
+		_functionLevel = 1;
+	}
+}
+
+
+void SimModem::SetPowerKey( const bool & high )
+{
+	if ( high )
+	{
+		if ( !_powerKey )
+			_powerKeyTime = Now();
+		_powerKey = true;
+		return;
+	}
+
+	bool pulse = _powerKey && Now() - _powerKeyTime >= POWER_KEY_TIME * 1000ULL;
+
+	_powerKey = false;
+	if ( !pulse )
+		return;
+
+	if ( _powered )
+	{
+		Answer( "NORMAL POWER DOWN", 0 );
+		SetPowered( false );
+		return;
+	}
+
+	SetPowered( true );
+	_readyTime = Now() + (uint64_t) _bootTime * 1000;
+
+	// With autobaud it is silent until the first AT
+	if ( _baudRate )
+		Answer( "RDY\n+CFUN: 1\n+CPIN: " + _simState + ( _simState == "READY" ? "\nCall Ready" : "" ), _bootTime );
+}
+
+
+void SimModem::SetBootTime( const uint32_t & bootTime )
+{
+	_bootTime = bootTime;
+}
+
+
+void SimModem::SetSimState( const char * state )
+{
+	_simState = state;
+}
+
+
+void SimModem::SetDtr( const bool & high )
+{
+	_dtr = high;
+}
+
+
+bool SimModem::IsAsleep()
+{
+	if ( !_powered )
+		return false;
+
+	if ( _sleepMode == 1 )
+		return _dtr;
+
+	// It doesn't sleep while it sends
+	return _sleepMode == 2 && Now() >= std::max( _inputTime + (uint64_t) AUTO_SLEEP_TIME * 1000, _outputTime );
+}
+
+
+uint8_t SimModem::GetFunctionLevel()
+{
+	return _functionLevel;
+}
+
+
+uint32_t SimModem::Commands( const char * prefix )
+{
+	uint32_t count = 0;
+	size_t length = strlen( prefix );
+
+	for ( size_t i = 0; i < _commands.size(); i++ )
+		if ( !_commands[i].compare( 0, length, prefix ) )
+			count++;
+
+	return count;
+}
+
+
+const std::string & SimModem::GetTranscript()
+{
+	return _transcript;
+}
+
+
+void SimModem::ClearTranscript()
+{
+	_transcript.clear();
+	_commands.clear();
+}
+
+
+const std::string & SimModem::GetPostData()
+{
+	return _postData;
+}
+
+
+const std::string & SimModem::GetUserData()
+{
+	return _userData;
+}
+
+
+uint32_t SimModem::Pending()
+{
+	return _output.size();
+}
+
+
+unsigned long SimModem::Millis()
+{
+	return _now / 1000;
+}
+
+
+uint64_t SimModem::Micros()
+{
+	return _now;
+}
+
+
+void SimModem::Delay( unsigned long time )
+{
+	_now += (uint64_t) time * 1000;
+}
+
+
+void SimModem::Idle()
+{
+	uint64_t next = _now + 1000;
+
+	if ( _current )
+	{
+		std::deque<Byte> & output = _current->_output;
+		std::deque<Byte>::iterator arrived = std::upper_bound( output.begin(), output.end(), _now, ArrivesAfter() );
+
+		if ( arrived != output.end() && arrived->time < next )
+			next = arrived->time;
+	}
+
+	_now = next;
+}
+
+
+uint64_t SimModem::Now()
+{
+	struct timespec now;
+
+	if ( _virtualClock )
+		return _now;
+
+	clock_gettime( CLOCK_MONOTONIC, &now );
+	return (uint64_t) now.tv_sec * 1000000 + now.tv_nsec / 1000;
+}
+
+
+uint64_t SimModem::ByteTime( const uint32_t & baudRate )
+{
+	// Start bit, 8 data bits and stop bit
+	return baudRate ? 10000000ULL / baudRate : 0;
+}
+
+
+void SimModem::Receive( const uint8_t & c )
+{
+	// The LF after the CR of a command isn't data
+	bool lineFeed = _lineEnded && c == '\n';
+
+	_lineEnded = c == '\r';
+	if ( lineFeed )
+		return;
+
+	if ( _dataExpected )
+	{
+		_data += (char) c;
+		if ( --_dataExpected )
+			return;
+
+		_transcript += ">> " + _data + "\n";
+
+		if ( _socketData )
+		{
+			char answer[16];
+
+			snprintf( answer, sizeof( answer ), "%u, %s", _socketLink, _sendFailures ? "SEND FAIL" : "SEND OK" );
+			if ( _sendFailures )
+				_sendFailures--;
+			Answer( answer, _latency.data );
+		}
+		else
+		{
+			_postData = _data;
+			Answer( "OK", _latency.data );
+		}
+
+		_data.clear();
+		return;
+	}
+
+	if ( _echo )
+		Send( std::string( 1, (char) c ), 0 );
+
+	// Commands end with CR, the LF of println is skipped
+	if ( c == '\r' || c == '\n' )
+	{
+		if ( !_line.empty() )
+			Command( _line );
+
+		_line.clear();
+		return;
+	}
+
+	_line += (char) c;
+}
+
+
+void SimModem::Command( const std::string & line )
+{
+	std::string answer;
+	uint32_t delay = _latency.command;
+
+	_transcript += "> " + line + "\n";
+	_commands.push_back( line );
+
+	for ( size_t i = 0; i < _overrides.size(); i++ )
+	{
+		Override & override = _overrides[i];
+
+		if ( !override.count || line.compare( 0, override.prefix.size(), override.prefix ) )
+			continue;
+
+		override.count--;
+
+		if ( override.silent )
+			return;
+
+		if ( !override.answer.empty() )
+		{
+			Answer( override.answer, delay );
+			return;
+		}
+
+		delay += override.delay;
+		break;
+	}
+
+	Execute( line, answer, delay );
+
+	if ( !answer.empty() )
+		Answer( answer, delay );
+}
+
+
+void SimModem::Answer(	const std::string & lines,
+						const uint32_t & delay )
+{
+	std::string bytes;
+	size_t start = 0;
+
+	while ( start <= lines.size() )
+	{
+		size_t end = lines.find( '\n', start );
+
+		if ( end == std::string::npos )
+			end = lines.size();
+
+		bytes += "\r\n" + lines.substr( start, end - start ) + "\r\n";
+		start = end + 1;
+	}
+
+	Send( bytes, delay );
+}
+
+
+void SimModem::Send(	const std::string & bytes,
+						const uint32_t & delay )
+{
+	uint32_t baudRate = _baudRate ? _baudRate : _hostBaudRate;
+	uint64_t byteTime = ByteTime( baudRate );
+	uint64_t time = std::max( Now() + (uint64_t) delay * 1000, _outputTime );
+	bool garbled = _hostBaudRate && baudRate != _hostBaudRate;
+
+	for ( size_t i = 0; i < bytes.size(); i++ )
+	{
+		Byte byte = { time += byteTime, (uint8_t) bytes[i] };
+
+		// At another rate the host reads garbage
+		if ( garbled )
+			byte.value |= 0x80;
+
+		_output.push_back( byte );
+	}
+
+	_outputTime = time;
+
+	// Echo isn't logged. The format is the one of Transcript
+	if ( bytes.size() > 1 )
+	{
+		size_t start = 0;
+
+		while ( start < bytes.size() )
+		{
+			size_t end = bytes.find( "\r\n", start );
+
+			if ( end == std::string::npos )
+			{
+				_transcript += "<< " + bytes.substr( start ) + "\n";
+				break;
+			}
+
+			_transcript += end > start ? "< " + bytes.substr( start, end - start ) + "\n" : "<\n";
+			start = end + 2;
+		}
+	}
+}
+
+
+/** \brief Integer parameter of a command, after the first char of separators
+ */
+static long Parameter(	const std::string & line,
+						const char * separators,
+						const uint8_t & index = 0 )
+{
+	size_t position = 0;
+
+	for ( uint8_t i = 0; i <= index; i++ )
+	{
+		position = line.find_first_of( separators, position );
+		if ( position == std::string::npos )
+			return -1;
+		position++;
+	}
+
+	return strtol( line.c_str() + position, NULL, 10 );
+}
+
+
+static bool StartsWith(	const std::string & line,
+						const char * prefix )
+{
+	return !line.compare( 0, strlen( prefix ), prefix );
+}
+
+
+/** \brief String parameter of a command that starts at an offset, after its opening quote.
+ *		It ends at the next quote, like in the module, and \XX is the char of hex code XX.
+ */
+static std::string StringParameter(	const std::string & line,
+									size_t position )
+{
+	std::string value;
+
+	for ( ; position < line.size() && line[position] != '"'; position++ )
+	{
+		if ( line[position] == '\\' && position + 2 < line.size() )
+		{
+			value += (char) strtol( line.substr( position + 1, 2 ).c_str(), NULL, 16 );
+			position += 2;
+		}
+		else
+			value += line[position];
+	}
+
+	return value;
+}
+
+
+void SimModem::Execute(	const std::string & line,
+						std::string & answer,
+						uint32_t & delay )
+{
+	char text[64];
+
+	answer = "OK";
+
+	if ( line == "AT" || line == "AT&W" )
+		return;
+
+	if ( StartsWith( line, "AT+CPIN=" ) )
+	{
+		_simState = "READY";
+		return;
+	}
+
+	if ( StartsWith( line, "AT+CSCLK=" ) )
+	{
+		_sleepMode = Parameter( line, "=" );
+		return;
+	}
+
+	if ( line == "ATE0" || line == "ATE1" )
+	{
+		_echo = line == "ATE1";
+		return;
+	}
+
+	if ( line == "AT+CPIN?" )
+		answer = "+CPIN: " + _simState + "\nOK";
+	else if ( line == "AT+CREG?" )
+		answer = _functionLevel == 1 ? "+CREG: 0,1\nOK" : "+CREG: 0,0\nOK";
+	else if ( line == "AT+CGATT?" )
+		answer = _functionLevel == 1 ? "+CGATT: 1\nOK" : "+CGATT: 0\nOK";
+	else if ( line == "AT+SAPBR=2,1" )
+		answer = _bearerOpen ? "+SAPBR: 1,1,\"10.0.0.2\"\nOK" : "+SAPBR: 1,3,\"0.0.0.0\"\nOK";
+	else if ( line == "AT+SAPBR=1,1" )
+	{
+		delay += _latency.bearer;
+		if ( _bearerOpen || _functionLevel != 1 )
+			answer = "ERROR";
+		_bearerOpen = _functionLevel == 1;
+	}
+	else if ( line == "AT+SAPBR=0,1" )
+		_bearerOpen = false;
+	else if ( StartsWith( line, "AT+SAPBR=" ) )
+		;
+	else if ( StartsWith( line, "AT+CFUN=" ) )
+	{
+		_functionLevel = Parameter( line, "=" );
+		if ( _functionLevel != 1 )
+			_bearerOpen = _httpInitialized = false;
+	}
+	else if ( line == "AT+CPOWD=1" )
+	{
+		Answer( "NORMAL POWER DOWN", delay );
+		answer.clear();
+		SetPowered( false );
+	}
+	else if ( StartsWith( line, "AT+IPR=" ) )
+	{
+		// The answer goes at the old rate
+		Answer( answer, delay );
+		answer.clear();
+		_baudRate = Parameter( line, "=" );
+	}
+	else if ( line == "AT+HTTPINIT" )
+	{
+		if ( _httpInitialized )
+			answer = "ERROR";
+		_httpInitialized = true;
+	}
+	else if ( line == "AT+HTTPTERM" )
+	{
+		if ( !_httpInitialized )
+			answer = "ERROR";
+		_httpInitialized = false;
+	}
+	else if ( !_httpInitialized && StartsWith( line, "AT+HTTP" ) )
+		answer = "ERROR";
+	else if ( StartsWith( line, "AT+HTTPPARA=\"USERDATA\",\"" ) )
+		_userData = StringParameter( line, 24 );
+	else if ( StartsWith( line, "AT+HTTPPARA=" ) )
+		;
+	else if ( StartsWith( line, "AT+HTTPDATA=" ) )
+	{
+		_dataExpected = Parameter( line, "=" );
+		_socketData = false;
+		answer = "DOWNLOAD";
+		if ( !_dataExpected )
+		{
+			_postData.clear();
+			answer = "DOWNLOAD\nOK";
+		}
+	}
+	else if ( StartsWith( line, "AT+HTTPACTION=" ) )
+	{
+		long method = Parameter( line, "=" );
+
+		if ( !_bearerOpen )
+			snprintf( text, sizeof( text ), "+HTTPACTION:%ld,601,0", method );
+		else if ( method == 0 )
+			snprintf( text, sizeof( text ), "+HTTPACTION:0,%u,%u", _getReply, (unsigned) _getBody.size() );
+		else
+			snprintf( text, sizeof( text ), "+HTTPACTION:%ld,%u,0", method, _postReply );
+
+		Answer( answer, delay );
+		Answer( text, delay + _latency.action );
+		answer.clear();
+	}
+	else if ( StartsWith( line, "AT+HTTPREAD" ) )
+	{
+		long start = Parameter( line, "=" );
+		long size = Parameter( line, ",", 0 );
+		std::string data;
+
+		if ( start < 0 || size < 0 )
+			data = _getBody;
+		else if ( (size_t) start < _getBody.size() )
+			data = _getBody.substr( start, size );
+
+		snprintf( text, sizeof( text ), "\r\n+HTTPREAD:%u\r\n", (unsigned) data.size() );
+		Send( text + data + "\r\nOK\r\n", delay );
+		answer.clear();
+	}
+	else if ( line == "AT+HTTPHEAD" )
+	{
+		snprintf( text, sizeof( text ), "\r\n+HTTPHEAD:%u\r\n", (unsigned) _getHeaders.size() );
+		Send( text + _getHeaders + "\r\nOK\r\n", delay );
+		answer.clear();
+	}
+	else if ( line == "AT+CIPSHUT" )
+	{
+		_socketsOpen = 0;
+		answer = "SHUT OK";
+	}
+	else if ( line == "AT+CIPMUX=1" || StartsWith( line, "AT+CSTT=" ) || line == "AT+CIICR" )
+		;
+	else if ( line == "AT+CIFSR" )
+		answer = "10.0.0.3";
+	else if ( StartsWith( line, "AT+CIPSTART=" ) )
+	{
+		long link = Parameter( line, "=" );
+
+		if ( link < 0 || link >= SOCKET_LINKS )
+			answer = "ERROR";
+		else if ( IsSocketOpen( link ) )
+			answer = "ALREADY CONNECT";
+		else
+		{
+			snprintf( text, sizeof( text ), "%ld, CONNECT OK", link );
+			Answer( answer, delay );
+			Answer( text, delay + _latency.action );
+			answer.clear();
+			_socketsOpen |= 1 << link;
+		}
+	}
+	else if ( StartsWith( line, "AT+CIPSEND=" ) )
+	{
+		long link = Parameter( line, "=" );
+
+		if ( link < 0 || link >= SOCKET_LINKS || !IsSocketOpen( link ) )
+		{
+			answer = "ERROR";
+			return;
+		}
+
+		_socketLink = link;
+		_dataExpected = Parameter( line, "," );
+		_socketData = true;
+		Send( "\r\n> ", delay );
+		answer.clear();
+	}
+	else if ( StartsWith( line, "AT+CIPCLOSE=" ) )
+	{
+		long link = Parameter( line, "=" );
+
+		if ( link < 0 || link >= SOCKET_LINKS || !IsSocketOpen( link ) )
+			answer = "ERROR";
+		else
+		{
+			snprintf( text, sizeof( text ), "%ld, CLOSE OK", link );
+			answer = text;
+			_socketsOpen &= ~( 1 << link );
+		}
+	}
+	else
+		answer = "ERROR";
+}
+
+
+void SimModem::ApplyUrc( const std::string & line )
+{
+	if ( line == "+SAPBR 1: DEACT" || line == "+PDP: DEACT" )
+	{
+		_socketsOpen = 0;
+		_bearerOpen = false;
+		_httpInitialized = false;
+	}
+}
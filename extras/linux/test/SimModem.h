@@ -0,0 +1,317 @@
+/** SIM900 Basic communication library for SIM900 gsm module.
+ *
+ *	Simulated SIM900 for the host tests and benchmarks. It answers the AT commands the
+ *	library sends like a module with coverage, with configurable latencies and the pace
+ *	of the serial port, and keeps a transcript of the session.
+ *
+ *	Released under MIT license.
+ *
+ */
+#pragma once
+#ifndef __SimModem_h__
+#define __SimModem_h__
+
+#include "Arduino.h"
+
+#include <string>
+#include <deque>
+#include <vector>
+
+/** \brief Simulated module seen by the library as a HardwareSerial.
+ *
+ *	With the virtual clock the time only moves when the library waits ( Delay, Idle )
+ *	or writes to the port, so a session of minutes runs in milliseconds and gives the
+ *	same times in every run. Attach() gives the clock to a connection.
+ *	Without it the real clock is used, e.g. behind a pty ( PtyModem ).
+ */
+class SimModem : public HardwareSerial
+{
+public:
+	enum
+	{
+		// ms of the serial port idle before the module sleeps with AT+CSCLK=2
+		AUTO_SLEEP_TIME = 5000,
+
+		// Links of AT+CIPSTART
+		SOCKET_LINKS = 6,
+
+		// ms of PWRKEY high that turn the module on or off
+		POWER_KEY_TIME = 1000
+	};
+
+	/** \brief Times of the module (ms)
+	 */
+	struct Latency
+	{
+		uint32_t command;		// from a command to its answer
+		uint32_t action;		// from AT+HTTPACTION to +HTTPACTION, the time of the server
+		uint32_t data;			// from the last byte of HTTPDATA or CIPSEND data to its answer
+		uint32_t bearer;		// from AT+SAPBR=1,1 to OK
+	};
+
+	/** \brief Constructuor
+	 *
+	 *	@param	IN	true to use the virtual clock, false for the real one
+	 */
+	SimModem( const bool & virtualClock = true );
+
+	~SimModem();
+
+	/** \brief Rate of the host side of the port. 0 is a port without rate ( Stream constructor ).
+	 */
+	void begin( unsigned long baudRate );
+
+	int available();
+	int read();
+	int peek();
+	size_t write( uint8_t c );
+	size_t write(	const uint8_t * buffer,
+					size_t size );
+
+	using Print::write;
+
+	/** \brief Rate of the module. 0 is autobaud: it takes the rate of the first AT.
+	 *		The bytes sent at another rate are lost.
+	 */
+	void SetBaudRate( const uint32_t & baudRate );
+
+	uint32_t GetBaudRate();
+
+	void SetLatency( const Latency & latency );
+
+	/** \brief Reply of the next Get: http code, body and header lines for AT+HTTPHEAD
+	 */
+	void SetGetReply(	const uint16_t & httpReply,
+						const std::string & body,
+						const std::string & headers = "" );
+
+	/** \brief Http code of the next Post
+	 */
+	void SetPostReply( const uint16_t & httpReply );
+
+	/** \brief The next count commands that start with prefix get answer instead of the normal one.
+	 *		The lines of answer are separated by \n. NULL doesn't answer at all ( a stall ).
+	 */
+	void Fail(	const char * prefix,
+				const char * answer,
+				const uint16_t & count = 1 );
+
+	/** \brief The next commands that start with prefix are answered some ms later
+	 */
+	void Stall(	const char * prefix,
+				const uint32_t & time );
+
+	/** \brief Sends an unsolicited line after some ms. A DEACT closes the bearer, and the
+	 *		answers not started by then are lost with it.
+	 */
+	void SendUrc(	const char * line,
+					const uint32_t & delay = 0 );
+
+	/** \brief Sends bytes as they are after some ms, e.g. the data of a +RECEIVE
+	 */
+	void SendRaw(	const std::string & bytes,
+					const uint32_t & delay = 0 );
+
+	/** \brief The module terminates the HTTP service, like after an internal error
+	 */
+	void DropSession();
+
+	/** \brief The server closes the socket of a link after some ms: n, CLOSED
+	 */
+	void CloseSocket(	const uint8_t & link,
+						const uint32_t & delay = 0 );
+
+	/** \brief The data of the next count AT+CIPSEND is answered SEND FAIL
+	 */
+	void FailSend( const uint16_t & count = 1 );
+
+	/** \brief True if the socket of a link is connected
+	 */
+	bool IsSocketOpen( const uint8_t & link );
+
+	/** \brief Powers the module on or off. Off it doesn't answer.
+	 */
+	void SetPowered( const bool & powered );
+
+	/** \brief Level of the PWRKEY pin. A pulse of POWER_KEY_TIME turns the module on or
+	 *		off, like the power key of the SIM900.
+	 */
+	void SetPowerKey( const bool & high );
+
+	/** \brief ms from the power key pulse until the module answers. With a fixed rate it
+	 *		sends RDY, +CFUN: 1, +CPIN and Call Ready then, with autobaud nothing.
+	 */
+	void SetBootTime( const uint32_t & bootTime );
+
+	/** \brief State of the SIM for AT+CPIN?, READY by default. AT+CPIN= makes it READY.
+	 *		e.g. SIM PIN
+	 */
+	void SetSimState( const char * state );
+
+	/** \brief Level of the DTR pin of the module, low by default
+	 */
+	void SetDtr( const bool & high );
+
+	/** \brief True if the module sleeps: with AT+CSCLK=1 while DTR is high, with AT+CSCLK=2
+	 *		after AUTO_SLEEP_TIME without serial traffic. Asleep it drops what it receives,
+	 *		in AT+CSCLK=2 the first byte wakes it and the rest of its command is lost.
+	 */
+	bool IsAsleep();
+
+	/** \brief Functionality level of the last AT+CFUN. Out of 1 the radio is off: no
+	 *		network registration nor bearer.
+	 */
+	uint8_t GetFunctionLevel();
+
+	/** \brief Commands received that start with prefix
+	 */
+	uint32_t Commands( const char * prefix = "AT" );
+
+	/** \brief Session in the format of Transcript
+	 */
+	const std::string & GetTranscript();
+
+	void ClearTranscript();
+
+	/** \brief Data received with the last AT+HTTPDATA
+	 */
+	const std::string & GetPostData();
+
+	/** \brief Last value of AT+HTTPPARA="USERDATA"
+	 */
+	const std::string & GetUserData();
+
+	/** \brief Bytes waiting to be read by the host, arrived or not
+	 */
+	uint32_t Pending();
+
+	/** \brief Virtual clock: ms and us since the start of the program
+	 */
+	static unsigned long Millis();
+	static uint64_t Micros();
+
+	/** \brief Virtual delay
+	 */
+	static void Delay( unsigned long time );
+
+	/** \brief Idle callback: moves the virtual clock to the next byte of the module, 1 ms at most
+	 */
+	static void Idle();
+
+	/** \brief Gives the virtual clock to a connection
+	 */
+	template <class ConnectionType>
+	void Attach( ConnectionType & connection )
+	{
+		connection.SetClock( Millis, Delay );
+		connection.SetIdleCallback( Idle );
+	}
+
+protected:
+	struct Override
+	{
+		std::string prefix;
+		std::string answer;
+		bool silent;
+		uint32_t delay;
+		uint16_t count;
+	};
+
+	/** \brief Time of the clock of this module, virtual or real (us)
+	 */
+	uint64_t Now();
+
+	/** \brief us to send a byte at a rate, 0 without rate
+	 */
+	static uint64_t ByteTime( const uint32_t & baudRate );
+
+	/** \brief Handles a byte sent by the host
+	 */
+	void Receive( const uint8_t & c );
+
+	/** \brief Handles a complete command line
+	 */
+	void Command( const std::string & line );
+
+	/** \brief Queues lines of the module, each one between CR LF, after delay ms
+	 */
+	void Answer(	const std::string & lines,
+					const uint32_t & delay );
+
+	/** \brief Queues bytes of the module after delay ms, at the rate of the port
+	 */
+	void Send(	const std::string & bytes,
+				const uint32_t & delay );
+
+	/** \brief Normal answer of a command
+	 *
+	 *	@param	IN	command line
+	 *	@param	OUT	lines of the answer
+	 *	@param	OUT	ms until the answer
+	 */
+	void Execute(	const std::string & line,
+					std::string & answer,
+					uint32_t & delay );
+
+	/** \brief Applies the effects of an unsolicited line on the module state
+	 */
+	void ApplyUrc( const std::string & line );
+
+	/** \brief Drops the output that starts after a time (us)
+	 */
+	void DropOutput( const uint64_t & time );
+
+private:
+	struct Byte
+	{
+		uint64_t time;
+		uint8_t value;
+	};
+
+	bool _virtualClock;
+	uint32_t _hostBaudRate;
+	uint32_t _baudRate;
+	Latency _latency;
+
+	std::deque<Byte> _output;
+	uint64_t _outputTime;		// when the last byte queued arrives
+
+	std::string _line;
+	bool _lineEnded;
+	uint32_t _dataExpected;		// raw bytes expected after DOWNLOAD or >
+	bool _socketData;
+	uint8_t _socketLink;
+	uint8_t _socketsOpen;		// a bit per link
+	uint16_t _sendFailures;
+	std::string _data;
+
+	bool _powered;
+	bool _powerKey;
+	uint64_t _powerKeyTime;		// when PWRKEY went high
+	uint32_t _bootTime;
+	uint64_t _readyTime;		// end of the boot, nothing is received before
+	std::string _simState;
+	uint8_t _sleepMode;			// of AT+CSCLK
+	bool _dtr;
+	bool _waking;				// the rest of the command that woke it is lost
+	uint64_t _inputTime;		// when the last byte from the host arrived
+	uint8_t _functionLevel;
+	bool _bearerOpen;
+	bool _httpInitialized;
+	bool _echo;
+	uint16_t _getReply;
+	std::string _getBody;
+	std::string _getHeaders;
+	uint16_t _postReply;
+	std::string _postData;
+	std::string _userData;
+
+	std::vector<Override> _overrides;
+	std::vector<std::string> _commands;
+	std::string _transcript;
+
+	static uint64_t _now;
+	static SimModem * _current;
+};
+
+#endif
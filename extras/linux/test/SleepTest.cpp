@@ -0,0 +1,144 @@
+/** SIM900 Basic communication library for SIM900 gsm module.
+ *
+ *	Sleep and power states against the simulated module:
+ *		- SLEEP_AUTO: the module sleeps when the port is idle, the next Get wakes it, the
+ *		  first probe is lost and AT+CSCLK=0 is sent after the wake
+ *		- SLEEP_DTR: the DTR pin puts the module to sleep and wakes it, without probes lost
+ *		- the wake latency and the time awake and asleep of GetPowerStats()
+ *		- FUNCTION_FLIGHT drops the bearer and the requests fail until FUNCTION_FULL
+ *		- PowerOff() forgets the session, the bearer and the sleep mode
+ *
+ *	Released under MIT license.
+ *
+ */
+#include "SIM900.h"
+#include "SimModem.h"
+#include "Check.h"
+
+#include <stdio.h>
+
+static const uint8_t DTR_PIN = 7;
+static const unsigned long ASLEEP_TIME = 60000;
+static const unsigned long AWAKE_TIME = 1000;
+
+static SimModem * dtrModem = NULL;
+
+
+/** \brief The DTR pin of the Arduino is wired to the simulated module
+ */
+static void WritePin(	uint8_t pin,
+						uint8_t value )
+{
+	if ( pin == DTR_PIN && dtrModem )
+		dtrModem->SetDtr( value == HIGH );
+}
+
+
+static bool Get( Connection & sim )
+{
+	char body[64];
+	uint16_t bodyLength;
+	uint16_t httpReply;
+
+	return sim.Get( "www.example.com", "api", "file", httpReply, body, sizeof( body ), bodyLength ) && httpReply == 200;
+}
+
+
+int main()
+{
+	SimModem modem;
+	Connection sim( "1234", "internet", "", "", 2, (HardwareSerial &) modem, 115200 );
+
+	dtrModem = &modem;
+	pinWriter = WritePin;
+	modem.Attach( sim );
+	modem.SetGetReply( 200, "{\"hour\":10}" );
+	CHECK( sim.Configuration() );
+
+	// SLEEP_AUTO: asleep once the port is idle, the Get wakes it
+	CHECK( sim.Sleep( ConnectionBase::SLEEP_AUTO ) );
+	CHECK( sim.IsSleeping() );
+	CHECK( !modem.IsAsleep() );
+	SimModem::Delay( ASLEEP_TIME );
+	CHECK( modem.IsAsleep() );
+
+	modem.ClearTranscript();
+	CHECK( Get( sim ) );
+	CHECK( !sim.IsSleeping() );
+	CHECK( modem.Commands( "AT+CSCLK=0" ) == 1 );
+	CHECK( modem.Commands( "AT+HTTPACTION" ) == 1 );
+
+	const ConnectionBase::PowerStats & stats = sim.GetPowerStats();
+
+	CHECK( stats.wakes == 1 );
+	CHECK( stats.lastWakeTime >= DefaultConnectionPolicy::WAKE_PROBE_INTERVAL );
+	CHECK( stats.lastWakeTime < 2 * DefaultConnectionPolicy::WAKE_PROBE_INTERVAL );
+	CHECK( stats.sleepTime >= ASLEEP_TIME && stats.sleepTime < ASLEEP_TIME + 10 );
+	CHECK( stats.awakeTime == 0 );
+
+	// The module stays awake in SLEEP_NONE however long the port is idle
+	SimModem::Delay( ASLEEP_TIME );
+	CHECK( !modem.IsAsleep() );
+	SimModem::Delay( AWAKE_TIME );
+
+	// SLEEP_DTR: no probe is lost, the wake costs the DTR time
+	sim.SetDtrPin( DTR_PIN );
+	CHECK( sim.Sleep( ConnectionBase::SLEEP_DTR ) );
+	CHECK( modem.IsAsleep() );
+	CHECK( stats.lastAwakeTime >= ASLEEP_TIME + AWAKE_TIME );
+	CHECK( stats.awakeTime == stats.lastAwakeTime );
+
+	uint32_t sleepTime = stats.sleepTime;
+
+	SimModem::Delay( ASLEEP_TIME );
+	modem.ClearTranscript();
+	CHECK( Get( sim ) );
+	CHECK( !modem.IsAsleep() );
+	CHECK( stats.wakes == 2 );
+	CHECK( stats.lastWakeTime >= DefaultConnectionPolicy::WAKE_DTR_TIME );
+	CHECK( stats.lastWakeTime < DefaultConnectionPolicy::WAKE_DTR_TIME + DefaultConnectionPolicy::WAKE_PROBE_INTERVAL );
+	CHECK( stats.maxWakeTime >= stats.lastWakeTime );
+	CHECK( stats.sleepTime - sleepTime >= ASLEEP_TIME );
+	CHECK( modem.Commands( "AT" ) == modem.Commands( "AT+" ) + 1 );
+	CHECK( modem.Commands( "AT+CSCLK" ) == 0 );
+
+	// The mode is kept, the next sleep only raises DTR
+	CHECK( sim.Sleep( ConnectionBase::SLEEP_DTR ) );
+	CHECK( modem.Commands( "AT+CSCLK" ) == 0 );
+	CHECK( sim.Wake() );
+	CHECK( sim.Sleep( ConnectionBase::SLEEP_NONE ) );
+	CHECK( modem.Commands( "AT+CSCLK=0" ) == 1 );
+
+	// Flight mode: no bearer until the radio is on again
+	CHECK( sim.SetFunctionLevel( ConnectionBase::FUNCTION_FLIGHT ) );
+	CHECK( modem.GetFunctionLevel() == ConnectionBase::FUNCTION_FLIGHT );
+	CHECK( !Get( sim ) );
+	CHECK( sim.SetFunctionLevel( ConnectionBase::FUNCTION_FULL ) );
+	CHECK( modem.GetFunctionLevel() == ConnectionBase::FUNCTION_FULL );
+	CHECK( Get( sim ) );
+
+	// PowerOff() wakes the module to turn it off and forgets its state
+	CHECK( sim.BeginSession() );
+	CHECK( sim.Sleep( ConnectionBase::SLEEP_AUTO ) );
+	SimModem::Delay( ASLEEP_TIME );
+	modem.ClearTranscript();
+	sim.PowerOff();
+	CHECK( modem.Commands( "AT+CPOWD=1" ) == 1 );
+	CHECK( !sim.IsSleeping() );
+	CHECK( !sim.IsSessionOpen() );
+
+	// Powered again the module has no slow clock nor HTTP service, the connection knows it
+	modem.SetPowered( true );
+	modem.ClearTranscript();
+	CHECK( Get( sim ) );
+	CHECK( modem.Commands( "AT+SAPBR=1,1" ) == 1 );
+	CHECK( modem.Commands( "AT+HTTPINIT" ) == 1 );
+	CHECK( modem.Commands( "AT+HTTPTERM" ) == 1 );
+	CHECK( sim.Sleep( ConnectionBase::SLEEP_AUTO ) );
+	CHECK( modem.Commands( "AT+CSCLK=2" ) == 1 );
+
+	printf( "SleepTest: wakes %u, last wake %u ms, max %u ms, awake %u ms, asleep %u ms\n", stats.wakes,
+			stats.lastWakeTime, stats.maxWakeTime, stats.awakeTime, stats.sleepTime );
+
+	return CheckResult( "SleepTest" );
+}
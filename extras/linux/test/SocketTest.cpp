@@ -0,0 +1,101 @@
+/** SIM900 Basic communication library for SIM900 gsm module.
+ *
+ *	Sockets against the simulated module:
+ *		- AT+CIPSTART answered CONNECT OK and CONNECT FAIL
+ *		- AT+CIPSEND with its > prompt, answered SEND OK and SEND FAIL
+ *		- AT+CIPCLOSE
+ *		- a link closed by the server ( n, CLOSED ) is free again
+ *		- only SOCKET_LINKS sockets are open at once
+ *
+ *	Released under MIT license.
+ *
+ */
+#include "SIM900.h"
+#include "SimModem.h"
+#include "Check.h"
+
+#include <stdio.h>
+#include <string>
+
+static int closedCodes = 0;
+
+
+static void OnUrc(	ConnectionBase::UrcCode code,
+					const char * /* line */,
+					void * /* context */ )
+{
+	if ( code == ConnectionBase::URC_SOCKET_CLOSED )
+		closedCodes++;
+}
+
+
+static int8_t Open( Connection & sim )
+{
+	return sim.SocketOpen( ConnectionBase::SOCKET_TCP, "www.example.com", 80 );
+}
+
+
+int main()
+{
+	SimModem modem;
+	Connection sim( "1234", "internet", "", "", 2, (HardwareSerial &) modem, 115200 );
+	const char data[] = "{\"temperature\":21.5}";
+
+	modem.Attach( sim );
+	sim.SetUrcCallback( OnUrc );
+	CHECK( sim.Configuration() );
+
+	// CONNECT OK
+	CHECK( Open( sim ) == 0 );
+	CHECK( sim.IsSocketOpen( 0 ) );
+	CHECK( modem.IsSocketOpen( 0 ) );
+	CHECK( modem.Commands( "AT+CIPSTART=0,\"TCP\",\"www.example.com\",\"80\"" ) == 1 );
+
+	// CONNECT FAIL: the link stays free
+	modem.Fail( "AT+CIPSTART=1", "OK\n1, CONNECT FAIL" );
+	CHECK( Open( sim ) == -1 );
+	CHECK( !sim.IsSocketOpen( 1 ) );
+	CHECK( Open( sim ) == 1 );
+
+	// SEND OK after the prompt, then SEND FAIL
+	modem.ClearTranscript();
+	CHECK( sim.SocketSend( 0, data, sizeof( data ) - 1 ) );
+	CHECK( modem.Commands( "AT+CIPSEND=0,20" ) == 1 );
+	CHECK( modem.GetTranscript().find( std::string( ">> " ) + data ) != std::string::npos );
+
+	modem.FailSend();
+	CHECK( !sim.SocketSend( 1, data, sizeof( data ) - 1 ) );
+	CHECK( sim.SocketSend( 1, data, sizeof( data ) - 1 ) );
+
+	// CIPCLOSE frees the link in both sides, a closed link can't send nor close
+	CHECK( sim.SocketClose( 1 ) );
+	CHECK( !sim.IsSocketOpen( 1 ) );
+	CHECK( !modem.IsSocketOpen( 1 ) );
+	CHECK( !sim.SocketClose( 1 ) );
+	CHECK( !sim.SocketSend( 1, data, sizeof( data ) - 1 ) );
+
+	// Up to SOCKET_LINKS sockets, the next one isn't tried
+	for ( uint8_t i = 1; i < ConnectionBase::SOCKET_LINKS; i++ )
+		CHECK( Open( sim ) == i );
+
+	modem.ClearTranscript();
+	CHECK( Open( sim ) == -1 );
+	CHECK( modem.Commands( "AT+CIPSTART" ) == 0 );
+
+	// The server closes a link: it is free when its code is read
+	modem.CloseSocket( 3, 100 );
+	SimModem::Delay( 200 );
+	sim.ProcessUrcs();
+	CHECK( closedCodes == 1 );
+	CHECK( !sim.IsSocketOpen( 3 ) );
+	CHECK( sim.IsSocketOpen( 2 ) && sim.IsSocketOpen( 4 ) );
+	CHECK( Open( sim ) == 3 );
+	CHECK( sim.SocketSend( 3, data, sizeof( data ) - 1 ) );
+
+	// StartSockets() shuts them all
+	CHECK( sim.StartSockets() );
+	for ( uint8_t i = 0; i < ConnectionBase::SOCKET_LINKS; i++ )
+		CHECK( !sim.IsSocketOpen( i ) && !modem.IsSocketOpen( i ) );
+
+	return CheckResult( "SocketTest" );
+}
@@ -0,0 +1,96 @@
+/** SIM900 Basic communication library for SIM900 gsm module.
+ *
+ *	Throughput of a Get of 64 KB read in AT+HTTPREAD windows into a sink, against the
+ *	simulated module at 115200 baud, blocking and with Poll(). A window costs a command
+ *	round trip, so small windows lose throughput and large ones need a large Serial
+ *	buffer. The sink gets chunks of BODY_CHUNK_SIZE at most whatever the window. The
+ *	bytes/s are of the virtual clock, from the first command to the end.
+ *
+ *	Released under MIT license.
+ *
+ */
+#include "SIM900.h"
+#include "SimModem.h"
+
+#include <stdio.h>
+#include <string>
+
+static const uint32_t BODY_SIZE = 65536;
+static const SimModem::Latency LATENCY = { 20, 500, 50, 300 };
+
+
+/** \brief Sink that only counts the body
+ */
+struct Counter
+{
+	uint32_t bytes;
+	uint16_t largestChunk;
+};
+
+
+static bool Count(	const char * /* chunk */,
+					uint16_t length,
+					void * context )
+{
+	Counter * counter = (Counter *) context;
+
+	counter->bytes += length;
+	if ( length > counter->largestChunk )
+		counter->largestChunk = length;
+
+	return true;
+}
+
+
+/** \brief bytes/s of a Get read in windows of a size
+ *
+ *	@return	false if the body isn't complete or isn't passed in chunks of BODY_CHUNK_SIZE
+ */
+static bool Measure(	const uint16_t & window,
+						const bool & async )
+{
+	SimModem modem;
+	Connection sim( "1234", "internet", "", "", 2, (HardwareSerial &) modem, 115200 );
+	Counter counter = { 0, 0 };
+	uint16_t httpReply;
+
+	modem.Attach( sim );
+	modem.SetLatency( LATENCY );
+	modem.SetGetReply( 200, std::string( BODY_SIZE, 'x' ) );
+	sim.Configuration();
+	sim.SetReadWindow( window );
+	modem.ClearTranscript();
+
+	uint64_t start = SimModem::Micros();
+
+	if ( async )
+	{
+		sim.StartGet( "www.example.com", "api", "file", Count, NULL, &counter );
+		while ( sim.Poll() == ConnectionBase::REQUEST_RUNNING )
+			SimModem::Idle();
+	}
+	else
+		sim.Get( "www.example.com", "api", "file", httpReply, Count, &counter );
+
+	double seconds = ( SimModem::Micros() - start ) / 1e6;
+
+	printf( "%-8s window %5u: %9.0f bytes/s %5u HTTPREAD, largest chunk %u\n", async ? "Poll" : "Get",
+			window, counter.bytes / seconds, modem.Commands( "AT+HTTPREAD" ), counter.largestChunk );
+
+	return counter.bytes == BODY_SIZE && counter.largestChunk == DefaultConnectionPolicy::BODY_CHUNK_SIZE;
+}
+
+
+int main()
+{
+	const uint16_t windows[] = { 32, 64, 100, 256, 512, 1024 };
+	bool complete = true;
+
+	printf( "ThroughputBench: Get of %u B at 115200 baud, line rate %u bytes/s\n", BODY_SIZE, 115200 / 10 );
+
+	for ( uint8_t async = 0; async < 2; async++ )
+		for ( uint8_t i = 0; i < sizeof( windows ) / sizeof( windows[0] ); i++ )
+			complete &= Measure( windows[i], async );
+
+	return complete ? 0 : 1;
+}
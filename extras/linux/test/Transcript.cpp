@@ -0,0 +1,87 @@
+/** SIM900 Basic communication library for SIM900 gsm module.
+ *
+ *	Transcripts of sessions with the module.
+ *
+ *	Released under MIT license.
+ *
+ */
+#include "Transcript.h"
+
+#include <fstream>
+#include <sstream>
+#include <stdlib.h>
+
+
+bool Transcript::Load( const char * path )
+{
+	std::ifstream file( path );
+	std::stringstream text;
+
+	if ( !file )
+		return false;
+
+	text << file.rdbuf();
+	Parse( text.str() );
+	return true;
+}
+
+
+void Transcript::Parse( const std::string & text )
+{
+	std::istringstream lines( text );
+	std::string line;
+
+	while ( std::getline( lines, line ) )
+	{
+		if ( !line.empty() && line[line.size() - 1] == '\r' )
+			line.erase( line.size() - 1 );
+
+		if ( line.compare( 0, 2, ">>" ) == 0 )
+		{
+			Exchange exchange = { line.substr( line.size() > 2 ? 3 : 2 ), "" };
+			_exchanges.push_back( exchange );
+		}
+		else if ( line.compare( 0, 1, ">" ) == 0 )
+		{
+			Exchange exchange = { line.substr( line.size() > 1 ? 2 : 1 ) + "\r\n", "" };
+			_exchanges.push_back( exchange );
+		}
+		else if ( line.compare( 0, 1, "<" ) == 0 )
+		{
+			// The module can talk before the first command: boot messages, URCs
+			if ( _exchanges.empty() )
+				_exchanges.push_back( Exchange() );
+
+			if ( line.compare( 0, 2, "<<" ) == 0 )
+				_exchanges.back().reply += line.substr( line.size() > 2 ? 3 : 2 );
+			else
+				_exchanges.back().reply += line.substr( line.size() > 1 ? 2 : 1 ) + "\r\n";
+		}
+	}
+}
+
+
+const std::vector<Exchange> & Transcript::GetExchanges() const
+{
+	return _exchanges;
+}
+
+
+std::string Transcript::GetReplies() const
+{
+	std::string replies;
+
+	for ( size_t i = 0; i < _exchanges.size(); i++ )
+		replies += _exchanges[i].reply;
+
+	return replies;
+}
+
+
+std::string Transcript::Directory()
+{
+	// The tests run from extras/linux, see the Makefile
+	const char * directory = getenv( "TRANSCRIPTS" );
+
+	return directory ? directory : "test/transcripts";
+}
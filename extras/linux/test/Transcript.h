@@ -0,0 +1,58 @@
+/** SIM900 Basic communication library for SIM900 gsm module.
+ *
+ *	Transcripts of sessions with the module, for the replay tests and benchmarks.
+ *
+ *	A transcript is text with a prefix in every line:
+ *		> text		command line sent by the host, CR LF added
+ *		>> text		data sent by the host as it is ( HTTPDATA, CIPSEND )
+ *		< text		line sent by the module, CR LF added. A lone < is an empty line
+ *		<< text		bytes sent by the module without CR LF, e.g. the > prompt
+ *		# text		comment
+ *
+ *	Released under MIT license.
+ *
+ */
+#pragma once
+#ifndef __Transcript_h__
+#define __Transcript_h__
+
+#include <string>
+#include <vector>
+
+/** \brief A command of the host and the bytes the module sent after it
+ */
+struct Exchange
+{
+	std::string command;
+	std::string reply;
+};
+
+
+class Transcript
+{
+public:
+	/** \brief Reads a transcript file
+	 *
+	 *	@return	false if it can't be read
+	 */
+	bool Load( const char * path );
+
+	/** \brief Reads a transcript from text
+	 */
+	void Parse( const std::string & text );
+
+	const std::vector<Exchange> & GetExchanges() const;
+
+	/** \brief Bytes sent by the module in the whole session
+	 */
+	std::string GetReplies() const;
+
+	/** \brief Directory of the transcripts of the tests
+	 */
+	static std::string Directory();
+
+private:
+	std::vector<Exchange> _exchanges;
+};
+
+#endif
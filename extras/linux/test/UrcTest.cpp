@@ -0,0 +1,116 @@
+/** SIM900 Basic communication library for SIM900 gsm module.
+ *
+ *	Time to recovery after a link loss during AT+HTTPACTION:
+ *		- replay of transcripts/urc.txt: the +PDP: DEACT ends the wait for +HTTPACTION
+ *		  without waiting for its timeout
+ *		- simulated module with a server slower than HTTPACTION_TIMEOUT: the asynchronous
+ *		  Get fails when the DEACT arrives, the URC reaches the callback and the next Get
+ *		  opens the bearer again, all well before the timeout
+ *
+ *	Released under MIT license.
+ *
+ */
+#include "SIM900.h"
+#include "SimModem.h"
+#include "Transcript.h"
+#include "ReplayStream.h"
+#include "Check.h"
+
+#include <stdio.h>
+#include <string>
+
+static const SimModem::Latency SLOW_SERVER = { 20, 2 * DefaultConnectionPolicy::HTTPACTION_TIMEOUT, 50, 300 };
+static const SimModem::Latency LATENCY = { 20, 500, 50, 300 };
+static const uint32_t URC_DELAY = 100;
+
+static int deacts = 0;
+
+
+static void OnUrc(	ConnectionBase::UrcCode code,
+					const char * /* line */,
+					void * /* context */ )
+{
+	if ( code == ConnectionBase::URC_BEARER_DEACT )
+		deacts++;
+}
+
+
+/** \brief ms of the replay of the answer to AT+HTTPACTION=0 in urc.txt
+ */
+static unsigned long ReplayDeact()
+{
+	Transcript transcript;
+
+	if ( !transcript.Load( ( Transcript::Directory() + "/urc.txt" ).c_str() ) )
+		return DefaultConnectionPolicy::HTTPACTION_TIMEOUT;
+
+	const std::vector<Exchange> & exchanges = transcript.GetExchanges();
+
+	for ( size_t i = 0; i < exchanges.size(); i++ )
+	{
+		if ( exchanges[i].command.compare( 0, 15, "AT+HTTPACTION=0" ) )
+			continue;
+
+		ReplayStream stream;
+		ReplayConnection sim( stream );
+		unsigned long start = ReplayStream::Millis();
+
+		if ( sim.HttpAction( (const uint8_t *) exchanges[i].reply.data(), exchanges[i].reply.size() ) )
+			break;
+
+		return ReplayStream::Millis() - start;
+	}
+
+	return DefaultConnectionPolicy::HTTPACTION_TIMEOUT;
+}
+
+
+int main()
+{
+	unsigned long replayTime = ReplayDeact();
+
+	CHECK( replayTime < DefaultConnectionPolicy::HTTPACTION_TIMEOUT / 10 );
+
+	SimModem modem;
+	Connection sim( "1234", "internet", "", "", 2, (HardwareSerial &) modem, 115200 );
+	char body[64];
+	uint16_t bodyLength;
+	uint16_t httpReply;
+
+	modem.Attach( sim );
+	modem.SetLatency( SLOW_SERVER );
+	modem.SetGetReply( 200, "{\"hour\":10}" );
+	sim.SetUrcCallback( OnUrc );
+	CHECK( sim.Configuration() );
+
+	// The link is lost while the server is answering
+	CHECK( sim.StartGet( "www.example.com", "api", "file", NULL ) );
+	while ( !modem.Commands( "AT+HTTPACTION" ) && sim.Poll() == ConnectionBase::REQUEST_RUNNING )
+		SimModem::Idle();
+
+	unsigned long deact = SimModem::Millis() + URC_DELAY;
+
+	modem.SendUrc( "+PDP: DEACT", URC_DELAY );
+	while ( sim.Poll() == ConnectionBase::REQUEST_RUNNING )
+		SimModem::Idle();
+
+	unsigned long failureTime = SimModem::Millis() - deact;
+
+	CHECK( sim.GetRequestStatus() == ConnectionBase::REQUEST_FAILED );
+	sim.ProcessUrcs();
+	CHECK( deacts == 1 );
+
+	// The next request opens the bearer again
+	modem.SetLatency( LATENCY );
+	CHECK( sim.Get( "www.example.com", "api", "file", httpReply, body, sizeof( body ), bodyLength ) );
+	CHECK( httpReply == 200 );
+
+	unsigned long recoveryTime = SimModem::Millis() - deact;
+
+	CHECK( failureTime < DefaultConnectionPolicy::HTTPACTION_TIMEOUT / 10 );
+	CHECK( recoveryTime < DefaultConnectionPolicy::HTTPACTION_TIMEOUT );
+	printf( "UrcTest: replay %lu ms, request failed %lu ms and recovered %lu ms after the DEACT, timeout %u ms\n",
+			replayTime, failureTime, recoveryTime, DefaultConnectionPolicy::HTTPACTION_TIMEOUT );
+
+	return CheckResult( "UrcTest" );
+}
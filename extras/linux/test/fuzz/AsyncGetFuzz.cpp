@@ -0,0 +1,24 @@
+/** SIM900 Basic communication library for SIM900 gsm module.
+ *
+ *	Fuzz target: the answers of an asynchronous Get after AT+HTTPACTION=0 through Poll().
+ *
+ *	Released under MIT license.
+ *
+ */
+#include "ReplayStream.h"
+
+#include <stdlib.h>
+
+
+extern "C" int LLVMFuzzerTestOneInput(	const uint8_t * data,
+										size_t size )
+{
+	ReplayStream stream;
+	ReplayConnection sim( stream );
+
+	// The request always ends, with the input or with a timeout
+	if ( sim.AsyncGet( data, size ) == ConnectionBase::REQUEST_RUNNING )
+		abort();
+
+	return 0;
+}
@@ -0,0 +1,24 @@
+/** SIM900 Basic communication library for SIM900 gsm module.
+ *
+ *	Fuzz target: any answer of the module through MatchATReply.
+ *
+ *	Released under MIT license.
+ *
+ */
+#include "ReplayStream.h"
+
+#include <stdlib.h>
+
+
+extern "C" int LLVMFuzzerTestOneInput(	const uint8_t * data,
+										size_t size )
+{
+	static ReplayStream stream;
+	static ReplayConnection sim( stream );
+
+	// An answer is found only after its last char is read
+	if ( sim.AtReply( data, size ) && stream.Pending() >= size )
+		abort();
+
+	return 0;
+}
@@ -0,0 +1,175 @@
+/** SIM900 Basic communication library for SIM900 gsm module.
+ *
+ *	Driver of the fuzz targets without libFuzzer, linked when the compiler doesn't have
+ *	-fsanitize=fuzzer. With files or directories as arguments it runs the target on every
+ *	file, e.g. a corpus or a crash found by libFuzzer. Without them it runs the replies
+ *	of the transcripts and random mutations of them, always the same ones.
+ *
+ *	Released under MIT license.
+ *
+ */
+#include "Transcript.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <dirent.h>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+extern "C" int LLVMFuzzerTestOneInput(	const uint8_t * data,
+										size_t size );
+
+static const uint32_t MUTATIONS = 20000;
+static const size_t MAX_INPUT_SIZE = 4096;
+
+
+static void Run( const std::string & input )
+{
+	// A copy of the exact size, so the sanitizers see a read past the input
+	std::vector<uint8_t> data( input.begin(), input.end() );
+
+	LLVMFuzzerTestOneInput( data.empty() ? NULL : &data[0], data.size() );
+}
+
+
+static bool RunFile( const std::string & path )
+{
+	std::ifstream file( path.c_str(), std::ios::binary );
+	std::stringstream input;
+
+	if ( !file )
+		return false;
+
+	input << file.rdbuf();
+	Run( input.str() );
+	return true;
+}
+
+
+/** \brief Runs a file or every file of a directory
+ *
+ *	@return	number of inputs run
+ */
+static uint32_t RunPath( const char * path )
+{
+	DIR * directory = opendir( path );
+	uint32_t inputs = 0;
+
+	if ( !directory )
+		return RunFile( path ) ? 1 : 0;
+
+	while ( struct dirent * entry = readdir( directory ) )
+		if ( entry->d_name[0] != '.' && RunFile( std::string( path ) + "/" + entry->d_name ) )
+			inputs++;
+
+	closedir( directory );
+	return inputs;
+}
+
+
+/** \brief Changes some bytes of an input: the kinds of damage of a noisy serial line and of
+ *		a module that answers something unexpected
+ */
+static std::string Mutate( std::string input )
+{
+	static const char * pieces[] = { "\r\n", "OK", "ERROR", ",", ":", " ", "0", "65535", "4294967296", "+HTTPACTION:0,", "+HTTPREAD:", "+RECEIVE,0," };
+	int changes = 1 + rand() % 4;
+
+	for ( int i = 0; i < changes; i++ )
+	{
+		size_t position = input.empty() ? 0 : rand() % ( input.size() + 1 );
+
+		switch ( rand() % 5 )
+		{
+			case 0:
+				if ( position < input.size() )
+					input[position] = rand() % 256;
+				break;
+
+			case 1:
+				input.erase( position, rand() % 8 );
+				break;
+
+			case 2:
+				input.insert( position, pieces[rand() % ( sizeof( pieces ) / sizeof( pieces[0] ) )] );
+				break;
+
+			case 3:
+				input.insert( position, input.substr( rand() % ( input.size() + 1 ), rand() % 32 ) );
+				break;
+
+			default:
+				input.resize( position );
+				break;
+		}
+	}
+
+	if ( input.size() > MAX_INPUT_SIZE )
+		input.resize( MAX_INPUT_SIZE );
+
+	return input;
+}
+
+
+/** \brief Replies of the transcripts, one seed per reply
+ */
+static std::vector<std::string> Seeds()
+{
+	const char * files[] = { "configuration-get.txt", "post.txt", "urc.txt", "socket.txt" };
+	std::vector<std::string> seeds;
+
+	for ( size_t i = 0; i < sizeof( files ) / sizeof( files[0] ); i++ )
+	{
+		Transcript transcript;
+
+		if ( !transcript.Load( ( Transcript::Directory() + "/" + files[i] ).c_str() ) )
+			continue;
+
+		const std::vector<Exchange> & exchanges = transcript.GetExchanges();
+
+		for ( size_t j = 0; j < exchanges.size(); j++ )
+			if ( !exchanges[j].reply.empty() )
+				seeds.push_back( exchanges[j].reply );
+	}
+
+	return seeds;
+}
+
+
+int main(	int argc,
+			char ** argv )
+{
+	const char * name = strrchr( argv[0], '/' ) ? strrchr( argv[0], '/' ) + 1 : argv[0];
+	uint32_t inputs = 0;
+
+	if ( argc > 1 )
+	{
+		for ( int i = 1; i < argc; i++ )
+			inputs += RunPath( argv[i] );
+
+		printf( "%s: %u inputs\n", name, inputs );
+		return 0;
+	}
+
+	std::vector<std::string> seeds = Seeds();
+
+	if ( seeds.empty() )
+	{
+		printf( "%s: no transcripts in %s\n", name, Transcript::Directory().c_str() );
+		return 1;
+	}
+
+	srand( 1 );
+
+	for ( size_t i = 0; i < seeds.size(); i++ )
+		Run( seeds[i] );
+
+	for ( uint32_t i = 0; i < MUTATIONS; i++ )
+		Run( Mutate( seeds[rand() % seeds.size()] ) );
+
+	printf( "%s: %u seeds, %u mutations\n", name, (unsigned) seeds.size(), MUTATIONS );
+	return 0;
+}
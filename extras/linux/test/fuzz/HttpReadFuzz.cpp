@@ -0,0 +1,20 @@
+/** SIM900 Basic communication library for SIM900 gsm module.
+ *
+ *	Fuzz target: the answer to AT+HTTPREAD through ReceiveATReply and GetReceiveDataSize.
+ *
+ *	Released under MIT license.
+ *
+ */
+#include "ReplayStream.h"
+
+
+extern "C" int LLVMFuzzerTestOneInput(	const uint8_t * data,
+										size_t size )
+{
+	static ReplayStream stream;
+	static ReplayConnection sim( stream );
+
+	sim.HttpRead( data, size );
+
+	return 0;
+}
@@ -0,0 +1,24 @@
+/** SIM900 Basic communication library for SIM900 gsm module.
+ *
+ *	Fuzz target: a +RECEIVE line and its data through ReceiveSocketData.
+ *
+ *	Released under MIT license.
+ *
+ */
+#include "ReplayStream.h"
+
+#include <stdlib.h>
+
+
+extern "C" int LLVMFuzzerTestOneInput(	const uint8_t * data,
+										size_t size )
+{
+	static ReplayStream stream;
+	static ReplayConnection sim( stream );
+
+	// The data given to the callback was in the input
+	if ( sim.SocketReceive( data, size ) > size )
+		abort();
+
+	return 0;
+}